@@ -0,0 +1,332 @@
+// Benchmark of the extension against stand-in maya, MtoA, arnold and python libraries (see bench/standin)
+//   runs without any license nor maya session, the stand-ins only mimic what the extension relies on
+//   so absolute timings are lower bounds, use them to compare changes to the extension itself
+//
+//   scriptedTranslatorsBench [nodes] [motionSteps] [instances] [repeat]
+//
+// Stages measured on each run:
+//   register: initializeExtension (RegisterTranslators) then the MtoA node initializers (NodeInitializer,
+//             SetupAttrs declarations parsed through StringToValue and the node entry attribute helpers)
+//   parse:    StringToValue on typical SetupAttrs default values
+//   export:   nodes shapes with instances extra instances each, exported by the scripted shape translator at each
+//             of the motionSteps steps as an MtoA session does (RunScripts, plug reads, AiNode* setters, python calls)
+#include "standin.h"
+#include "plugin.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+
+extern "C"
+{
+   void initializeExtension(CExtension &extension);
+   void deinitializeExtension(CExtension &extension);
+}
+
+static unsigned long gNumAllocs = 0;
+
+void* operator new(size_t size)
+{
+   ++gNumAllocs;
+   void *ptr = malloc(size > 0 ? size : 1);
+   if (!ptr)
+   {
+      throw std::bad_alloc();
+   }
+   return ptr;
+}
+
+void operator delete(void *ptr) throw()
+{
+   free(ptr);
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete[](void *ptr) throw()
+{
+   operator delete(ptr);
+}
+
+static double GetTime()
+{
+#ifdef _WIN32
+   LARGE_INTEGER f, c;
+   QueryPerformanceFrequency(&f);
+   QueryPerformanceCounter(&c);
+   return (double) c.QuadPart / (double) f.QuadPart;
+#else
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return (double) tv.tv_sec + 0.000001 * (double) tv.tv_usec;
+#endif
+}
+
+static void SetEnv(const char *name, const char *value)
+{
+#ifdef _WIN32
+   _putenv_s(name, value);
+#else
+   setenv(name, value, 1);
+#endif
+}
+
+static const char *gNodeType = "benchShape";
+
+// Stand-in translator module: Export, ExportInstance (instances exported as fast ginstance), SetupAttrs, Cleanup
+//   with transform matrices prefetched for all motion steps
+static void AddModule()
+{
+   CStandinModule module;
+
+   module.funcs[PYFUNC_EXPORT_INSTANCE] = true;
+   module.funcs[PYFUNC_SETUP_ATTRS] = true;
+   module.funcs[PYFUNC_CLEANUP] = true;
+   module.caps[PYCAP_SUPPORT_INSTANCES] = true;
+   module.caps[PYCAP_PREFETCH_MOTION_MATRICES] = true;
+   module.caps[PYCAP_FAST_INSTANCES] = true;
+   module.numUserParams = 2;
+
+   // type|arnoldNode|arnoldAttr|name|shortName|isArray|default|min|max|softMin|softMax|keyable|enums
+   module.attrDecls.push_back("4|||benchScale|bsc|0|1|0|100|0|10|1|");
+   module.attrDecls.push_back("10|||benchTag|btg|0|bench||||||0|");
+   module.attrDecls.push_back("5|||benchColor|bcl|0|0.5,0.5,0.5||||||1|");
+   module.attrDecls.push_back("4|||benchWeights|bwt|1|0.25;0.5;0.75;1||||||1|");
+   module.attrDecls.push_back("0|procedural|step_size||||||||||");
+   module.attrRecords.push_back("1|||benchCount|bco|0|4|0|1000|1|16|1|");
+   module.attrRecords.push_back("3|||benchEnabled|ben|0|1||||||1|");
+
+   StandinAddModule("mtoa_benchShape", module);
+}
+
+// Shape attributes the shape translator reads (MtoA and maya ones), others are added by NodeInitializer
+static void AddNodeTypes()
+{
+   static const char* shapeAttrs[] =
+   {
+      "castsShadows", "receiveShadows", "primaryVisibility", "visibleInReflections", "visibleInRefractions",
+      "doubleSided", "smoothShading", "motionBlur", NULL
+   };
+
+   StandinAddNodeType("transform", MFn::kTransform);
+   StandinAddNodeType(gNodeType, MFn::kPluginShape);
+   StandinAddNodeType("shadingEngine", MFn::kShadingEngine);
+   StandinAddNodeType("lambert", MFn::kLambert, "drawdb/shader/surface/lambert:shader/surface");
+   StandinAddNodeType("renderLayer", MFn::kRenderLayer);
+
+   for (int i=0; shapeAttrs[i]; ++i)
+   {
+      StandinAddAttribute(gNodeType, shapeAttrs[i], shapeAttrs[i], STANDIN_ATTR_NUMERIC, false, 1.0);
+   }
+   StandinAddAttribute(gNodeType, "opposite", "op", STANDIN_ATTR_NUMERIC, false, 0.0);
+}
+
+// Each shape is parented under 1 + numInstances transforms, all shapes share a shading engine
+static void BuildScene(int numNodes, int numInstances, std::vector<MDagPath> &paths)
+{
+   char name[64];
+   int member = 0;
+
+   StandinCreateNode("renderLayer", "defaultRenderLayer");
+
+   MObject shader = StandinCreateNode("lambert", "benchLambert");
+   MObject shadingEngine = StandinCreateNode("shadingEngine", "benchSG");
+   StandinConnect(shader, "message", -1, shadingEngine, "surfaceShader", -1);
+
+   std::vector<MDagPath> shapePaths;
+
+   for (int n=0; n<numNodes; ++n)
+   {
+      sprintf(name, "%sShape%d", gNodeType, n);
+
+      MObject shape = StandinCreateNode(gNodeType, name);
+
+      for (int i=0; i<=numInstances; ++i)
+      {
+         sprintf(name, "%s%d_%d", gNodeType, n, i);
+
+         MObject xform = StandinCreateNode("transform", name);
+         StandinSetValue(xform, "translate", (double) n);
+         StandinSetValue(xform, "velocity", 0.1 * (i + 1));
+         StandinAddParent(shape, xform);
+
+         StandinConnect(shape, "instObjGroups", i, shadingEngine, "dagSetMembers", member++);
+      }
+
+      StandinSetBoundingBox(shape, MBoundingBox(MPoint(-1.0, -1.0, -1.0), MPoint(1.0, 1.0, 1.0)));
+
+      StandinGetAllPaths(shape, shapePaths);
+      paths.insert(paths.end(), shapePaths.begin(), shapePaths.end());
+   }
+}
+
+struct CStageStats
+{
+   unsigned long count;
+   double elapsed;
+   unsigned long allocs;
+   unsigned long pythonCalls;
+};
+
+static void StartStage(CStageStats &stats)
+{
+   StandinGetPythonCalls(true);
+   StandinGetDisplayedMessages(true);
+   stats.count = 0;
+   stats.allocs = gNumAllocs;
+   stats.elapsed = GetTime();
+}
+
+static void EndStage(CStageStats &stats)
+{
+   stats.elapsed = GetTime() - stats.elapsed;
+   stats.allocs = gNumAllocs - stats.allocs;
+   stats.pythonCalls = StandinGetPythonCalls(true);
+}
+
+static void PrintStage(int run, const char *stage, const char *unit, const CStageStats &stats)
+{
+   printf("run %d %-8s: %lu %s in %f s (%.0f %s/s), %lu allocation(s), %lu python call(s)\n",
+          run, stage, stats.count, unit, stats.elapsed, (stats.elapsed > 0.0 ? stats.count / stats.elapsed : 0.0),
+          unit, stats.allocs, stats.pythonCalls);
+}
+
+// Typical SetupAttrs default values
+struct CValueSample
+{
+   int type;
+   bool isArray;
+   const char *value;
+};
+
+static const CValueSample gValueSamples[] =
+{
+   {AI_TYPE_FLOAT, false, "0.5"},
+   {AI_TYPE_INT, false, "12"},
+   {AI_TYPE_BOOLEAN, false, "1"},
+   {AI_TYPE_BYTE, false, "255"},
+   {AI_TYPE_RGB, false, "0.1,0.2,0.3"},
+   {AI_TYPE_VECTOR, false, "0,1,0"},
+   {AI_TYPE_STRING, false, "benchTag"},
+   {AI_TYPE_MATRIX, false, "1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1"},
+   {AI_TYPE_FLOAT, true, "0.25;0.5;0.75;1"},
+   {AI_TYPE_STRING, true, "a;b;c"}
+};
+
+int main(int argc, char **argv)
+{
+   int numNodes = (argc > 1 ? atoi(argv[1]) : 1000);
+   int numSteps = (argc > 2 ? atoi(argv[2]) : 3);
+   int numInstances = (argc > 3 ? atoi(argv[3]) : 2);
+   int repeat = (argc > 4 ? atoi(argv[4]) : 3);
+
+   if (numNodes <= 0 || numSteps <= 0 || numInstances < 0 || repeat <= 0)
+   {
+      fprintf(stderr, "Usage: %s [nodes] [motionSteps] [instances] [repeat]\n", argv[0]);
+      return 1;
+   }
+
+   AiBegin();
+   AiMsgSetConsoleFlags(AI_LOG_NONE);
+
+   SetEnv("MTOA_SCRIPTED_TRANSLATORS", gNodeType);
+
+   AddModule();
+   AddNodeTypes();
+   StandinLoadPlugin(gNodeType);
+
+   std::vector<MDagPath> paths;
+
+   BuildScene(numNodes, numInstances, paths);
+
+   const size_t numSamples = sizeof(gValueSamples) / sizeof(CValueSample);
+   unsigned long numParses = (unsigned long) numNodes * 10;
+   unsigned int failures = 0;
+
+   for (int r=0; r<repeat; ++r)
+   {
+      CStageStats stats;
+      CExtension extension("scriptedTranslators");
+
+      StartStage(stats);
+      initializeExtension(extension);
+      stats.count = extension.InitializeTranslators();
+      EndStage(stats);
+      PrintStage(r, "register", "translator(s)", stats);
+
+      if (stats.count == 0)
+      {
+         fprintf(stderr, "No translator registered\n");
+         return 1;
+      }
+
+      StartStage(stats);
+      for (unsigned long i=0; i<numParses; ++i)
+      {
+         const CValueSample &sample = gValueSamples[i % numSamples];
+         CAttrData data;
+         AtParamValue value;
+
+         data.type = sample.type;
+         data.isArray = sample.isArray;
+
+         if (StringToValue(sample.value, data, &value))
+         {
+            DestroyValue(data, &value);
+         }
+         else
+         {
+            ++failures;
+         }
+         ++stats.count;
+      }
+      EndStage(stats);
+      PrintStage(r, "parse", "value(s)", stats);
+
+      CStandinSession session;
+
+      session.SetExtension(&extension);
+      session.SetFrame(1.0 + r);
+      session.SetMotionBlur((unsigned int) numSteps, 0.5);
+
+      StartStage(stats);
+      stats.count = session.Export(paths);
+      EndStage(stats);
+      PrintStage(r, "export", "shape(s)", stats);
+
+      printf("run %d %-8s: %u arnold node(s), %lu sample(s) exported, %lu maya message(s)\n",
+             r, "", session.GetNumArnoldNodes(), stats.count * (unsigned long) numSteps,
+             StandinGetDisplayedMessages());
+
+      if (stats.count != paths.size())
+      {
+         ++failures;
+      }
+
+      session.Clear();
+
+      deinitializeExtension(extension);
+   }
+
+   StandinNewScene();
+   StandinClearModules();
+
+   AiEnd();
+
+   if (failures > 0)
+   {
+      fprintf(stderr, "%u failure(s)\n", failures);
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,253 @@
+#ifndef __standin_ai_h__
+#define __standin_ai_h__
+
+// Stand-in for the subset of the arnold 4 API used by the extension (benchmark only)
+//   nodes are plain parameter containers, nothing is rendered
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef unsigned char AtByte;
+typedef unsigned int AtUInt32;
+
+struct AtNode;
+struct AtNodeEntry;
+struct AtParamEntry;
+struct AtUserParamEntry;
+struct AtParamIterator;
+
+struct AtPoint
+{
+   float x, y, z;
+};
+typedef AtPoint AtVector;
+
+struct AtPoint2
+{
+   float x, y;
+};
+
+struct AtColor
+{
+   float r, g, b;
+};
+typedef AtColor AtRGB;
+
+struct AtRGBA
+{
+   float r, g, b, a;
+};
+
+typedef float AtMatrix[4][4];
+
+struct AtArray
+{
+   void *data;
+   AtUInt32 nelements;
+   AtByte nkeys;
+   AtByte type;
+};
+
+union AtParamValue
+{
+   AtByte BYTE;
+   int INT;
+   unsigned int UINT;
+   bool BOOL;
+   float FLT;
+   AtRGB RGB;
+   AtRGBA RGBA;
+   AtVector VEC;
+   AtPoint PNT;
+   AtPoint2 PNT2;
+   const char *STR;
+   void *PTR;
+   AtArray *ARRAY;
+   AtMatrix *pMTX;
+};
+
+#define AI_TYPE_BYTE        0x00
+#define AI_TYPE_INT         0x01
+#define AI_TYPE_UINT        0x02
+#define AI_TYPE_BOOLEAN     0x03
+#define AI_TYPE_FLOAT       0x04
+#define AI_TYPE_RGB         0x05
+#define AI_TYPE_RGBA        0x06
+#define AI_TYPE_VECTOR      0x07
+#define AI_TYPE_POINT       0x08
+#define AI_TYPE_POINT2      0x09
+#define AI_TYPE_STRING      0x0A
+#define AI_TYPE_POINTER     0x0B
+#define AI_TYPE_NODE        0x0C
+#define AI_TYPE_ARRAY       0x0D
+#define AI_TYPE_MATRIX      0x0E
+#define AI_TYPE_ENUM        0x0F
+#define AI_TYPE_UNDEFINED   0xFF
+#define AI_TYPE_NONE        0xFF
+
+#define AI_NODE_UNDEFINED   0x0000
+#define AI_NODE_OPTIONS     0x0001
+#define AI_NODE_CAMERA      0x0002
+#define AI_NODE_LIGHT       0x0004
+#define AI_NODE_SHAPE       0x0008
+#define AI_NODE_SHADER      0x0010
+
+#define AI_USERDEF_UNDEFINED 0
+#define AI_USERDEF_CONSTANT  1
+#define AI_USERDEF_UNIFORM   2
+#define AI_USERDEF_VARYING   3
+#define AI_USERDEF_INDEXED   4
+
+#define AI_RAY_UNDEFINED    0x00
+#define AI_RAY_CAMERA       0x01
+#define AI_RAY_SHADOW       0x02
+#define AI_RAY_REFLECTED    0x04
+#define AI_RAY_REFRACTED    0x08
+#define AI_RAY_SUBSURFACE   0x10
+#define AI_RAY_DIFFUSE      0x20
+#define AI_RAY_GLOSSY       0x40
+#define AI_RAY_ALL          0xFF
+
+#define AI_LOG_NONE         0x0000
+#define AI_LOG_INFO         0x0001
+#define AI_LOG_WARNINGS     0x0002
+#define AI_LOG_ERRORS       0x0004
+#define AI_LOG_ALL          0xFFFF
+
+#define AI_EPSILON 1.0e-4f
+#define AI_BIG     1.0e12f
+
+#ifndef MAX
+#  define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#ifndef MIN
+#  define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#define AiV3Create(v, a, b, c) ((v).x = (a), (v).y = (b), (v).z = (c))
+
+// Messages
+
+void AiMsgSetConsoleFlags(int flags);
+void AiMsgSetLogFileFlags(int flags);
+void AiMsgInfo(const char *format, ...);
+void AiMsgWarning(const char *format, ...);
+void AiMsgError(const char *format, ...);
+
+// Universe
+
+void AiBegin();
+void AiEnd();
+bool AiUniverseIsActive();
+void AiLoadPlugins(const char *path);
+const char* AiGetVersion(char *arch, char *major, char *minor, char *fix);
+
+// Node entries
+
+const AtNodeEntry* AiNodeEntryLookUp(const char *name);
+const char* AiNodeEntryGetName(const AtNodeEntry *entry);
+int AiNodeEntryGetType(const AtNodeEntry *entry);
+const char* AiNodeEntryGetTypeName(const AtNodeEntry *entry);
+const AtParamEntry* AiNodeEntryLookUpParameter(const AtNodeEntry *entry, const char *param);
+AtParamIterator* AiNodeEntryGetParamIterator(const AtNodeEntry *entry);
+
+void AiParamIteratorDestroy(AtParamIterator *it);
+const AtParamEntry* AiParamIteratorGetNext(AtParamIterator *it);
+bool AiParamIteratorFinished(const AtParamIterator *it);
+
+const char* AiParamGetName(const AtParamEntry *pentry);
+int AiParamGetType(const AtParamEntry *pentry);
+const AtParamValue* AiParamGetDefault(const AtParamEntry *pentry);
+const char* AiParamGetTypeName(AtByte type);
+int AiParamGetTypeSize(AtByte type);
+
+int AiUserParamGetType(const AtUserParamEntry *upentry);
+int AiUserParamGetArrayType(const AtUserParamEntry *upentry);
+int AiUserParamGetCategory(const AtUserParamEntry *upentry);
+
+// Nodes
+
+AtNode* AiNode(const char *entryName);
+AtNode* AiNodeLookUpByName(const char *name);
+bool AiNodeDestroy(AtNode *node);
+const AtNodeEntry* AiNodeGetNodeEntry(const AtNode *node);
+const char* AiNodeGetName(const AtNode *node);
+bool AiNodeIs(const AtNode *node, const char *entryName);
+bool AiNodeDeclare(AtNode *node, const char *param, const char *declaration);
+const AtUserParamEntry* AiNodeLookUpUserParameter(const AtNode *node, const char *param);
+void AiNodeResetParameter(AtNode *node, const char *param);
+bool AiNodeIsLinked(const AtNode *node, const char *param);
+
+void AiNodeSetByte(AtNode *node, const char *param, AtByte val);
+void AiNodeSetInt(AtNode *node, const char *param, int val);
+void AiNodeSetUInt(AtNode *node, const char *param, unsigned int val);
+void AiNodeSetBool(AtNode *node, const char *param, bool val);
+void AiNodeSetFlt(AtNode *node, const char *param, float val);
+void AiNodeSetRGB(AtNode *node, const char *param, float r, float g, float b);
+void AiNodeSetRGBA(AtNode *node, const char *param, float r, float g, float b, float a);
+void AiNodeSetVec(AtNode *node, const char *param, float x, float y, float z);
+void AiNodeSetPnt(AtNode *node, const char *param, float x, float y, float z);
+void AiNodeSetPnt2(AtNode *node, const char *param, float x, float y);
+void AiNodeSetStr(AtNode *node, const char *param, const char *str);
+void AiNodeSetPtr(AtNode *node, const char *param, void *ptr);
+void AiNodeSetArray(AtNode *node, const char *param, AtArray *array);
+void AiNodeSetMatrix(AtNode *node, const char *param, AtMatrix matrix);
+
+AtByte AiNodeGetByte(const AtNode *node, const char *param);
+int AiNodeGetInt(const AtNode *node, const char *param);
+unsigned int AiNodeGetUInt(const AtNode *node, const char *param);
+bool AiNodeGetBool(const AtNode *node, const char *param);
+float AiNodeGetFlt(const AtNode *node, const char *param);
+AtRGB AiNodeGetRGB(const AtNode *node, const char *param);
+AtRGBA AiNodeGetRGBA(const AtNode *node, const char *param);
+AtVector AiNodeGetVec(const AtNode *node, const char *param);
+AtPoint AiNodeGetPnt(const AtNode *node, const char *param);
+AtPoint2 AiNodeGetPnt2(const AtNode *node, const char *param);
+const char* AiNodeGetStr(const AtNode *node, const char *param);
+void* AiNodeGetPtr(const AtNode *node, const char *param);
+AtArray* AiNodeGetArray(const AtNode *node, const char *param);
+void AiNodeGetMatrix(const AtNode *node, const char *param, AtMatrix matrix);
+
+// Arrays
+
+AtArray* AiArrayAllocate(AtUInt32 nelements, AtByte nkeys, AtByte type);
+AtArray* AiArrayConvert(AtUInt32 nelements, AtByte nkeys, AtByte type, const void *data);
+AtArray* AiArrayCopy(const AtArray *array);
+void AiArrayDestroy(AtArray *array);
+
+bool AiArraySetByte(AtArray *array, AtUInt32 i, AtByte val);
+bool AiArraySetInt(AtArray *array, AtUInt32 i, int val);
+bool AiArraySetUInt(AtArray *array, AtUInt32 i, unsigned int val);
+bool AiArraySetBool(AtArray *array, AtUInt32 i, bool val);
+bool AiArraySetFlt(AtArray *array, AtUInt32 i, float val);
+bool AiArraySetRGB(AtArray *array, AtUInt32 i, AtRGB val);
+bool AiArraySetRGBA(AtArray *array, AtUInt32 i, AtRGBA val);
+bool AiArraySetVec(AtArray *array, AtUInt32 i, AtVector val);
+bool AiArraySetPnt(AtArray *array, AtUInt32 i, AtPoint val);
+bool AiArraySetPnt2(AtArray *array, AtUInt32 i, AtPoint2 val);
+bool AiArraySetStr(AtArray *array, AtUInt32 i, const char *val);
+bool AiArraySetPtr(AtArray *array, AtUInt32 i, void *val);
+bool AiArraySetMtx(AtArray *array, AtUInt32 i, AtMatrix val);
+
+AtByte AiArrayGetByte(const AtArray *array, AtUInt32 i);
+int AiArrayGetInt(const AtArray *array, AtUInt32 i);
+unsigned int AiArrayGetUInt(const AtArray *array, AtUInt32 i);
+bool AiArrayGetBool(const AtArray *array, AtUInt32 i);
+float AiArrayGetFlt(const AtArray *array, AtUInt32 i);
+AtRGB AiArrayGetRGB(const AtArray *array, AtUInt32 i);
+AtRGBA AiArrayGetRGBA(const AtArray *array, AtUInt32 i);
+AtVector AiArrayGetVec(const AtArray *array, AtUInt32 i);
+AtPoint AiArrayGetPnt(const AtArray *array, AtUInt32 i);
+AtPoint2 AiArrayGetPnt2(const AtArray *array, AtUInt32 i);
+const char* AiArrayGetStr(const AtArray *array, AtUInt32 i);
+void* AiArrayGetPtr(const AtArray *array, AtUInt32 i);
+void AiArrayGetMtx(const AtArray *array, AtUInt32 i, AtMatrix val);
+
+// Math
+
+void AiM4Copy(AtMatrix dest, const AtMatrix src);
+void AiM4Identity(AtMatrix mat);
+
+#endif
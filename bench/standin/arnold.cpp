@@ -0,0 +1,1029 @@
+#include <ai.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Arnold stand-in: node entries are static parameter lists, nodes hold one value per parameter
+//   strings set on nodes or arrays are interned for the lifetime of the process
+
+struct AtParamEntry
+{
+   const char *name;
+   AtByte type;
+   // Element type for arrays
+   AtByte arrayType;
+   AtParamValue defaultValue;
+};
+
+struct AtNodeEntry
+{
+   const char *name;
+   int type;
+   std::vector<AtParamEntry> params;
+};
+
+struct AtUserParamEntry
+{
+   std::string name;
+   int type;
+   int arrayType;
+   int category;
+};
+
+struct AtParamIterator
+{
+   const AtNodeEntry *entry;
+   size_t next;
+};
+
+struct CNodeValue
+{
+   AtByte type;
+   AtParamValue value;
+   AtMatrix matrix;
+};
+
+struct CUserParam
+{
+   AtUserParamEntry entry;
+   CNodeValue value;
+};
+
+struct AtNode
+{
+   const AtNodeEntry *entry;
+   std::string name;
+   std::vector<CNodeValue> values;
+   std::vector<CUserParam*> userParams;
+};
+
+static bool gUniverseActive = false;
+static int gConsoleFlags = AI_LOG_ALL;
+static std::vector<AtNodeEntry*> gNodeEntries;
+static std::map<std::string, AtNode*> gNodesByName;
+static std::set<AtNode*> gNodes;
+static std::set<std::string> gStrings;
+static AtMatrix gIdentity = {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}};
+
+static const char* InternString(const char *str)
+{
+   if (!str)
+   {
+      return NULL;
+   }
+   return gStrings.insert(str).first->c_str();
+}
+
+static void PrintMessage(int flag, const char *prefix, const char *format, va_list args)
+{
+   if ((gConsoleFlags & flag) == 0)
+   {
+      return;
+   }
+   fprintf(stderr, "%s", prefix);
+   vfprintf(stderr, format, args);
+   fprintf(stderr, "\n");
+}
+
+void AiMsgSetConsoleFlags(int flags)
+{
+   gConsoleFlags = flags;
+}
+
+void AiMsgSetLogFileFlags(int)
+{
+}
+
+void AiMsgInfo(const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   PrintMessage(AI_LOG_INFO, "", format, args);
+   va_end(args);
+}
+
+void AiMsgWarning(const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   PrintMessage(AI_LOG_WARNINGS, "WARNING | ", format, args);
+   va_end(args);
+}
+
+void AiMsgError(const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   PrintMessage(AI_LOG_ERRORS, "ERROR | ", format, args);
+   va_end(args);
+}
+
+// Node entries
+
+static AtParamEntry MakeParam(const char *name, AtByte type, AtByte arrayType=AI_TYPE_NONE)
+{
+   AtParamEntry param;
+
+   param.name = name;
+   param.type = type;
+   param.arrayType = arrayType;
+   memset(&(param.defaultValue), 0, sizeof(AtParamValue));
+
+   if (type == AI_TYPE_MATRIX)
+   {
+      param.defaultValue.pMTX = &gIdentity;
+   }
+   else if (type == AI_TYPE_STRING)
+   {
+      param.defaultValue.STR = "";
+   }
+   else if (type == AI_TYPE_ARRAY)
+   {
+      // Element type of array parameters is known from their default value
+      param.defaultValue.ARRAY = AiArrayAllocate(0, 1, arrayType);
+   }
+
+   return param;
+}
+
+static AtParamEntry MakeByteParam(const char *name, AtByte value)
+{
+   AtParamEntry param = MakeParam(name, AI_TYPE_BYTE);
+   param.defaultValue.BYTE = value;
+   return param;
+}
+
+static AtParamEntry MakeBoolParam(const char *name, bool value)
+{
+   AtParamEntry param = MakeParam(name, AI_TYPE_BOOLEAN);
+   param.defaultValue.BOOL = value;
+   return param;
+}
+
+static AtParamEntry MakeFloatParam(const char *name, float value)
+{
+   AtParamEntry param = MakeParam(name, AI_TYPE_FLOAT);
+   param.defaultValue.FLT = value;
+   return param;
+}
+
+// Parameters common to all shapes
+static void AddShapeParams(AtNodeEntry *entry)
+{
+   entry->params.push_back(MakeParam("name", AI_TYPE_STRING));
+   entry->params.push_back(MakeParam("matrix", AI_TYPE_MATRIX));
+   entry->params.push_back(MakeByteParam("visibility", AI_RAY_ALL));
+   entry->params.push_back(MakeByteParam("sidedness", AI_RAY_ALL));
+   entry->params.push_back(MakeBoolParam("receive_shadows", true));
+   entry->params.push_back(MakeBoolParam("self_shadows", true));
+   entry->params.push_back(MakeBoolParam("invert_normals", false));
+   entry->params.push_back(MakeBoolParam("opaque", true));
+   entry->params.push_back(MakeBoolParam("matte", false));
+   entry->params.push_back(MakeParam("shader", AI_TYPE_NODE));
+   entry->params.push_back(MakeParam("trace_sets", AI_TYPE_ARRAY, AI_TYPE_STRING));
+   entry->params.push_back(MakeParam("sss_setname", AI_TYPE_STRING));
+   entry->params.push_back(MakeBoolParam("use_light_group", false));
+   entry->params.push_back(MakeParam("light_group", AI_TYPE_ARRAY, AI_TYPE_NODE));
+   entry->params.push_back(MakeBoolParam("use_shadow_group", false));
+   entry->params.push_back(MakeParam("shadow_group", AI_TYPE_ARRAY, AI_TYPE_NODE));
+}
+
+static void CreateNodeEntries()
+{
+   if (gNodeEntries.size() > 0)
+   {
+      return;
+   }
+
+   AtNodeEntry *entry = new AtNodeEntry();
+   entry->name = "procedural";
+   entry->type = AI_NODE_SHAPE;
+   AddShapeParams(entry);
+   entry->params.push_back(MakeParam("dso", AI_TYPE_STRING));
+   entry->params.push_back(MakeParam("data", AI_TYPE_STRING));
+   entry->params.push_back(MakeBoolParam("load_at_init", false));
+   entry->params.push_back(MakeParam("min", AI_TYPE_POINT));
+   entry->params.push_back(MakeParam("max", AI_TYPE_POINT));
+   entry->params.push_back(MakeFloatParam("step_size", 0.0f));
+   gNodeEntries.push_back(entry);
+
+   entry = new AtNodeEntry();
+   entry->name = "box";
+   entry->type = AI_NODE_SHAPE;
+   AddShapeParams(entry);
+   entry->params.push_back(MakeParam("min", AI_TYPE_POINT));
+   entry->params.push_back(MakeParam("max", AI_TYPE_POINT));
+   entry->params.push_back(MakeFloatParam("step_size", 0.0f));
+   gNodeEntries.push_back(entry);
+
+   entry = new AtNodeEntry();
+   entry->name = "ginstance";
+   entry->type = AI_NODE_SHAPE;
+   AddShapeParams(entry);
+   entry->params.push_back(MakeParam("node", AI_TYPE_NODE));
+   entry->params.push_back(MakeBoolParam("inherit_xform", true));
+   gNodeEntries.push_back(entry);
+
+   entry = new AtNodeEntry();
+   entry->name = "standard";
+   entry->type = AI_NODE_SHADER;
+   entry->params.push_back(MakeParam("name", AI_TYPE_STRING));
+   entry->params.push_back(MakeFloatParam("Kd", 0.7f));
+   entry->params.push_back(MakeParam("Kd_color", AI_TYPE_RGB));
+   gNodeEntries.push_back(entry);
+}
+
+void AiBegin()
+{
+   CreateNodeEntries();
+   gUniverseActive = true;
+}
+
+void AiEnd()
+{
+   std::set<AtNode*> nodes = gNodes;
+
+   for (std::set<AtNode*>::iterator it=nodes.begin(); it!=nodes.end(); ++it)
+   {
+      AiNodeDestroy(*it);
+   }
+
+   gNodesByName.clear();
+   gUniverseActive = false;
+}
+
+bool AiUniverseIsActive()
+{
+   return gUniverseActive;
+}
+
+void AiLoadPlugins(const char *)
+{
+}
+
+const char* AiGetVersion(char *arch, char *major, char *minor, char *fix)
+{
+   if (arch) strcpy(arch, "4");
+   if (major) strcpy(major, "2");
+   if (minor) strcpy(minor, "16");
+   if (fix) strcpy(fix, "0");
+   return "4.2.16.0";
+}
+
+const AtNodeEntry* AiNodeEntryLookUp(const char *name)
+{
+   if (!gUniverseActive || !name)
+   {
+      return NULL;
+   }
+
+   for (size_t i=0; i<gNodeEntries.size(); ++i)
+   {
+      if (!strcmp(gNodeEntries[i]->name, name))
+      {
+         return gNodeEntries[i];
+      }
+   }
+
+   return NULL;
+}
+
+const char* AiNodeEntryGetName(const AtNodeEntry *entry)
+{
+   return (entry ? entry->name : NULL);
+}
+
+int AiNodeEntryGetType(const AtNodeEntry *entry)
+{
+   return (entry ? entry->type : AI_NODE_UNDEFINED);
+}
+
+const char* AiNodeEntryGetTypeName(const AtNodeEntry *entry)
+{
+   switch (AiNodeEntryGetType(entry))
+   {
+   case AI_NODE_OPTIONS:
+      return "options";
+   case AI_NODE_CAMERA:
+      return "camera";
+   case AI_NODE_LIGHT:
+      return "light";
+   case AI_NODE_SHAPE:
+      return "shape";
+   case AI_NODE_SHADER:
+      return "shader";
+   default:
+      return "undefined";
+   }
+}
+
+static int FindParamIndex(const AtNodeEntry *entry, const char *param)
+{
+   if (!entry || !param)
+   {
+      return -1;
+   }
+
+   for (size_t i=0; i<entry->params.size(); ++i)
+   {
+      if (!strcmp(entry->params[i].name, param))
+      {
+         return (int) i;
+      }
+   }
+
+   return -1;
+}
+
+const AtParamEntry* AiNodeEntryLookUpParameter(const AtNodeEntry *entry, const char *param)
+{
+   int i = FindParamIndex(entry, param);
+   return (i >= 0 ? &(entry->params[i]) : NULL);
+}
+
+AtParamIterator* AiNodeEntryGetParamIterator(const AtNodeEntry *entry)
+{
+   AtParamIterator *it = new AtParamIterator();
+   it->entry = entry;
+   it->next = 0;
+   return it;
+}
+
+void AiParamIteratorDestroy(AtParamIterator *it)
+{
+   delete it;
+}
+
+const AtParamEntry* AiParamIteratorGetNext(AtParamIterator *it)
+{
+   if (AiParamIteratorFinished(it))
+   {
+      return NULL;
+   }
+   return &(it->entry->params[it->next++]);
+}
+
+bool AiParamIteratorFinished(const AtParamIterator *it)
+{
+   return (!it || !it->entry || it->next >= it->entry->params.size());
+}
+
+const char* AiParamGetName(const AtParamEntry *pentry)
+{
+   return (pentry ? pentry->name : NULL);
+}
+
+int AiParamGetType(const AtParamEntry *pentry)
+{
+   return (pentry ? pentry->type : AI_TYPE_UNDEFINED);
+}
+
+const AtParamValue* AiParamGetDefault(const AtParamEntry *pentry)
+{
+   return (pentry ? &(pentry->defaultValue) : NULL);
+}
+
+static const char* gTypeNames[] =
+{
+   "BYTE", "INT", "UINT", "BOOL", "FLOAT", "RGB", "RGBA", "VECTOR", "POINT", "POINT2",
+   "STRING", "POINTER", "NODE", "ARRAY", "MATRIX", "ENUM"
+};
+
+const char* AiParamGetTypeName(AtByte type)
+{
+   return (type <= AI_TYPE_ENUM ? gTypeNames[type] : "UNDEFINED");
+}
+
+int AiParamGetTypeSize(AtByte type)
+{
+   switch (type)
+   {
+   case AI_TYPE_BYTE:
+      return sizeof(AtByte);
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      return sizeof(int);
+   case AI_TYPE_UINT:
+      return sizeof(unsigned int);
+   case AI_TYPE_BOOLEAN:
+      return sizeof(bool);
+   case AI_TYPE_FLOAT:
+      return sizeof(float);
+   case AI_TYPE_RGB:
+      return sizeof(AtRGB);
+   case AI_TYPE_RGBA:
+      return sizeof(AtRGBA);
+   case AI_TYPE_VECTOR:
+   case AI_TYPE_POINT:
+      return sizeof(AtPoint);
+   case AI_TYPE_POINT2:
+      return sizeof(AtPoint2);
+   case AI_TYPE_STRING:
+      return sizeof(const char*);
+   case AI_TYPE_POINTER:
+   case AI_TYPE_NODE:
+      return sizeof(void*);
+   case AI_TYPE_ARRAY:
+      return sizeof(AtArray*);
+   case AI_TYPE_MATRIX:
+      return sizeof(AtMatrix);
+   default:
+      return 0;
+   }
+}
+
+int AiUserParamGetType(const AtUserParamEntry *upentry)
+{
+   return (upentry ? upentry->type : AI_TYPE_UNDEFINED);
+}
+
+int AiUserParamGetArrayType(const AtUserParamEntry *upentry)
+{
+   return (upentry ? upentry->arrayType : AI_TYPE_UNDEFINED);
+}
+
+int AiUserParamGetCategory(const AtUserParamEntry *upentry)
+{
+   return (upentry ? upentry->category : AI_USERDEF_UNDEFINED);
+}
+
+// Nodes
+
+static void ReleaseValue(CNodeValue &value)
+{
+   if (value.type == AI_TYPE_ARRAY && value.value.ARRAY)
+   {
+      AiArrayDestroy(value.value.ARRAY);
+   }
+   value.value.ARRAY = NULL;
+}
+
+static void ResetValue(CNodeValue &value, const AtParamEntry &param)
+{
+   ReleaseValue(value);
+   value.type = param.type;
+   value.value = param.defaultValue;
+
+   if (param.type == AI_TYPE_MATRIX)
+   {
+      AiM4Copy(value.matrix, *(param.defaultValue.pMTX));
+   }
+   else if (param.type == AI_TYPE_ARRAY)
+   {
+      value.value.ARRAY = AiArrayCopy(param.defaultValue.ARRAY);
+   }
+}
+
+AtNode* AiNode(const char *entryName)
+{
+   const AtNodeEntry *entry = AiNodeEntryLookUp(entryName);
+
+   if (!entry)
+   {
+      AiMsgError("[arnold standin] Unknown node entry \"%s\".", entryName ? entryName : "");
+      return NULL;
+   }
+
+   AtNode *node = new AtNode();
+
+   node->entry = entry;
+   node->values.resize(entry->params.size());
+
+   for (size_t i=0; i<entry->params.size(); ++i)
+   {
+      node->values[i].type = AI_TYPE_UNDEFINED;
+      node->values[i].value.ARRAY = NULL;
+      ResetValue(node->values[i], entry->params[i]);
+   }
+
+   gNodes.insert(node);
+
+   return node;
+}
+
+AtNode* AiNodeLookUpByName(const char *name)
+{
+   std::map<std::string, AtNode*>::iterator it = gNodesByName.find(name ? name : "");
+   return (it != gNodesByName.end() ? it->second : NULL);
+}
+
+bool AiNodeDestroy(AtNode *node)
+{
+   if (!node || gNodes.erase(node) == 0)
+   {
+      return false;
+   }
+
+   std::map<std::string, AtNode*>::iterator it = gNodesByName.find(node->name);
+   if (it != gNodesByName.end() && it->second == node)
+   {
+      gNodesByName.erase(it);
+   }
+
+   for (size_t i=0; i<node->values.size(); ++i)
+   {
+      ReleaseValue(node->values[i]);
+   }
+   for (size_t i=0; i<node->userParams.size(); ++i)
+   {
+      ReleaseValue(node->userParams[i]->value);
+      delete node->userParams[i];
+   }
+
+   delete node;
+
+   return true;
+}
+
+const AtNodeEntry* AiNodeGetNodeEntry(const AtNode *node)
+{
+   return (node ? node->entry : NULL);
+}
+
+const char* AiNodeGetName(const AtNode *node)
+{
+   return (node ? node->name.c_str() : NULL);
+}
+
+bool AiNodeIs(const AtNode *node, const char *entryName)
+{
+   return (node && entryName && !strcmp(node->entry->name, entryName));
+}
+
+static CUserParam* FindUserParam(const AtNode *node, const char *param)
+{
+   if (!node || !param)
+   {
+      return NULL;
+   }
+
+   for (size_t i=0; i<node->userParams.size(); ++i)
+   {
+      if (node->userParams[i]->entry.name == param)
+      {
+         return node->userParams[i];
+      }
+   }
+
+   return NULL;
+}
+
+static int TypeFromName(const char *name, size_t len)
+{
+   static const char *aliases[] = {"BOOLEAN", "VEC", "PNT", "PNT2", "STR", "PTR", NULL};
+   static const int aliasTypes[] = {AI_TYPE_BOOLEAN, AI_TYPE_VECTOR, AI_TYPE_POINT, AI_TYPE_POINT2, AI_TYPE_STRING, AI_TYPE_POINTER};
+
+   for (int i=0; i<=AI_TYPE_ENUM; ++i)
+   {
+      if (strlen(gTypeNames[i]) == len && !strncmp(gTypeNames[i], name, len))
+      {
+         return i;
+      }
+   }
+   for (int i=0; aliases[i]; ++i)
+   {
+      if (strlen(aliases[i]) == len && !strncmp(aliases[i], name, len))
+      {
+         return aliasTypes[i];
+      }
+   }
+
+   return AI_TYPE_UNDEFINED;
+}
+
+// "<constant|uniform|varying|indexed> [ARRAY] <TYPE>"
+bool AiNodeDeclare(AtNode *node, const char *param, const char *declaration)
+{
+   if (!node || !param || !declaration || FindParamIndex(node->entry, param) >= 0 || FindUserParam(node, param))
+   {
+      return false;
+   }
+
+   static const char *categories[] = {"constant", "uniform", "varying", "indexed", NULL};
+   std::vector<std::pair<const char*, size_t> > tokens;
+   const char *p = declaration;
+
+   while (*p)
+   {
+      while (*p == ' ')
+      {
+         ++p;
+      }
+      const char *e = p;
+      while (*e && *e != ' ')
+      {
+         ++e;
+      }
+      if (e > p)
+      {
+         tokens.push_back(std::make_pair(p, (size_t) (e - p)));
+      }
+      p = e;
+   }
+
+   if (tokens.size() < 2 || tokens.size() > 3)
+   {
+      return false;
+   }
+
+   int category = AI_USERDEF_UNDEFINED;
+
+   for (int i=0; categories[i]; ++i)
+   {
+      if (strlen(categories[i]) == tokens[0].second && !strncmp(categories[i], tokens[0].first, tokens[0].second))
+      {
+         category = AI_USERDEF_CONSTANT + i;
+      }
+   }
+
+   int type = TypeFromName(tokens.back().first, tokens.back().second);
+   bool isArray = (tokens.size() == 3);
+
+   if (category == AI_USERDEF_UNDEFINED || type == AI_TYPE_UNDEFINED ||
+       (isArray && TypeFromName(tokens[1].first, tokens[1].second) != AI_TYPE_ARRAY))
+   {
+      return false;
+   }
+
+   CUserParam *up = new CUserParam();
+
+   up->entry.name = param;
+   up->entry.category = category;
+   up->entry.type = (isArray || category != AI_USERDEF_CONSTANT ? AI_TYPE_ARRAY : type);
+   up->entry.arrayType = (up->entry.type == AI_TYPE_ARRAY ? type : AI_TYPE_UNDEFINED);
+
+   AtParamEntry pentry = MakeParam(param, (AtByte) up->entry.type, (AtByte) up->entry.arrayType);
+   up->value.type = AI_TYPE_UNDEFINED;
+   up->value.value.ARRAY = NULL;
+   ResetValue(up->value, pentry);
+
+   if (pentry.type == AI_TYPE_ARRAY)
+   {
+      AiArrayDestroy(pentry.defaultValue.ARRAY);
+   }
+
+   node->userParams.push_back(up);
+
+   return true;
+}
+
+const AtUserParamEntry* AiNodeLookUpUserParameter(const AtNode *node, const char *param)
+{
+   CUserParam *up = FindUserParam(node, param);
+   return (up ? &(up->entry) : NULL);
+}
+
+void AiNodeResetParameter(AtNode *node, const char *param)
+{
+   int i = FindParamIndex(node ? node->entry : NULL, param);
+
+   if (i >= 0)
+   {
+      ResetValue(node->values[i], node->entry->params[i]);
+      return;
+   }
+
+   for (size_t u=0; node && u<node->userParams.size(); ++u)
+   {
+      if (node->userParams[u]->entry.name == param)
+      {
+         ReleaseValue(node->userParams[u]->value);
+         delete node->userParams[u];
+         node->userParams.erase(node->userParams.begin() + u);
+         return;
+      }
+   }
+}
+
+bool AiNodeIsLinked(const AtNode *, const char *)
+{
+   return false;
+}
+
+static CNodeValue* FindValue(const AtNode *node, const char *param)
+{
+   int i = FindParamIndex(node ? node->entry : NULL, param);
+
+   if (i >= 0)
+   {
+      return const_cast<CNodeValue*>(&(node->values[i]));
+   }
+
+   CUserParam *up = FindUserParam(node, param);
+
+   if (!up)
+   {
+      AiMsgWarning("[arnold standin] %s: parameter \"%s\" not found.", (node ? node->name.c_str() : ""), (param ? param : ""));
+      return NULL;
+   }
+
+   return &(up->value);
+}
+
+static void SetName(AtNode *node, const char *name)
+{
+   std::map<std::string, AtNode*>::iterator it = gNodesByName.find(node->name);
+   if (it != gNodesByName.end() && it->second == node)
+   {
+      gNodesByName.erase(it);
+   }
+   node->name = (name ? name : "");
+   gNodesByName[node->name] = node;
+}
+
+// Values are stored with the setter type, getters convert between numeric types
+#define STANDIN_SET_VALUE(node, param, valueType, field, val) \
+   CNodeValue *v = FindValue(node, param); \
+   if (!v) return; \
+   ReleaseValue(*v); \
+   v->type = valueType; \
+   v->value.field = val
+
+void AiNodeSetByte(AtNode *node, const char *param, AtByte val) { STANDIN_SET_VALUE(node, param, AI_TYPE_BYTE, BYTE, val); }
+void AiNodeSetInt(AtNode *node, const char *param, int val) { STANDIN_SET_VALUE(node, param, AI_TYPE_INT, INT, val); }
+void AiNodeSetUInt(AtNode *node, const char *param, unsigned int val) { STANDIN_SET_VALUE(node, param, AI_TYPE_UINT, UINT, val); }
+void AiNodeSetBool(AtNode *node, const char *param, bool val) { STANDIN_SET_VALUE(node, param, AI_TYPE_BOOLEAN, BOOL, val); }
+void AiNodeSetFlt(AtNode *node, const char *param, float val) { STANDIN_SET_VALUE(node, param, AI_TYPE_FLOAT, FLT, val); }
+void AiNodeSetPtr(AtNode *node, const char *param, void *val) { STANDIN_SET_VALUE(node, param, AI_TYPE_POINTER, PTR, val); }
+void AiNodeSetArray(AtNode *node, const char *param, AtArray *val) { STANDIN_SET_VALUE(node, param, AI_TYPE_ARRAY, ARRAY, val); }
+
+void AiNodeSetRGB(AtNode *node, const char *param, float r, float g, float b)
+{
+   AtRGB c = {r, g, b};
+   STANDIN_SET_VALUE(node, param, AI_TYPE_RGB, RGB, c);
+}
+
+void AiNodeSetRGBA(AtNode *node, const char *param, float r, float g, float b, float a)
+{
+   AtRGBA c = {r, g, b, a};
+   STANDIN_SET_VALUE(node, param, AI_TYPE_RGBA, RGBA, c);
+}
+
+void AiNodeSetVec(AtNode *node, const char *param, float x, float y, float z)
+{
+   AtVector p = {x, y, z};
+   STANDIN_SET_VALUE(node, param, AI_TYPE_VECTOR, VEC, p);
+}
+
+void AiNodeSetPnt(AtNode *node, const char *param, float x, float y, float z)
+{
+   AtPoint p = {x, y, z};
+   STANDIN_SET_VALUE(node, param, AI_TYPE_POINT, PNT, p);
+}
+
+void AiNodeSetPnt2(AtNode *node, const char *param, float x, float y)
+{
+   AtPoint2 p = {x, y};
+   STANDIN_SET_VALUE(node, param, AI_TYPE_POINT2, PNT2, p);
+}
+
+void AiNodeSetStr(AtNode *node, const char *param, const char *str)
+{
+   if (node && param && !strcmp(param, "name"))
+   {
+      SetName(node, str);
+   }
+   STANDIN_SET_VALUE(node, param, AI_TYPE_STRING, STR, InternString(str));
+}
+
+void AiNodeSetMatrix(AtNode *node, const char *param, AtMatrix matrix)
+{
+   CNodeValue *v = FindValue(node, param);
+   if (!v)
+   {
+      return;
+   }
+   ReleaseValue(*v);
+   v->type = AI_TYPE_MATRIX;
+   AiM4Copy(v->matrix, matrix);
+   v->value.pMTX = &(v->matrix);
+}
+
+#undef STANDIN_SET_VALUE
+
+static double GetNumber(const CNodeValue *v)
+{
+   if (!v)
+   {
+      return 0.0;
+   }
+   switch (v->type)
+   {
+   case AI_TYPE_BYTE:
+      return v->value.BYTE;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      return v->value.INT;
+   case AI_TYPE_UINT:
+      return v->value.UINT;
+   case AI_TYPE_BOOLEAN:
+      return (v->value.BOOL ? 1.0 : 0.0);
+   case AI_TYPE_FLOAT:
+      return v->value.FLT;
+   default:
+      return 0.0;
+   }
+}
+
+AtByte AiNodeGetByte(const AtNode *node, const char *param) { return (AtByte) GetNumber(FindValue(node, param)); }
+int AiNodeGetInt(const AtNode *node, const char *param) { return (int) GetNumber(FindValue(node, param)); }
+unsigned int AiNodeGetUInt(const AtNode *node, const char *param) { return (unsigned int) GetNumber(FindValue(node, param)); }
+bool AiNodeGetBool(const AtNode *node, const char *param) { return (GetNumber(FindValue(node, param)) != 0.0); }
+float AiNodeGetFlt(const AtNode *node, const char *param) { return (float) GetNumber(FindValue(node, param)); }
+
+#define STANDIN_GET_VALUE(node, param, valueType, field, returnType) \
+   const CNodeValue *v = FindValue(node, param); \
+   returnType rv; \
+   memset(&rv, 0, sizeof(returnType)); \
+   if (v && v->type == valueType) rv = v->value.field; \
+   return rv
+
+AtRGB AiNodeGetRGB(const AtNode *node, const char *param) { STANDIN_GET_VALUE(node, param, AI_TYPE_RGB, RGB, AtRGB); }
+AtRGBA AiNodeGetRGBA(const AtNode *node, const char *param) { STANDIN_GET_VALUE(node, param, AI_TYPE_RGBA, RGBA, AtRGBA); }
+AtVector AiNodeGetVec(const AtNode *node, const char *param) { STANDIN_GET_VALUE(node, param, AI_TYPE_VECTOR, VEC, AtVector); }
+AtPoint AiNodeGetPnt(const AtNode *node, const char *param) { STANDIN_GET_VALUE(node, param, AI_TYPE_POINT, PNT, AtPoint); }
+AtPoint2 AiNodeGetPnt2(const AtNode *node, const char *param) { STANDIN_GET_VALUE(node, param, AI_TYPE_POINT2, PNT2, AtPoint2); }
+
+#undef STANDIN_GET_VALUE
+
+const char* AiNodeGetStr(const AtNode *node, const char *param)
+{
+   const CNodeValue *v = FindValue(node, param);
+   return ((v && v->type == AI_TYPE_STRING && v->value.STR) ? v->value.STR : "");
+}
+
+void* AiNodeGetPtr(const AtNode *node, const char *param)
+{
+   const CNodeValue *v = FindValue(node, param);
+   return ((v && (v->type == AI_TYPE_POINTER || v->type == AI_TYPE_NODE)) ? v->value.PTR : NULL);
+}
+
+AtArray* AiNodeGetArray(const AtNode *node, const char *param)
+{
+   const CNodeValue *v = FindValue(node, param);
+   return ((v && v->type == AI_TYPE_ARRAY) ? v->value.ARRAY : NULL);
+}
+
+void AiNodeGetMatrix(const AtNode *node, const char *param, AtMatrix matrix)
+{
+   const CNodeValue *v = FindValue(node, param);
+
+   if (v && v->type == AI_TYPE_MATRIX)
+   {
+      AiM4Copy(matrix, v->matrix);
+   }
+   else if (v && v->type == AI_TYPE_ARRAY && v->value.ARRAY && v->value.ARRAY->type == AI_TYPE_MATRIX &&
+            v->value.ARRAY->nelements * v->value.ARRAY->nkeys > 0)
+   {
+      AiArrayGetMtx(v->value.ARRAY, 0, matrix);
+   }
+   else
+   {
+      AiM4Identity(matrix);
+   }
+}
+
+// Arrays
+
+AtArray* AiArrayAllocate(AtUInt32 nelements, AtByte nkeys, AtByte type)
+{
+   AtArray *array = new AtArray();
+   size_t size = (size_t) nelements * nkeys * AiParamGetTypeSize(type);
+
+   array->nelements = nelements;
+   array->nkeys = nkeys;
+   array->type = type;
+   array->data = (size > 0 ? calloc(1, size) : NULL);
+
+   return array;
+}
+
+AtArray* AiArrayConvert(AtUInt32 nelements, AtByte nkeys, AtByte type, const void *data)
+{
+   AtArray *array = AiArrayAllocate(nelements, nkeys, type);
+   size_t count = (size_t) nelements * nkeys;
+
+   if (type == AI_TYPE_STRING)
+   {
+      for (size_t i=0; i<count; ++i)
+      {
+         ((const char**) array->data)[i] = InternString(((const char* const*) data)[i]);
+      }
+   }
+   else if (array->data)
+   {
+      memcpy(array->data, data, count * AiParamGetTypeSize(type));
+   }
+
+   return array;
+}
+
+AtArray* AiArrayCopy(const AtArray *array)
+{
+   return (array ? AiArrayConvert(array->nelements, array->nkeys, array->type, array->data) : NULL);
+}
+
+void AiArrayDestroy(AtArray *array)
+{
+   if (array)
+   {
+      free(array->data);
+      delete array;
+   }
+}
+
+template <typename T>
+static bool SetElement(AtArray *array, AtUInt32 i, AtByte type, const T &val)
+{
+   if (!array || array->type != type || i >= array->nelements * array->nkeys)
+   {
+      return false;
+   }
+   ((T*) array->data)[i] = val;
+   return true;
+}
+
+template <typename T>
+static T GetElement(const AtArray *array, AtUInt32 i, AtByte type)
+{
+   T rv;
+
+   if (!array || array->type != type || i >= array->nelements * array->nkeys)
+   {
+      memset(&rv, 0, sizeof(T));
+      return rv;
+   }
+
+   return ((const T*) array->data)[i];
+}
+
+bool AiArraySetByte(AtArray *array, AtUInt32 i, AtByte val) { return SetElement(array, i, AI_TYPE_BYTE, val); }
+bool AiArraySetInt(AtArray *array, AtUInt32 i, int val) { return SetElement(array, i, (array && array->type == AI_TYPE_ENUM ? AI_TYPE_ENUM : AI_TYPE_INT), val); }
+bool AiArraySetUInt(AtArray *array, AtUInt32 i, unsigned int val) { return SetElement(array, i, AI_TYPE_UINT, val); }
+bool AiArraySetBool(AtArray *array, AtUInt32 i, bool val) { return SetElement(array, i, AI_TYPE_BOOLEAN, val); }
+bool AiArraySetFlt(AtArray *array, AtUInt32 i, float val) { return SetElement(array, i, AI_TYPE_FLOAT, val); }
+bool AiArraySetRGB(AtArray *array, AtUInt32 i, AtRGB val) { return SetElement(array, i, AI_TYPE_RGB, val); }
+bool AiArraySetRGBA(AtArray *array, AtUInt32 i, AtRGBA val) { return SetElement(array, i, AI_TYPE_RGBA, val); }
+bool AiArraySetVec(AtArray *array, AtUInt32 i, AtVector val) { return SetElement(array, i, AI_TYPE_VECTOR, val); }
+bool AiArraySetPnt(AtArray *array, AtUInt32 i, AtPoint val) { return SetElement(array, i, AI_TYPE_POINT, val); }
+bool AiArraySetPnt2(AtArray *array, AtUInt32 i, AtPoint2 val) { return SetElement(array, i, AI_TYPE_POINT2, val); }
+bool AiArraySetStr(AtArray *array, AtUInt32 i, const char *val) { return SetElement(array, i, AI_TYPE_STRING, InternString(val)); }
+
+bool AiArraySetPtr(AtArray *array, AtUInt32 i, void *val)
+{
+   return SetElement(array, i, (array && array->type == AI_TYPE_NODE ? AI_TYPE_NODE : AI_TYPE_POINTER), val);
+}
+
+bool AiArraySetMtx(AtArray *array, AtUInt32 i, AtMatrix val)
+{
+   if (!array || array->type != AI_TYPE_MATRIX || i >= array->nelements * array->nkeys)
+   {
+      return false;
+   }
+   AiM4Copy(((AtMatrix*) array->data)[i], val);
+   return true;
+}
+
+AtByte AiArrayGetByte(const AtArray *array, AtUInt32 i) { return GetElement<AtByte>(array, i, AI_TYPE_BYTE); }
+int AiArrayGetInt(const AtArray *array, AtUInt32 i) { return GetElement<int>(array, i, (array && array->type == AI_TYPE_ENUM ? AI_TYPE_ENUM : AI_TYPE_INT)); }
+unsigned int AiArrayGetUInt(const AtArray *array, AtUInt32 i) { return GetElement<unsigned int>(array, i, AI_TYPE_UINT); }
+bool AiArrayGetBool(const AtArray *array, AtUInt32 i) { return GetElement<bool>(array, i, AI_TYPE_BOOLEAN); }
+float AiArrayGetFlt(const AtArray *array, AtUInt32 i) { return GetElement<float>(array, i, AI_TYPE_FLOAT); }
+AtRGB AiArrayGetRGB(const AtArray *array, AtUInt32 i) { return GetElement<AtRGB>(array, i, AI_TYPE_RGB); }
+AtRGBA AiArrayGetRGBA(const AtArray *array, AtUInt32 i) { return GetElement<AtRGBA>(array, i, AI_TYPE_RGBA); }
+AtVector AiArrayGetVec(const AtArray *array, AtUInt32 i) { return GetElement<AtVector>(array, i, AI_TYPE_VECTOR); }
+AtPoint AiArrayGetPnt(const AtArray *array, AtUInt32 i) { return GetElement<AtPoint>(array, i, AI_TYPE_POINT); }
+AtPoint2 AiArrayGetPnt2(const AtArray *array, AtUInt32 i) { return GetElement<AtPoint2>(array, i, AI_TYPE_POINT2); }
+const char* AiArrayGetStr(const AtArray *array, AtUInt32 i) { return GetElement<const char*>(array, i, AI_TYPE_STRING); }
+
+void* AiArrayGetPtr(const AtArray *array, AtUInt32 i)
+{
+   return GetElement<void*>(array, i, (array && array->type == AI_TYPE_NODE ? AI_TYPE_NODE : AI_TYPE_POINTER));
+}
+
+void AiArrayGetMtx(const AtArray *array, AtUInt32 i, AtMatrix val)
+{
+   if (!array || array->type != AI_TYPE_MATRIX || i >= array->nelements * array->nkeys)
+   {
+      AiM4Identity(val);
+      return;
+   }
+   AiM4Copy(val, ((const AtMatrix*) array->data)[i]);
+}
+
+// Math
+
+void AiM4Copy(AtMatrix dest, const AtMatrix src)
+{
+   memmove(dest, src, sizeof(AtMatrix));
+}
+
+void AiM4Identity(AtMatrix mat)
+{
+   AiM4Copy(mat, gIdentity);
+}
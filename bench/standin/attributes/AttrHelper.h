@@ -0,0 +1,71 @@
+#ifndef __standin_mtoa_attrhelper_h__
+#define __standin_mtoa_attrhelper_h__
+
+// Stand-in for the MtoA attribute helpers (benchmark only)
+//   inputs are added to the stand-in maya node class as MtoA adds extension attributes
+
+#include <ai.h>
+#include <maya/MStandin.h>
+
+struct CAttrData
+{
+   CAttrData();
+
+   AtParamValue defaultValue;
+   AtParamValue min;
+   AtParamValue max;
+   AtParamValue softMin;
+   AtParamValue softMax;
+   MString name;
+   MString shortName;
+   MStringArray enums;
+   int type;
+   bool isArray;
+   bool keyable;
+   bool hasMin;
+   bool hasMax;
+   bool hasSoftMin;
+   bool hasSoftMax;
+   bool linkable;
+};
+
+class CBaseAttrHelper
+{
+public:
+
+   CBaseAttrHelper(const AtNodeEntry *nodeEntry=NULL, const MString &prefix="ai");
+   virtual ~CBaseAttrHelper();
+
+   virtual bool GetAttrData(const char *paramName, CAttrData &data);
+
+   void MakeInput(const char *paramName);
+   void MakeInput(CAttrData &data);
+
+protected:
+
+   virtual MStatus AddAttribute(CAttrData &data);
+
+protected:
+
+   const AtNodeEntry *m_nodeEntry;
+   MString m_prefix;
+};
+
+class CExtensionAttrHelper : public CBaseAttrHelper
+{
+public:
+
+   CExtensionAttrHelper(MString nodeType, const AtNodeEntry *nodeEntry=NULL, const MString &prefix="ai");
+   CExtensionAttrHelper(MString nodeType, const char *nodeEntryName, const MString &prefix="ai");
+   virtual ~CExtensionAttrHelper();
+
+protected:
+
+   virtual MStatus AddAttribute(CAttrData &data);
+
+protected:
+
+   MString m_nodeType;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef __standin_mtoa_extension_h__
+#define __standin_mtoa_extension_h__
+
+// Stand-in for the MtoA extension API (benchmark only)
+
+#include <ai.h>
+#include <maya/MStandin.h>
+#include "translators/NodeTranslator.h"
+#include "attributes/AttrHelper.h"
+#include <vector>
+
+#ifdef _WIN32
+#  define DLLEXPORT __declspec(dllexport)
+#else
+#  define DLLEXPORT __attribute__ ((visibility("default")))
+#endif
+
+struct CAbTranslator
+{
+   CAbTranslator();
+   CAbTranslator(const MString &translatorName, const MString &arnoldNodeName, const MString &mayaNodeName, const MString &providerName="");
+
+   MString name;
+   MString arnold;
+   MString maya;
+   MString provider;
+};
+
+typedef void* (*TCreatorFunction)();
+typedef void (*TNodeInitFunction)(CAbTranslator);
+
+class CExtension
+{
+public:
+
+   CExtension(const MString &extensionFile="");
+
+   MStatus RegisterTranslator(const MString &mayaTypeName, const MString &translatorName,
+                              TCreatorFunction creatorFunction, TNodeInitFunction nodeInitFunction=NULL);
+   MString GetExtensionFile() const;
+
+   // Stand-in only: MtoA calls the node initializers once the extension is initialized
+   unsigned int InitializeTranslators();
+   TCreatorFunction FindCreator(const MString &mayaTypeName) const;
+
+private:
+
+   struct CTranslatorEntry
+   {
+      MString mayaTypeName;
+      MString translatorName;
+      TCreatorFunction creator;
+      TNodeInitFunction nodeInit;
+   };
+
+   MString m_file;
+   std::vector<CTranslatorEntry> m_translators;
+};
+
+#endif
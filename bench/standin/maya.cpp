@@ -0,0 +1,2005 @@
+#include "standin.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <algorithm>
+
+// Maya stand-in: a small in-memory dependency graph
+//   node types hold the static attributes, nodes the dynamic ones and the values that were set
+//   nodes are never freed so that stale handles can still be checked for liveness
+
+struct CStandinAttribute
+{
+   std::string name;
+   std::string shortName;
+   StandinAttrType type;
+   bool isArray;
+   bool usedAsFilename;
+   bool dynamic;
+   double defaultValue;
+};
+
+struct CStandinType
+{
+   std::string name;
+   MFn::Type apiType;
+   std::string classification;
+   std::vector<CStandinAttribute*> attrs;
+};
+
+struct CStandinValue
+{
+   double number;
+   std::string str;
+};
+
+typedef std::pair<CStandinAttribute*, int> CStandinValueKey;
+
+struct CStandinNode
+{
+   std::string name;
+   CStandinType *type;
+   bool alive;
+   std::vector<CStandinAttribute*> attrs;
+   std::map<CStandinValueKey, CStandinValue> values;
+   std::vector<CStandinNode*> parents;
+   MBoundingBox bbox;
+   // Indices in gConnections of the connections from or to the node
+   std::vector<size_t> connections;
+};
+
+struct CStandinConnection
+{
+   MPlug src;
+   MPlug dst;
+};
+
+// Matrix data and plugin objects
+struct CStandinData
+{
+   int refs;
+   bool plugin;
+   MMatrix matrix;
+};
+
+struct CStandinCallback
+{
+   MCallbackId id;
+   int kind;
+   int msg;
+   std::string event;
+   void (*func)(void*);
+   void (*strsFunc)(const MStringArray&, void*);
+   void (*connFunc)(MPlug&, MPlug&, bool, void*);
+   void *clientData;
+};
+
+enum
+{
+   CALLBACK_SCENE = 0,
+   CALLBACK_EVENT,
+   CALLBACK_CONNECTION
+};
+
+static std::map<std::string, CStandinType*> gTypes;
+static std::vector<CStandinNode*> gNodes;
+static std::vector<CStandinNode*> gDeadNodes;
+static std::vector<CStandinConnection> gConnections;
+static std::vector<CStandinCallback> gCallbacks;
+static MCallbackId gNextCallbackId = 1;
+static std::set<std::string> gPlugins;
+static MTime gCurrentTime(1.0);
+static MDGContext gContext;
+static unsigned long gDisplayedMessages = 0;
+static MStringArray gCommandResult;
+
+struct CStandinAccess
+{
+   static MObject MakeNode(CStandinNode *node)
+   {
+      MObject obj;
+      if (node)
+      {
+         obj.m_kind = MObject::kNode;
+         obj.m_ptr = node;
+      }
+      return obj;
+   }
+
+   static MObject MakeAttr(CStandinAttribute *attr)
+   {
+      MObject obj;
+      if (attr)
+      {
+         obj.m_kind = MObject::kAttr;
+         obj.m_ptr = attr;
+      }
+      return obj;
+   }
+
+   // Takes ownership of data
+   static MObject MakeData(CStandinData *data)
+   {
+      MObject obj;
+      obj.m_kind = MObject::kData;
+      obj.m_ptr = data;
+      data->refs = 1;
+      return obj;
+   }
+
+   static CStandinNode* Node(const MObject &obj)
+   {
+      return (obj.m_kind == MObject::kNode ? (CStandinNode*) obj.m_ptr : NULL);
+   }
+
+   static CStandinAttribute* Attr(const MObject &obj)
+   {
+      return (obj.m_kind == MObject::kAttr ? (CStandinAttribute*) obj.m_ptr : NULL);
+   }
+
+   static CStandinData* Data(const MObject &obj)
+   {
+      return (obj.m_kind == MObject::kData ? (CStandinData*) obj.m_ptr : NULL);
+   }
+
+   static void Retain(const MObject &obj)
+   {
+      CStandinData *data = Data(obj);
+      if (data)
+      {
+         ++(data->refs);
+      }
+   }
+
+   static void Release(const MObject &obj)
+   {
+      CStandinData *data = Data(obj);
+      if (data && --(data->refs) == 0)
+      {
+         delete data;
+      }
+   }
+
+   static MPlug MakePlug(CStandinNode *node, CStandinAttribute *attr, int index)
+   {
+      MPlug plug;
+      plug.m_node = node;
+      plug.m_attr = attr;
+      plug.m_index = index;
+      return plug;
+   }
+
+   static CStandinNode* Node(const MPlug &plug) { return plug.m_node; }
+   static CStandinAttribute* Attr(const MPlug &plug) { return plug.m_attr; }
+   static int Index(const MPlug &plug) { return plug.m_index; }
+
+   static std::vector<CStandinNode*>& Nodes(MDagPath &path) { return path.m_nodes; }
+   static const std::vector<CStandinNode*>& Nodes(const MDagPath &path) { return path.m_nodes; }
+};
+
+static bool IsDagType(MFn::Type type)
+{
+   return (type == MFn::kDagNode || type == MFn::kTransform || type == MFn::kShape || type == MFn::kMesh ||
+           type == MFn::kCamera || type == MFn::kPluginShape);
+}
+
+static bool IsShapeType(MFn::Type type)
+{
+   return (type == MFn::kShape || type == MFn::kMesh || type == MFn::kCamera || type == MFn::kPluginShape);
+}
+
+static CStandinType* FindType(const std::string &typeName)
+{
+   std::map<std::string, CStandinType*>::iterator it = gTypes.find(typeName);
+   return (it != gTypes.end() ? it->second : NULL);
+}
+
+static CStandinAttribute* FindAttribute(const std::vector<CStandinAttribute*> &attrs, const std::string &name)
+{
+   for (size_t i=0; i<attrs.size(); ++i)
+   {
+      if (attrs[i]->name == name || attrs[i]->shortName == name)
+      {
+         return attrs[i];
+      }
+   }
+   return NULL;
+}
+
+static CStandinAttribute* FindAttribute(const CStandinNode *node, const std::string &name)
+{
+   CStandinAttribute *attr = FindAttribute(node->type->attrs, name);
+   return (attr ? attr : FindAttribute(node->attrs, name));
+}
+
+static CStandinAttribute* NewAttribute(const char *name, const char *shortName, StandinAttrType type,
+                                       bool isArray, double defaultValue, bool usedAsFilename, bool dynamic)
+{
+   CStandinAttribute *attr = new CStandinAttribute();
+
+   attr->name = name;
+   attr->shortName = (shortName && shortName[0] != '\0' ? shortName : name);
+   attr->type = type;
+   attr->isArray = isArray;
+   attr->usedAsFilename = usedAsFilename;
+   attr->dynamic = dynamic;
+   attr->defaultValue = defaultValue;
+
+   return attr;
+}
+
+static void CallSceneCallbacks(int msg)
+{
+   // Callbacks may remove themselves
+   std::vector<CStandinCallback> callbacks = gCallbacks;
+
+   for (size_t i=0; i<callbacks.size(); ++i)
+   {
+      if (callbacks[i].kind == CALLBACK_SCENE && callbacks[i].msg == msg && callbacks[i].func)
+      {
+         callbacks[i].func(callbacks[i].clientData);
+      }
+   }
+}
+
+static void CallSceneCallbacks(int msg, const MStringArray &strs)
+{
+   std::vector<CStandinCallback> callbacks = gCallbacks;
+
+   for (size_t i=0; i<callbacks.size(); ++i)
+   {
+      if (callbacks[i].kind == CALLBACK_SCENE && callbacks[i].msg == msg && callbacks[i].strsFunc)
+      {
+         callbacks[i].strsFunc(strs, callbacks[i].clientData);
+      }
+   }
+}
+
+static double GetEvalFrame(const MDGContext &context)
+{
+   MTime time;
+   return (context.getTime(time) == MS::kSuccess ? time.value() : gCurrentTime.value());
+}
+
+static double GetNumericValue(const CStandinNode *node, CStandinAttribute *attr, int index, const MDGContext &context);
+
+// Translation of a single DAG node along x at the given frame
+static double GetTranslation(const CStandinNode *node, double frame)
+{
+   CStandinAttribute *translate = FindAttribute(node, "translate");
+   CStandinAttribute *velocity = FindAttribute(node, "velocity");
+   MDGContext context = MDGContext(MTime(frame));
+
+   return ((translate ? GetNumericValue(node, translate, -1, context) : 0.0) +
+           (velocity ? frame * GetNumericValue(node, velocity, -1, context) : 0.0));
+}
+
+static MMatrix GetPathMatrix(const std::vector<CStandinNode*> &nodes, size_t count, double frame)
+{
+   MMatrix matrix;
+
+   for (size_t i=0; i<count && i<nodes.size(); ++i)
+   {
+      matrix.matrix[3][0] += GetTranslation(nodes[i], frame);
+   }
+
+   return matrix;
+}
+
+static void GetPathTo(CStandinNode *node, int parentIndex, std::vector<CStandinNode*> &nodes)
+{
+   nodes.clear();
+
+   while (node)
+   {
+      nodes.push_back(node);
+      if (node->parents.size() == 0)
+      {
+         break;
+      }
+      node = node->parents[(parentIndex >= 0 && parentIndex < (int) node->parents.size()) ? parentIndex : 0];
+      parentIndex = 0;
+   }
+
+   std::reverse(nodes.begin(), nodes.end());
+}
+
+static bool FindSource(const MPlug &dst, MPlug &src)
+{
+   CStandinNode *node = CStandinAccess::Node(dst);
+
+   for (size_t i=0; node && i<node->connections.size(); ++i)
+   {
+      const CStandinConnection &conn = gConnections[node->connections[i]];
+      if (conn.dst == dst)
+      {
+         src = conn.src;
+         return true;
+      }
+   }
+   return false;
+}
+
+static double GetNumericValue(const CStandinNode *node, CStandinAttribute *attr, int index, const MDGContext &context)
+{
+   MPlug src;
+
+   if (FindSource(CStandinAccess::MakePlug(const_cast<CStandinNode*>(node), attr, index), src))
+   {
+      return GetNumericValue(CStandinAccess::Node(src), CStandinAccess::Attr(src), CStandinAccess::Index(src), context);
+   }
+
+   if (attr->name == "time" && node->type->apiType == MFn::kTime)
+   {
+      return GetEvalFrame(context);
+   }
+
+   std::map<CStandinValueKey, CStandinValue>::const_iterator it = node->values.find(CStandinValueKey(attr, index));
+
+   return (it != node->values.end() ? it->second.number : attr->defaultValue);
+}
+
+static MObject GetMatrixValue(const CStandinNode *node, CStandinAttribute *attr, int index, const MDGContext &context)
+{
+   CStandinData *data = new CStandinData();
+
+   data->plugin = false;
+
+   if (attr->name == "worldMatrix" && IsDagType(node->type->apiType))
+   {
+      std::vector<CStandinNode*> nodes;
+      GetPathTo(const_cast<CStandinNode*>(node), index, nodes);
+      data->matrix = GetPathMatrix(nodes, nodes.size(), GetEvalFrame(context));
+   }
+
+   return CStandinAccess::MakeData(data);
+}
+
+// Scene control
+
+void StandinAddNodeType(const char *typeName, MFn::Type apiType, const char *classification)
+{
+   CStandinType *type = FindType(typeName);
+
+   if (!type)
+   {
+      type = new CStandinType();
+      type->name = typeName;
+      gTypes[typeName] = type;
+
+      type->attrs.push_back(NewAttribute("message", "msg", STANDIN_ATTR_MESSAGE, false, 0.0, false, false));
+
+      if (IsDagType(apiType))
+      {
+         type->attrs.push_back(NewAttribute("translate", "t", STANDIN_ATTR_NUMERIC, false, 0.0, false, false));
+         type->attrs.push_back(NewAttribute("velocity", "vel", STANDIN_ATTR_NUMERIC, false, 0.0, false, false));
+         type->attrs.push_back(NewAttribute("worldMatrix", "wm", STANDIN_ATTR_MATRIX, true, 0.0, false, false));
+         type->attrs.push_back(NewAttribute("instObjGroups", "iog", STANDIN_ATTR_MESSAGE, true, 0.0, false, false));
+      }
+      else if (apiType == MFn::kShadingEngine)
+      {
+         type->attrs.push_back(NewAttribute("dagSetMembers", "dsm", STANDIN_ATTR_MESSAGE, true, 0.0, false, false));
+         type->attrs.push_back(NewAttribute("surfaceShader", "ss", STANDIN_ATTR_MESSAGE, false, 0.0, false, false));
+      }
+      else if (apiType == MFn::kTime)
+      {
+         type->attrs.push_back(NewAttribute("outTime", "o", STANDIN_ATTR_NUMERIC, false, 0.0, false, false));
+      }
+   }
+
+   type->apiType = apiType;
+   type->classification = (classification ? classification : "");
+}
+
+bool StandinAddAttribute(const char *typeName, const char *name, const char *shortName, StandinAttrType type,
+                         bool isArray, double defaultValue, bool usedAsFilename)
+{
+   CStandinType *nodeType = FindType(typeName);
+
+   if (!nodeType || FindAttribute(nodeType->attrs, name) || (shortName && FindAttribute(nodeType->attrs, shortName)))
+   {
+      return false;
+   }
+
+   nodeType->attrs.push_back(NewAttribute(name, shortName, type, isArray, defaultValue, usedAsFilename, false));
+
+   return true;
+}
+
+bool StandinHasAttribute(const char *typeName, const char *name)
+{
+   CStandinType *nodeType = FindType(typeName);
+   return (nodeType && FindAttribute(nodeType->attrs, name) != NULL);
+}
+
+MObject StandinCreateNode(const char *typeName, const char *name, const MObject &parent)
+{
+   CStandinType *type = FindType(typeName);
+
+   if (!type)
+   {
+      return MObject::kNullObj;
+   }
+
+   CStandinNode *node = new CStandinNode();
+
+   node->name = name;
+   node->type = type;
+   node->alive = true;
+
+   gNodes.push_back(node);
+
+   MObject obj = CStandinAccess::MakeNode(node);
+
+   if (!parent.isNull())
+   {
+      StandinAddParent(obj, parent);
+   }
+
+   return obj;
+}
+
+bool StandinAddParent(const MObject &node, const MObject &parent)
+{
+   CStandinNode *child = CStandinAccess::Node(node);
+   CStandinNode *transform = CStandinAccess::Node(parent);
+
+   if (!child || !transform || !IsDagType(child->type->apiType) || !IsDagType(transform->type->apiType))
+   {
+      return false;
+   }
+
+   child->parents.push_back(transform);
+
+   return true;
+}
+
+bool StandinAddDynamicAttribute(const MObject &node, const char *name, StandinAttrType type, double defaultValue)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+
+   if (!dnode || FindAttribute(dnode, name))
+   {
+      return false;
+   }
+
+   dnode->attrs.push_back(NewAttribute(name, name, type, false, defaultValue, false, true));
+
+   return true;
+}
+
+bool StandinSetValue(const MObject &node, const char *attr, double value, int index)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+   CStandinAttribute *dattr = (dnode ? FindAttribute(dnode, attr) : NULL);
+
+   if (!dattr || dattr->type != STANDIN_ATTR_NUMERIC || (index >= 0) != dattr->isArray)
+   {
+      return false;
+   }
+
+   dnode->values[CStandinValueKey(dattr, index)].number = value;
+
+   return true;
+}
+
+bool StandinSetString(const MObject &node, const char *attr, const char *value)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+   CStandinAttribute *dattr = (dnode ? FindAttribute(dnode, attr) : NULL);
+
+   if (!dattr || dattr->type != STANDIN_ATTR_STRING)
+   {
+      return false;
+   }
+
+   dnode->values[CStandinValueKey(dattr, -1)].str = (value ? value : "");
+
+   return true;
+}
+
+bool StandinSetBoundingBox(const MObject &node, const MBoundingBox &bbox)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+
+   if (!dnode || !IsDagType(dnode->type->apiType))
+   {
+      return false;
+   }
+
+   dnode->bbox = bbox;
+
+   return true;
+}
+
+bool StandinConnect(const MObject &srcNode, const char *srcAttr, int srcIndex, const MObject &dstNode, const char *dstAttr, int dstIndex)
+{
+   CStandinNode *src = CStandinAccess::Node(srcNode);
+   CStandinNode *dst = CStandinAccess::Node(dstNode);
+   CStandinAttribute *sattr = (src ? FindAttribute(src, srcAttr) : NULL);
+   CStandinAttribute *dattr = (dst ? FindAttribute(dst, dstAttr) : NULL);
+
+   if (!sattr || !dattr || (srcIndex >= 0) != sattr->isArray || (dstIndex >= 0) != dattr->isArray)
+   {
+      return false;
+   }
+
+   CStandinConnection conn;
+
+   conn.src = CStandinAccess::MakePlug(src, sattr, srcIndex);
+   conn.dst = CStandinAccess::MakePlug(dst, dattr, dstIndex);
+
+   MPlug existing;
+   if (FindSource(conn.dst, existing))
+   {
+      return false;
+   }
+
+   gConnections.push_back(conn);
+   src->connections.push_back(gConnections.size() - 1);
+   if (dst != src)
+   {
+      dst->connections.push_back(gConnections.size() - 1);
+   }
+
+   std::vector<CStandinCallback> callbacks = gCallbacks;
+
+   for (size_t i=0; i<callbacks.size(); ++i)
+   {
+      if (callbacks[i].kind == CALLBACK_CONNECTION && callbacks[i].connFunc)
+      {
+         callbacks[i].connFunc(conn.src, conn.dst, true, callbacks[i].clientData);
+      }
+   }
+
+   return true;
+}
+
+bool StandinGetAllPaths(const MObject &node, std::vector<MDagPath> &paths)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+
+   paths.clear();
+
+   if (!dnode || !IsDagType(dnode->type->apiType))
+   {
+      return false;
+   }
+
+   size_t count = (dnode->parents.size() > 0 ? dnode->parents.size() : 1);
+
+   for (size_t i=0; i<count; ++i)
+   {
+      MDagPath path;
+      GetPathTo(dnode, (int) i, CStandinAccess::Nodes(path));
+      paths.push_back(path);
+   }
+
+   return true;
+}
+
+void StandinNewScene()
+{
+   CallSceneCallbacks(MSceneMessage::kBeforeNew);
+
+   for (size_t i=0; i<gNodes.size(); ++i)
+   {
+      gNodes[i]->alive = false;
+      for (size_t j=0; j<gNodes[i]->attrs.size(); ++j)
+      {
+         delete gNodes[i]->attrs[j];
+      }
+      gNodes[i]->attrs.clear();
+      gNodes[i]->values.clear();
+      gNodes[i]->parents.clear();
+      gNodes[i]->connections.clear();
+      gDeadNodes.push_back(gNodes[i]);
+   }
+
+   gNodes.clear();
+   gConnections.clear();
+
+   CallSceneCallbacks(MSceneMessage::kAfterNew);
+}
+
+void StandinSetCurrentTime(double frame)
+{
+   gCurrentTime = MTime(frame);
+}
+
+void StandinLoadPlugin(const char *pluginName)
+{
+   if (gPlugins.insert(pluginName).second)
+   {
+      MStringArray strs;
+      strs.append(MString("/standin/plug-ins/") + pluginName);
+      strs.append(pluginName);
+      CallSceneCallbacks(MSceneMessage::kAfterPluginLoad, strs);
+   }
+}
+
+void StandinSendEvent(const char *eventName)
+{
+   std::vector<CStandinCallback> callbacks = gCallbacks;
+
+   for (size_t i=0; i<callbacks.size(); ++i)
+   {
+      if (callbacks[i].kind == CALLBACK_EVENT && callbacks[i].event == eventName && callbacks[i].func)
+      {
+         callbacks[i].func(callbacks[i].clientData);
+      }
+   }
+}
+
+unsigned long StandinGetDisplayedMessages(bool reset)
+{
+   unsigned long count = gDisplayedMessages;
+   if (reset)
+   {
+      gDisplayedMessages = 0;
+   }
+   return count;
+}
+
+// MString
+
+MString::MString() {}
+MString::MString(const char *str) : m_str(str ? str : "") {}
+MString::MString(const MString &rhs) : m_str(rhs.m_str) {}
+MString::~MString() {}
+
+MString& MString::operator=(const MString &rhs) { m_str = rhs.m_str; return *this; }
+MString& MString::operator=(const char *str) { m_str = (str ? str : ""); return *this; }
+MString& MString::operator+=(const MString &rhs) { m_str += rhs.m_str; return *this; }
+MString& MString::operator+=(const char *str) { m_str += (str ? str : ""); return *this; }
+MString MString::operator+(const MString &rhs) const { MString rv(*this); rv += rhs; return rv; }
+MString MString::operator+(const char *str) const { MString rv(*this); rv += str; return rv; }
+MString operator+(const char *str, const MString &rhs) { MString rv(str); rv += rhs; return rv; }
+
+bool MString::operator==(const MString &rhs) const { return (m_str == rhs.m_str); }
+bool MString::operator!=(const MString &rhs) const { return (m_str != rhs.m_str); }
+bool MString::operator==(const char *str) const { return (m_str == (str ? str : "")); }
+bool MString::operator!=(const char *str) const { return !operator==(str); }
+
+const char* MString::asChar() const { return m_str.c_str(); }
+int MString::asInt() const { return atoi(m_str.c_str()); }
+float MString::asFloat() const { return (float) atof(m_str.c_str()); }
+double MString::asDouble() const { return atof(m_str.c_str()); }
+unsigned int MString::length() const { return (unsigned int) m_str.length(); }
+
+bool MString::isInt() const
+{
+   char *end = NULL;
+   if (m_str.length() == 0)
+   {
+      return false;
+   }
+   strtol(m_str.c_str(), &end, 10);
+   return (end && *end == '\0');
+}
+
+int MString::indexW(const MString &str) const
+{
+   size_t p = m_str.find(str.m_str);
+   return (p != std::string::npos ? (int) p : -1);
+}
+
+int MString::indexW(char c) const
+{
+   size_t p = m_str.find(c);
+   return (p != std::string::npos ? (int) p : -1);
+}
+
+MString MString::substring(int start, int end) const
+{
+   if (start < 0)
+   {
+      start = 0;
+   }
+   if (end >= (int) m_str.length())
+   {
+      end = (int) m_str.length() - 1;
+   }
+   return (end < start ? MString() : MString(m_str.substr(start, end - start + 1).c_str()));
+}
+
+MString& MString::set(double value, int precision)
+{
+   char buffer[64];
+   sprintf(buffer, "%.*f", precision, value);
+   m_str = buffer;
+   return *this;
+}
+
+MStatus MString::split(char c, MStringArray &result) const
+{
+   size_t p0 = 0;
+
+   result.clear();
+
+   while (p0 <= m_str.length())
+   {
+      size_t p1 = m_str.find(c, p0);
+      if (p1 == std::string::npos)
+      {
+         p1 = m_str.length();
+      }
+      if (p1 > p0)
+      {
+         result.append(m_str.substr(p0, p1 - p0).c_str());
+      }
+      p0 = p1 + 1;
+   }
+
+   return MS::kSuccess;
+}
+
+// $VAR and ${VAR} are expanded, unset variables are left as is (as maya does)
+MString MString::expandEnvironmentVariablesAndTilde(MStatus *status) const
+{
+   std::string rv;
+   size_t p = 0;
+
+   while (p < m_str.length())
+   {
+      if (m_str[p] == '~' && p == 0)
+      {
+         const char *home = getenv("HOME");
+         rv += (home ? home : "~");
+         ++p;
+      }
+      else if (m_str[p] == '$')
+      {
+         bool braces = (p + 1 < m_str.length() && m_str[p+1] == '{');
+         size_t n0 = p + (braces ? 2 : 1);
+         size_t n1 = n0;
+
+         while (n1 < m_str.length() && (isalnum((unsigned char) m_str[n1]) || m_str[n1] == '_'))
+         {
+            ++n1;
+         }
+
+         size_t e = n1 + (braces && n1 < m_str.length() && m_str[n1] == '}' ? 1 : 0);
+         const char *value = (n1 > n0 ? getenv(m_str.substr(n0, n1 - n0).c_str()) : NULL);
+
+         rv += (value ? std::string(value) : m_str.substr(p, e - p));
+         p = e;
+      }
+      else
+      {
+         rv += m_str[p++];
+      }
+   }
+
+   if (status)
+   {
+      *status = MS::kSuccess;
+   }
+
+   return MString(rv.c_str());
+}
+
+// MStringArray
+
+MStringArray::MStringArray() {}
+unsigned int MStringArray::length() const { return (unsigned int) m_strs.size(); }
+MString& MStringArray::operator[](unsigned int i) { return m_strs[i]; }
+const MString& MStringArray::operator[](unsigned int i) const { return m_strs[i]; }
+MStatus MStringArray::append(const MString &str) { m_strs.push_back(str); return MS::kSuccess; }
+MStatus MStringArray::clear() { m_strs.clear(); return MS::kSuccess; }
+
+// MObject
+
+const MObject MObject::kNullObj;
+
+MObject::MObject() : m_kind(kNone), m_ptr(NULL) {}
+
+MObject::MObject(const MObject &rhs) : m_kind(rhs.m_kind), m_ptr(rhs.m_ptr)
+{
+   CStandinAccess::Retain(*this);
+}
+
+MObject::~MObject()
+{
+   CStandinAccess::Release(*this);
+}
+
+MObject& MObject::operator=(const MObject &rhs)
+{
+   if (this != &rhs)
+   {
+      CStandinAccess::Retain(rhs);
+      CStandinAccess::Release(*this);
+      m_kind = rhs.m_kind;
+      m_ptr = rhs.m_ptr;
+   }
+   return *this;
+}
+
+bool MObject::operator==(const MObject &rhs) const { return (m_kind == rhs.m_kind && m_ptr == rhs.m_ptr); }
+bool MObject::operator!=(const MObject &rhs) const { return !operator==(rhs); }
+bool MObject::isNull() const { return (m_kind == kNone); }
+
+MFn::Type MObject::apiType() const
+{
+   switch (m_kind)
+   {
+   case kNode:
+      return ((CStandinNode*) m_ptr)->type->apiType;
+   case kAttr:
+      return MFn::kAttribute;
+   case kData:
+      return (((CStandinData*) m_ptr)->plugin ? MFn::kBase : MFn::kMatrixData);
+   default:
+      return MFn::kInvalid;
+   }
+}
+
+bool MObject::hasFn(MFn::Type type) const
+{
+   MFn::Type t = apiType();
+
+   if (t == type || (t != MFn::kInvalid && type == MFn::kBase))
+   {
+      return true;
+   }
+   if (m_kind != kNode)
+   {
+      return false;
+   }
+   if (type == MFn::kDependencyNode || type == MFn::kNamedObject)
+   {
+      return true;
+   }
+   if (type == MFn::kDagNode)
+   {
+      return IsDagType(t);
+   }
+   if (type == MFn::kShape)
+   {
+      return IsShapeType(t);
+   }
+   return false;
+}
+
+// MObjectArray
+
+MObjectArray::MObjectArray() {}
+unsigned int MObjectArray::length() const { return (unsigned int) m_objs.size(); }
+MObject& MObjectArray::operator[](unsigned int i) { return m_objs[i]; }
+const MObject& MObjectArray::operator[](unsigned int i) const { return m_objs[i]; }
+MStatus MObjectArray::append(const MObject &obj) { m_objs.push_back(obj); return MS::kSuccess; }
+MStatus MObjectArray::clear() { m_objs.clear(); return MS::kSuccess; }
+
+// MObjectHandle
+
+MObjectHandle::MObjectHandle() {}
+MObjectHandle::MObjectHandle(const MObject &obj) : m_object(obj) {}
+MObject MObjectHandle::object() const { return m_object; }
+bool MObjectHandle::isValid() const { return isAlive(); }
+
+bool MObjectHandle::isAlive() const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   return (node ? node->alive : !m_object.isNull());
+}
+
+unsigned int MObjectHandle::hashCode() const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   size_t p = (size_t) node;
+   return (unsigned int) ((p >> 4) ^ (p >> 32));
+}
+
+bool MObjectHandle::operator==(const MObject &obj) const { return (m_object == obj); }
+bool MObjectHandle::operator==(const MObjectHandle &rhs) const { return (m_object == rhs.m_object); }
+bool MObjectHandle::operator!=(const MObjectHandle &rhs) const { return (m_object != rhs.m_object); }
+
+// Time
+
+MTime::MTime() : m_value(0.0), m_unit(kFilm) {}
+MTime::MTime(double value, Unit unit) : m_value(value), m_unit(unit) {}
+double MTime::value() const { return m_value; }
+MTime::Unit MTime::unit() const { return m_unit; }
+// Single unit scene
+double MTime::as(Unit) const { return m_value; }
+bool MTime::operator==(const MTime &rhs) const { return (m_value == rhs.m_value); }
+bool MTime::operator!=(const MTime &rhs) const { return (m_value != rhs.m_value); }
+MTime::Unit MTime::uiUnit() { return kFilm; }
+
+MTime MAnimControl::currentTime() { return gCurrentTime; }
+MStatus MAnimControl::setCurrentTime(const MTime &time) { gCurrentTime = time; return MS::kSuccess; }
+
+MDGContext MDGContext::fsNormal;
+
+MDGContext::MDGContext() : m_normal(true) {}
+MDGContext::MDGContext(const MTime &time) : m_normal(false), m_time(time) {}
+bool MDGContext::isNormal() const { return m_normal; }
+
+MStatus MDGContext::getTime(MTime &time) const
+{
+   if (m_normal)
+   {
+      // Normal contexts follow the guarded one
+      if (this != &gContext && !gContext.m_normal)
+      {
+         time = gContext.m_time;
+         return MS::kSuccess;
+      }
+      return MS::kFailure;
+   }
+   time = m_time;
+   return MS::kSuccess;
+}
+
+MDGContextGuard::MDGContextGuard(const MDGContext &context) : m_previous(gContext)
+{
+   gContext = context;
+}
+
+MDGContextGuard::~MDGContextGuard()
+{
+   gContext = m_previous;
+}
+
+// Math
+
+MPoint::MPoint() : x(0.0), y(0.0), z(0.0), w(1.0) {}
+MPoint::MPoint(double x, double y, double z, double w) : x(x), y(y), z(z), w(w) {}
+
+MMatrix::MMatrix()
+{
+   for (int i=0; i<4; ++i)
+   {
+      for (int j=0; j<4; ++j)
+      {
+         matrix[i][j] = (i == j ? 1.0 : 0.0);
+      }
+   }
+}
+
+double MMatrix::operator()(unsigned int row, unsigned int col) const { return matrix[row][col]; }
+
+MMatrix MMatrix::operator*(const MMatrix &rhs) const
+{
+   MMatrix rv;
+   for (int i=0; i<4; ++i)
+   {
+      for (int j=0; j<4; ++j)
+      {
+         rv.matrix[i][j] = 0.0;
+         for (int k=0; k<4; ++k)
+         {
+            rv.matrix[i][j] += matrix[i][k] * rhs.matrix[k][j];
+         }
+      }
+   }
+   return rv;
+}
+
+bool MMatrix::isEquivalent(const MMatrix &rhs, double tolerance) const
+{
+   for (int i=0; i<4; ++i)
+   {
+      for (int j=0; j<4; ++j)
+      {
+         double d = matrix[i][j] - rhs.matrix[i][j];
+         if (d > tolerance || d < -tolerance)
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+MBoundingBox::MBoundingBox() : m_empty(true) {}
+MBoundingBox::MBoundingBox(const MPoint &corner1, const MPoint &corner2) : m_empty(true) { expand(corner1); expand(corner2); }
+MPoint MBoundingBox::min() const { return m_min; }
+MPoint MBoundingBox::max() const { return m_max; }
+void MBoundingBox::clear() { m_empty = true; m_min = MPoint(); m_max = MPoint(); }
+
+void MBoundingBox::expand(const MPoint &p)
+{
+   if (m_empty)
+   {
+      m_min = m_max = p;
+      m_empty = false;
+      return;
+   }
+   m_min.x = std::min(m_min.x, p.x); m_min.y = std::min(m_min.y, p.y); m_min.z = std::min(m_min.z, p.z);
+   m_max.x = std::max(m_max.x, p.x); m_max.y = std::max(m_max.y, p.y); m_max.z = std::max(m_max.z, p.z);
+}
+
+void MBoundingBox::expand(const MBoundingBox &box)
+{
+   if (!box.m_empty)
+   {
+      expand(box.m_min);
+      expand(box.m_max);
+   }
+}
+
+MBoundingBox& MBoundingBox::transformUsing(const MMatrix &m)
+{
+   if (m_empty)
+   {
+      return *this;
+   }
+
+   MBoundingBox rv;
+
+   for (int i=0; i<8; ++i)
+   {
+      MPoint p((i & 1) ? m_max.x : m_min.x, (i & 2) ? m_max.y : m_min.y, (i & 4) ? m_max.z : m_min.z);
+      rv.expand(MPoint(p.x * m.matrix[0][0] + p.y * m.matrix[1][0] + p.z * m.matrix[2][0] + m.matrix[3][0],
+                       p.x * m.matrix[0][1] + p.y * m.matrix[1][1] + p.z * m.matrix[2][1] + m.matrix[3][1],
+                       p.x * m.matrix[0][2] + p.y * m.matrix[1][2] + p.z * m.matrix[2][2] + m.matrix[3][2]));
+   }
+
+   *this = rv;
+
+   return *this;
+}
+
+// MPlug
+
+static void SetStatus(MStatus *status, MStatus::MStatusCode code)
+{
+   if (status)
+   {
+      *status = code;
+   }
+}
+
+MPlug::MPlug() : m_node(NULL), m_attr(NULL), m_index(-1) {}
+
+MPlug::MPlug(const MObject &node, const MObject &attribute)
+   : m_node(CStandinAccess::Node(node)), m_attr(CStandinAccess::Attr(attribute)), m_index(-1)
+{
+   if (!m_node || !m_attr)
+   {
+      m_node = NULL;
+      m_attr = NULL;
+   }
+}
+
+bool MPlug::isNull(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_attr == NULL); }
+MObject MPlug::node(MStatus *status) const { SetStatus(status, m_node ? MS::kSuccess : MS::kFailure); return CStandinAccess::MakeNode(m_node); }
+MObject MPlug::attribute(MStatus *status) const { SetStatus(status, m_attr ? MS::kSuccess : MS::kFailure); return CStandinAccess::MakeAttr(m_attr); }
+
+MString MPlug::name(MStatus *status) const
+{
+   SetStatus(status, m_attr ? MS::kSuccess : MS::kFailure);
+   return (m_attr ? MString(m_node->name.c_str()) + "." + partialName() : MString());
+}
+
+MString MPlug::partialName(bool includeNodeName) const
+{
+   if (!m_attr)
+   {
+      return MString();
+   }
+
+   std::string name = (includeNodeName ? m_node->name + "." : std::string()) + m_attr->shortName;
+
+   if (m_index >= 0)
+   {
+      char buffer[32];
+      sprintf(buffer, "[%d]", m_index);
+      name += buffer;
+   }
+
+   return MString(name.c_str());
+}
+
+bool MPlug::isArray(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_attr && m_attr->isArray && m_index < 0); }
+bool MPlug::isElement(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_index >= 0); }
+bool MPlug::isCompound(MStatus *status) const { SetStatus(status, MS::kSuccess); return false; }
+bool MPlug::isDynamic(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_attr && m_attr->dynamic); }
+bool MPlug::isConnected(MStatus *status) const { return (isSource(status) || isDestination(status)); }
+
+bool MPlug::isSource(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   for (size_t i=0; m_node && i<m_node->connections.size(); ++i)
+   {
+      if (gConnections[m_node->connections[i]].src == *this)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+bool MPlug::isDestination(MStatus *status) const
+{
+   MPlug src;
+   SetStatus(status, MS::kSuccess);
+   return FindSource(*this, src);
+}
+
+unsigned int MPlug::logicalIndex(MStatus *status) const
+{
+   SetStatus(status, m_index >= 0 ? MS::kSuccess : MS::kFailure);
+   return (m_index >= 0 ? (unsigned int) m_index : 0);
+}
+
+unsigned int MPlug::numElements(MStatus *status) const
+{
+   std::set<int> indices;
+
+   SetStatus(status, isArray() ? MS::kSuccess : MS::kFailure);
+
+   if (!isArray())
+   {
+      return 0;
+   }
+
+   for (std::map<CStandinValueKey, CStandinValue>::const_iterator it=m_node->values.begin(); it!=m_node->values.end(); ++it)
+   {
+      if (it->first.first == m_attr)
+      {
+         indices.insert(it->first.second);
+      }
+   }
+   for (size_t i=0; i<m_node->connections.size(); ++i)
+   {
+      const CStandinConnection &conn = gConnections[m_node->connections[i]];
+      if (CStandinAccess::Node(conn.src) == m_node && CStandinAccess::Attr(conn.src) == m_attr)
+      {
+         indices.insert(CStandinAccess::Index(conn.src));
+      }
+      if (CStandinAccess::Node(conn.dst) == m_node && CStandinAccess::Attr(conn.dst) == m_attr)
+      {
+         indices.insert(CStandinAccess::Index(conn.dst));
+      }
+   }
+
+   return (unsigned int) indices.size();
+}
+
+MPlug MPlug::elementByLogicalIndex(unsigned int index, MStatus *status) const
+{
+   if (!isArray())
+   {
+      SetStatus(status, MS::kFailure);
+      return MPlug();
+   }
+   SetStatus(status, MS::kSuccess);
+   return CStandinAccess::MakePlug(m_node, m_attr, (int) index);
+}
+
+MPlug MPlug::array(MStatus *status) const
+{
+   if (m_index < 0)
+   {
+      SetStatus(status, MS::kFailure);
+      return MPlug();
+   }
+   SetStatus(status, MS::kSuccess);
+   return CStandinAccess::MakePlug(m_node, m_attr, -1);
+}
+
+bool MPlug::connectedTo(MPlugArray &plugs, bool asDst, bool asSrc, MStatus *status) const
+{
+   plugs.clear();
+
+   for (size_t i=0; m_node && i<m_node->connections.size(); ++i)
+   {
+      const CStandinConnection &conn = gConnections[m_node->connections[i]];
+      if (asDst && conn.dst == *this)
+      {
+         plugs.append(conn.src);
+      }
+      if (asSrc && conn.src == *this)
+      {
+         plugs.append(conn.dst);
+      }
+   }
+
+   SetStatus(status, MS::kSuccess);
+
+   return (plugs.length() > 0);
+}
+
+bool MPlug::asBool(MStatus *status) const { return (asDouble(status) != 0.0); }
+short MPlug::asShort(MStatus *status) const { return (short) asDouble(status); }
+int MPlug::asInt(MStatus *status) const { return (int) asDouble(status); }
+float MPlug::asFloat(MStatus *status) const { return (float) asDouble(status); }
+
+double MPlug::asDouble(MStatus *status) const
+{
+   if (!m_attr || m_attr->type != STANDIN_ATTR_NUMERIC || isArray())
+   {
+      SetStatus(status, MS::kFailure);
+      return 0.0;
+   }
+   SetStatus(status, MS::kSuccess);
+   return GetNumericValue(m_node, m_attr, m_index, gContext);
+}
+
+MString MPlug::asString(MStatus *status) const
+{
+   if (!m_attr || m_attr->type != STANDIN_ATTR_STRING)
+   {
+      SetStatus(status, MS::kFailure);
+      return MString();
+   }
+
+   std::map<CStandinValueKey, CStandinValue>::const_iterator it = m_node->values.find(CStandinValueKey(m_attr, m_index));
+
+   SetStatus(status, MS::kSuccess);
+
+   return (it != m_node->values.end() ? MString(it->second.str.c_str()) : MString());
+}
+
+MObject MPlug::asMObject(MStatus *status) const
+{
+   if (!m_attr || m_attr->type != STANDIN_ATTR_MATRIX || isArray())
+   {
+      SetStatus(status, MS::kFailure);
+      return MObject();
+   }
+   SetStatus(status, MS::kSuccess);
+   return GetMatrixValue(m_node, m_attr, m_index, gContext);
+}
+
+MStatus MPlug::getValue(MObject &value, MDGContext &context) const
+{
+   if (!m_attr || m_attr->type != STANDIN_ATTR_MATRIX || isArray())
+   {
+      return MS::kFailure;
+   }
+   value = GetMatrixValue(m_node, m_attr, m_index, context);
+   return MS::kSuccess;
+}
+
+MStatus MPlug::getValue(double &value, MDGContext &context) const
+{
+   if (!m_attr || m_attr->type != STANDIN_ATTR_NUMERIC || isArray())
+   {
+      return MS::kFailure;
+   }
+   value = GetNumericValue(m_node, m_attr, m_index, context);
+   return MS::kSuccess;
+}
+
+// Unconnected values that were set (all values for kAll)
+MStatus MPlug::getSetAttrCmds(MStringArray &cmds, MValueSelector valueSelector, bool useLongNames)
+{
+   if (!m_attr)
+   {
+      return MS::kFailure;
+   }
+
+   const std::string &attrName = (useLongNames ? m_attr->name : m_attr->shortName);
+
+   if (valueSelector == kAll && !m_attr->isArray && m_node->values.find(CStandinValueKey(m_attr, -1)) == m_node->values.end())
+   {
+      if (m_attr->type == STANDIN_ATTR_NUMERIC)
+      {
+         MString value;
+         value.set(m_attr->defaultValue, 6);
+         cmds.append(MString("setAttr \".") + attrName.c_str() + "\" " + value + ";");
+      }
+      return MS::kSuccess;
+   }
+
+   for (std::map<CStandinValueKey, CStandinValue>::const_iterator it=m_node->values.begin(); it!=m_node->values.end(); ++it)
+   {
+      if (it->first.first != m_attr || (m_index >= 0 && it->first.second != m_index) ||
+          isDestination() || CStandinAccess::MakePlug(m_node, m_attr, it->first.second).isDestination())
+      {
+         continue;
+      }
+
+      std::string plugName = attrName;
+
+      if (it->first.second >= 0)
+      {
+         char buffer[32];
+         sprintf(buffer, "[%d]", it->first.second);
+         plugName += buffer;
+      }
+
+      if (m_attr->type == STANDIN_ATTR_STRING)
+      {
+         cmds.append(MString("setAttr \".") + plugName.c_str() + "\" -type \"string\" \"" + it->second.str.c_str() + "\";");
+      }
+      else
+      {
+         MString value;
+         value.set(it->second.number, 6);
+         cmds.append(MString("setAttr \".") + plugName.c_str() + "\" " + value + ";");
+      }
+   }
+
+   return MS::kSuccess;
+}
+
+bool MPlug::operator==(const MPlug &rhs) const { return (m_node == rhs.m_node && m_attr == rhs.m_attr && m_index == rhs.m_index); }
+bool MPlug::operator!=(const MPlug &rhs) const { return !operator==(rhs); }
+
+MPlugArray::MPlugArray() {}
+unsigned int MPlugArray::length() const { return (unsigned int) m_plugs.size(); }
+MPlug& MPlugArray::operator[](unsigned int i) { return m_plugs[i]; }
+const MPlug& MPlugArray::operator[](unsigned int i) const { return m_plugs[i]; }
+MStatus MPlugArray::append(const MPlug &plug) { m_plugs.push_back(plug); return MS::kSuccess; }
+MStatus MPlugArray::clear() { m_plugs.clear(); return MS::kSuccess; }
+
+// MDagPath
+
+MDagPath::MDagPath() {}
+
+bool MDagPath::isValid(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_nodes.size() > 0); }
+
+MObject MDagPath::node(MStatus *status) const
+{
+   SetStatus(status, m_nodes.size() > 0 ? MS::kSuccess : MS::kFailure);
+   return (m_nodes.size() > 0 ? CStandinAccess::MakeNode(m_nodes.back()) : MObject());
+}
+
+MObject MDagPath::transform(MStatus *status) const
+{
+   for (size_t i=m_nodes.size(); i>0; --i)
+   {
+      if (!IsShapeType(m_nodes[i-1]->type->apiType))
+      {
+         SetStatus(status, MS::kSuccess);
+         return CStandinAccess::MakeNode(m_nodes[i-1]);
+      }
+   }
+   SetStatus(status, MS::kFailure);
+   return MObject();
+}
+
+unsigned int MDagPath::length(MStatus *status) const { SetStatus(status, MS::kSuccess); return (unsigned int) m_nodes.size(); }
+
+MStatus MDagPath::pop(unsigned int num)
+{
+   if (num > m_nodes.size())
+   {
+      return MS::kInvalidParameter;
+   }
+   m_nodes.resize(m_nodes.size() - num);
+   return MS::kSuccess;
+}
+
+bool MDagPath::isInstanced(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   for (size_t i=0; i<m_nodes.size(); ++i)
+   {
+      if (m_nodes[i]->parents.size() > 1)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+unsigned int MDagPath::instanceNumber(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+
+   if (m_nodes.size() < 2)
+   {
+      return 0;
+   }
+
+   const std::vector<CStandinNode*> &parents = m_nodes.back()->parents;
+   std::vector<CStandinNode*>::const_iterator it = std::find(parents.begin(), parents.end(), m_nodes[m_nodes.size()-2]);
+
+   return (it != parents.end() ? (unsigned int) (it - parents.begin()) : 0);
+}
+
+MString MDagPath::fullPathName(MStatus *status) const
+{
+   std::string name;
+   for (size_t i=0; i<m_nodes.size(); ++i)
+   {
+      name += "|" + m_nodes[i]->name;
+   }
+   SetStatus(status, MS::kSuccess);
+   return MString(name.c_str());
+}
+
+MString MDagPath::partialPathName(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return (m_nodes.size() > 0 ? MString(m_nodes.back()->name.c_str()) : MString());
+}
+
+MMatrix MDagPath::inclusiveMatrix(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return GetPathMatrix(m_nodes, m_nodes.size(), GetEvalFrame(gContext));
+}
+
+MMatrix MDagPath::exclusiveMatrix(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return GetPathMatrix(m_nodes, (m_nodes.size() > 0 ? m_nodes.size() - 1 : 0), GetEvalFrame(gContext));
+}
+
+bool MDagPath::operator==(const MDagPath &rhs) const { return (m_nodes == rhs.m_nodes); }
+
+MStatus MDagPath::getAPathTo(const MObject &node, MDagPath &path)
+{
+   CStandinNode *dnode = CStandinAccess::Node(node);
+
+   if (!dnode || !IsDagType(dnode->type->apiType))
+   {
+      path.m_nodes.clear();
+      return MS::kInvalidParameter;
+   }
+
+   GetPathTo(dnode, 0, path.m_nodes);
+
+   return MS::kSuccess;
+}
+
+// Function sets
+
+MFnBase::MFnBase() {}
+MFnBase::~MFnBase() {}
+MObject MFnBase::object(MStatus *status) const { SetStatus(status, MS::kSuccess); return m_object; }
+MStatus MFnBase::setObject(const MObject &object) { m_object = object; return MS::kSuccess; }
+
+MFnDependencyNode::MFnDependencyNode() {}
+
+MFnDependencyNode::MFnDependencyNode(const MObject &object, MStatus *status)
+{
+   SetStatus(status, CStandinAccess::Node(object) ? MS::kSuccess : MS::kInvalidParameter);
+   m_object = object;
+}
+
+MString MFnDependencyNode::name(MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   SetStatus(status, node ? MS::kSuccess : MS::kFailure);
+   return (node ? MString(node->name.c_str()) : MString());
+}
+
+MString MFnDependencyNode::typeName(MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   SetStatus(status, node ? MS::kSuccess : MS::kFailure);
+   return (node ? MString(node->type->name.c_str()) : MString());
+}
+
+unsigned int MFnDependencyNode::attributeCount(MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   SetStatus(status, node ? MS::kSuccess : MS::kFailure);
+   return (node ? (unsigned int) (node->type->attrs.size() + node->attrs.size()) : 0);
+}
+
+MObject MFnDependencyNode::attribute(unsigned int index, MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+
+   if (!node || index >= node->type->attrs.size() + node->attrs.size())
+   {
+      SetStatus(status, MS::kInvalidParameter);
+      return MObject();
+   }
+
+   SetStatus(status, MS::kSuccess);
+
+   return CStandinAccess::MakeAttr(index < node->type->attrs.size() ? node->type->attrs[index] : node->attrs[index - node->type->attrs.size()]);
+}
+
+MObject MFnDependencyNode::attribute(const MString &attrName, MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   CStandinAttribute *attr = (node ? FindAttribute(node, attrName.asChar()) : NULL);
+
+   SetStatus(status, attr ? MS::kSuccess : MS::kInvalidParameter);
+
+   return CStandinAccess::MakeAttr(attr);
+}
+
+bool MFnDependencyNode::hasAttribute(const MString &attrName, MStatus *status) const
+{
+   return !attribute(attrName, status).isNull();
+}
+
+MPlug MFnDependencyNode::findPlug(const MString &attrName, bool, MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   CStandinAttribute *attr = (node ? FindAttribute(node, attrName.asChar()) : NULL);
+
+   SetStatus(status, attr ? MS::kSuccess : MS::kInvalidParameter);
+
+   return (attr ? CStandinAccess::MakePlug(node, attr, -1) : MPlug());
+}
+
+MStatus MFnDependencyNode::getConnections(MPlugArray &plugs) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+
+   plugs.clear();
+
+   if (!node)
+   {
+      return MS::kFailure;
+   }
+
+   for (size_t i=0; i<node->connections.size(); ++i)
+   {
+      const CStandinConnection &conn = gConnections[node->connections[i]];
+      const MPlug *plug = (CStandinAccess::Node(conn.src) == node ? &(conn.src) : &(conn.dst));
+      bool found = false;
+
+      for (unsigned int j=0; plug && j<plugs.length(); ++j)
+      {
+         found = found || (plugs[j] == *plug);
+      }
+      if (plug && !found)
+      {
+         plugs.append(*plug);
+      }
+   }
+
+   return MS::kSuccess;
+}
+
+bool MFnDependencyNode::isFromReferencedFile(MStatus *status) const { SetStatus(status, MS::kSuccess); return false; }
+
+MString MFnDependencyNode::classification(const MString &nodeTypeName)
+{
+   CStandinType *type = FindType(nodeTypeName.asChar());
+   return (type ? MString(type->classification.c_str()) : MString());
+}
+
+MFnDagNode::MFnDagNode() {}
+
+MFnDagNode::MFnDagNode(const MObject &object, MStatus *status) : MFnDependencyNode(object, status)
+{
+   if (status && !m_object.hasFn(MFn::kDagNode))
+   {
+      *status = MS::kInvalidParameter;
+   }
+}
+
+MBoundingBox MFnDagNode::boundingBox(MStatus *status) const
+{
+   CStandinNode *node = CStandinAccess::Node(m_object);
+   SetStatus(status, node ? MS::kSuccess : MS::kFailure);
+   return (node ? node->bbox : MBoundingBox());
+}
+
+MStatus MFnDagNode::getPath(MDagPath &path) const
+{
+   return MDagPath::getAPathTo(m_object, path);
+}
+
+MFnAttribute::MFnAttribute() {}
+
+MFnAttribute::MFnAttribute(const MObject &object, MStatus *status)
+{
+   SetStatus(status, CStandinAccess::Attr(object) ? MS::kSuccess : MS::kInvalidParameter);
+   m_object = object;
+}
+
+#define STANDIN_ATTR_QUERY(returnType, method, expr, invalid) \
+   returnType MFnAttribute::method(MStatus *status) const \
+   { \
+      CStandinAttribute *attr = CStandinAccess::Attr(m_object); \
+      SetStatus(status, attr ? MS::kSuccess : MS::kFailure); \
+      return (attr ? (expr) : (invalid)); \
+   }
+
+STANDIN_ATTR_QUERY(MString, name, MString(attr->name.c_str()), MString())
+STANDIN_ATTR_QUERY(MString, shortName, MString(attr->shortName.c_str()), MString())
+STANDIN_ATTR_QUERY(bool, isArray, attr->isArray, false)
+STANDIN_ATTR_QUERY(bool, isWritable, true, false)
+STANDIN_ATTR_QUERY(bool, isStorable, attr->type != STANDIN_ATTR_MATRIX, false)
+STANDIN_ATTR_QUERY(bool, isHidden, false, false)
+STANDIN_ATTR_QUERY(bool, isUsedAsFilename, attr->usedAsFilename, false)
+
+#undef STANDIN_ATTR_QUERY
+
+// Compound attributes aren't supported
+MObject MFnAttribute::parent(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return MObject();
+}
+
+MFnMatrixData::MFnMatrixData() {}
+
+MFnMatrixData::MFnMatrixData(const MObject &object, MStatus *status)
+{
+   CStandinData *data = CStandinAccess::Data(object);
+   SetStatus(status, (data && !data->plugin) ? MS::kSuccess : MS::kInvalidParameter);
+   m_object = object;
+}
+
+MMatrix MFnMatrixData::matrix(MStatus *status) const
+{
+   CStandinData *data = CStandinAccess::Data(m_object);
+
+   if (!data || data->plugin)
+   {
+      SetStatus(status, MS::kFailure);
+      return MMatrix();
+   }
+
+   SetStatus(status, MS::kSuccess);
+
+   return data->matrix;
+}
+
+MObject MFnMatrixData::create(const MMatrix &matrix, MStatus *status)
+{
+   CStandinData *data = new CStandinData();
+
+   data->plugin = false;
+   data->matrix = matrix;
+
+   m_object = CStandinAccess::MakeData(data);
+
+   SetStatus(status, MS::kSuccess);
+
+   return m_object;
+}
+
+MObject MFnRenderLayer::currentLayer(MStatus *status)
+{
+   for (size_t i=0; i<gNodes.size(); ++i)
+   {
+      if (gNodes[i]->type->apiType == MFn::kRenderLayer && gNodes[i]->name == "defaultRenderLayer")
+      {
+         SetStatus(status, MS::kSuccess);
+         return CStandinAccess::MakeNode(gNodes[i]);
+      }
+   }
+
+   SetStatus(status, MS::kFailure);
+
+   return MObject();
+}
+
+// MNodeClass
+
+MNodeClass::MNodeClass(const MString &typeName) : m_typeName(typeName.asChar()) {}
+
+MString MNodeClass::typeName(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return MString(m_typeName.c_str());
+}
+
+MObject MNodeClass::attribute(const MString &attrName, MStatus *status) const
+{
+   CStandinType *type = FindType(m_typeName);
+   CStandinAttribute *attr = (type ? FindAttribute(type->attrs, attrName.asChar()) : NULL);
+
+   SetStatus(status, attr ? MS::kSuccess : MS::kInvalidParameter);
+
+   return CStandinAccess::MakeAttr(attr);
+}
+
+MStatus MNodeClass::getAttributes(MObjectArray &attrs)
+{
+   CStandinType *type = FindType(m_typeName);
+
+   attrs.clear();
+
+   if (!type)
+   {
+      return MS::kFailure;
+   }
+
+   for (size_t i=0; i<type->attrs.size(); ++i)
+   {
+      attrs.append(CStandinAccess::MakeAttr(type->attrs[i]));
+   }
+
+   return MS::kSuccess;
+}
+
+// MItDependencyGraph
+
+MItDependencyGraph::MItDependencyGraph(MObject &rootNode, MFn::Type filter, Direction direction, Traversal, Level, MStatus *status)
+   : m_current(0)
+{
+   CStandinNode *root = CStandinAccess::Node(rootNode);
+
+   if (!root)
+   {
+      SetStatus(status, MS::kInvalidParameter);
+      return;
+   }
+
+   std::set<CStandinNode*> visited;
+   std::vector<CStandinNode*> stack;
+
+   stack.push_back(root);
+
+   while (stack.size() > 0)
+   {
+      CStandinNode *node = stack.back();
+      stack.pop_back();
+
+      if (!visited.insert(node).second)
+      {
+         continue;
+      }
+
+      if (filter == MFn::kInvalid || CStandinAccess::MakeNode(node).hasFn(filter))
+      {
+         m_items.push_back(node);
+      }
+
+      // Reversed so that the first connections are visited first
+      for (size_t i=node->connections.size(); i>0; --i)
+      {
+         const CStandinConnection &conn = gConnections[node->connections[i-1]];
+         const MPlug &self = (direction == kUpstream ? conn.dst : conn.src);
+         const MPlug &other = (direction == kUpstream ? conn.src : conn.dst);
+
+         if (CStandinAccess::Node(self) == node)
+         {
+            stack.push_back(CStandinAccess::Node(other));
+         }
+      }
+   }
+
+   SetStatus(status, MS::kSuccess);
+}
+
+bool MItDependencyGraph::isDone(MStatus *status) const { SetStatus(status, MS::kSuccess); return (m_current >= m_items.size()); }
+MStatus MItDependencyGraph::next() { ++m_current; return MS::kSuccess; }
+MObject MItDependencyGraph::currentItem(MStatus *status) { return thisNode(status); }
+
+MObject MItDependencyGraph::thisNode(MStatus *status)
+{
+   SetStatus(status, isDone() ? MS::kFailure : MS::kSuccess);
+   return (isDone() ? MObject() : CStandinAccess::MakeNode(m_items[m_current]));
+}
+
+// Traversal is precomputed, pruning is not supported
+MStatus MItDependencyGraph::prune() { return MS::kFailure; }
+
+// MGlobal, python commands only succeed, they are never run
+
+MStatus MGlobal::executePythonCommand(const MString &, bool, bool) { return MS::kSuccess; }
+MStatus MGlobal::executePythonCommand(const MString &, MString &result, bool, bool) { result = ""; return MS::kSuccess; }
+MStatus MGlobal::executeCommand(const MString &, bool, bool) { return MS::kSuccess; }
+MStatus MGlobal::executeCommand(const MString &, MStringArray &result, bool, bool) { result.clear(); return MS::kSuccess; }
+void MGlobal::displayInfo(const MString &) { ++gDisplayedMessages; }
+void MGlobal::displayWarning(const MString &) { ++gDisplayedMessages; }
+void MGlobal::displayError(const MString &msg) { ++gDisplayedMessages; fprintf(stderr, "// Error: %s\n", msg.asChar()); }
+MGlobal::MMayaState MGlobal::mayaState(MStatus *status) { SetStatus(status, MS::kSuccess); return kBatch; }
+
+MString MFileIO::currentFile() { return "bench.ma"; }
+
+// Messages
+
+static MCallbackId AddCallback(CStandinCallback &cb, MStatus *status)
+{
+   cb.id = gNextCallbackId++;
+   gCallbacks.push_back(cb);
+   SetStatus(status, MS::kSuccess);
+   return cb.id;
+}
+
+static CStandinCallback NewCallback(int kind, void *clientData)
+{
+   CStandinCallback cb;
+   cb.id = 0;
+   cb.kind = kind;
+   cb.msg = -1;
+   cb.func = NULL;
+   cb.strsFunc = NULL;
+   cb.connFunc = NULL;
+   cb.clientData = clientData;
+   return cb;
+}
+
+MStatus MMessage::removeCallback(MCallbackId id)
+{
+   for (std::vector<CStandinCallback>::iterator it=gCallbacks.begin(); it!=gCallbacks.end(); ++it)
+   {
+      if (it->id == id)
+      {
+         gCallbacks.erase(it);
+         return MS::kSuccess;
+      }
+   }
+   return MS::kInvalidParameter;
+}
+
+MCallbackId MSceneMessage::addCallback(Message msg, void (*func)(void*), void *clientData, MStatus *status)
+{
+   CStandinCallback cb = NewCallback(CALLBACK_SCENE, clientData);
+   cb.msg = msg;
+   cb.func = func;
+   return AddCallback(cb, status);
+}
+
+MCallbackId MSceneMessage::addStringArrayCallback(Message msg, void (*func)(const MStringArray&, void*), void *clientData, MStatus *status)
+{
+   CStandinCallback cb = NewCallback(CALLBACK_SCENE, clientData);
+   cb.msg = msg;
+   cb.strsFunc = func;
+   return AddCallback(cb, status);
+}
+
+MCallbackId MEventMessage::addEventCallback(const MString &event, void (*func)(void*), void *clientData, MStatus *status)
+{
+   CStandinCallback cb = NewCallback(CALLBACK_EVENT, clientData);
+   cb.event = event.asChar();
+   cb.func = func;
+   return AddCallback(cb, status);
+}
+
+MCallbackId MDGMessage::addConnectionCallback(void (*func)(MPlug&, MPlug&, bool, void*), void *clientData, MStatus *status)
+{
+   CStandinCallback cb = NewCallback(CALLBACK_CONNECTION, clientData);
+   cb.connFunc = func;
+   return AddCallback(cb, status);
+}
+
+// Commands
+
+MArgList::MArgList() {}
+unsigned int MArgList::length(MStatus *status) const { SetStatus(status, MS::kSuccess); return m_args.length(); }
+MStatus MArgList::addArg(const MString &arg) { return m_args.append(arg); }
+
+MString MArgList::asString(unsigned int index, MStatus *status) const
+{
+   SetStatus(status, index < m_args.length() ? MS::kSuccess : MS::kInvalidParameter);
+   return (index < m_args.length() ? m_args[index] : MString());
+}
+
+MSyntax::MSyntax() {}
+
+MStatus MSyntax::addFlag(const char *shortName, const char *longName, MArgType argType)
+{
+   Flag flag;
+   flag.shortName = shortName;
+   flag.longName = longName;
+   flag.argType = argType;
+   m_flags.push_back(flag);
+   return MS::kSuccess;
+}
+
+void MSyntax::enableQuery(bool) {}
+void MSyntax::enableEdit(bool) {}
+
+// Flags unknown to syntax take no argument
+MArgDatabase::MArgDatabase(const MSyntax &syntax, const MArgList &args, MStatus *status)
+{
+   MStatus st = MS::kSuccess;
+
+   for (unsigned int i=0; i<args.length(); ++i)
+   {
+      std::string arg = args.asString(i).asChar();
+      std::string shortName = arg.substr(1);
+      MSyntax::MArgType argType = MSyntax::kNoArg;
+
+      if (arg.length() < 2 || arg[0] != '-')
+      {
+         st = MS::kInvalidParameter;
+         break;
+      }
+
+      for (size_t j=0; j<syntax.m_flags.size(); ++j)
+      {
+         if (syntax.m_flags[j].shortName == arg || syntax.m_flags[j].shortName == shortName ||
+             syntax.m_flags[j].longName == arg || syntax.m_flags[j].longName == shortName)
+         {
+            shortName = syntax.m_flags[j].shortName;
+            argType = syntax.m_flags[j].argType;
+         }
+      }
+
+      if (shortName.length() > 0 && shortName[0] == '-')
+      {
+         shortName = shortName.substr(1);
+      }
+
+      if (argType != MSyntax::kNoArg && i + 1 < args.length())
+      {
+         m_flags.push_back(std::make_pair(shortName, args.asString(++i)));
+      }
+      else
+      {
+         m_flags.push_back(std::make_pair(shortName, MString()));
+      }
+   }
+
+   SetStatus(status, st.statusCode());
+}
+
+static std::string FlagName(const char *flag)
+{
+   return (flag && flag[0] == '-' ? flag + 1 : (flag ? flag : ""));
+}
+
+bool MArgDatabase::isFlagSet(const char *flag, MStatus *status) const
+{
+   std::string name = FlagName(flag);
+   SetStatus(status, MS::kSuccess);
+   for (size_t i=0; i<m_flags.size(); ++i)
+   {
+      if (m_flags[i].first == name)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+MStatus MArgDatabase::getFlagArgument(const char *flag, unsigned int, MString &result) const
+{
+   std::string name = FlagName(flag);
+   for (size_t i=0; i<m_flags.size(); ++i)
+   {
+      if (m_flags[i].first == name)
+      {
+         result = m_flags[i].second;
+         return MS::kSuccess;
+      }
+   }
+   return MS::kInvalidParameter;
+}
+
+MStatus MArgDatabase::getFlagArgument(const char *flag, unsigned int index, bool &result) const
+{
+   MString value;
+   MStatus status = getFlagArgument(flag, index, value);
+   result = (value == "1" || value == "true" || value == "on");
+   return status;
+}
+
+MPxCommand::MPxCommand() {}
+MPxCommand::~MPxCommand() {}
+bool MPxCommand::isUndoable() const { return false; }
+MSyntax MPxCommand::syntax() const { return MSyntax(); }
+void MPxCommand::setResult(const MString &result) { gCommandResult.clear(); gCommandResult.append(result); }
+void MPxCommand::setResult(const MStringArray &result) { gCommandResult = result; }
+void MPxCommand::setResult(int result) { MString s; s.set(result, 0); setResult(s); }
+void MPxCommand::setResult(double result) { MString s; s.set(result); setResult(s); }
+void MPxCommand::appendToResult(const MString &result) { gCommandResult.append(result); }
+void MPxCommand::appendToResult(double result) { MString s; s.set(result); appendToResult(s); }
+void MPxCommand::clearResult() { gCommandResult.clear(); }
+
+// MFnPlugin, plugins are loaded through StandinLoadPlugin
+
+MFnPlugin::MFnPlugin() {}
+
+MFnPlugin::MFnPlugin(MObject &object, const char *, const char *, const char *, MStatus *status)
+{
+   SetStatus(status, MS::kSuccess);
+   m_object = object;
+}
+
+MString MFnPlugin::loadPath(MStatus *status) const
+{
+   SetStatus(status, MS::kSuccess);
+   return "/standin/plug-ins";
+}
+
+MStatus MFnPlugin::registerCommand(const MString &, void* (*)(), MSyntax (*)()) { return MS::kSuccess; }
+MStatus MFnPlugin::deregisterCommand(const MString &) { return MS::kSuccess; }
+
+MObject MFnPlugin::findPlugin(const MString &pluginName)
+{
+   if (gPlugins.find(pluginName.asChar()) == gPlugins.end())
+   {
+      return MObject();
+   }
+
+   CStandinData *data = new CStandinData();
+   data->plugin = true;
+
+   return CStandinAccess::MakeData(data);
+}
@@ -0,0 +1 @@
+#include "MStandin.h"
@@ -0,0 +1,750 @@
+#ifndef __standin_maya_h__
+#define __standin_maya_h__
+
+// Stand-in for the subset of the maya API used by the extension (benchmark only)
+//   every maya/*.h header of this directory includes this one
+//   nodes, attributes and connections live in a small in-memory graph built through standin.h
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#ifndef MAYA_API_VERSION
+#  define MAYA_API_VERSION 20180000
+#endif
+
+#define CHECK_MSTATUS(status) ((void)(status))
+
+struct CStandinNode;
+struct CStandinAttribute;
+struct CStandinData;
+struct CStandinAccess;
+
+class MStringArray;
+class MPlug;
+class MPlugArray;
+class MDagPath;
+
+class MStatus
+{
+public:
+
+   enum MStatusCode
+   {
+      kSuccess = 0,
+      kFailure,
+      kInvalidParameter,
+      kNotFound
+   };
+
+   MStatus() : m_code(kSuccess) {}
+   MStatus(MStatusCode code) : m_code(code) {}
+
+   inline bool operator==(const MStatus &rhs) const { return (m_code == rhs.m_code); }
+   inline bool operator!=(const MStatus &rhs) const { return (m_code != rhs.m_code); }
+   inline bool operator==(MStatusCode code) const { return (m_code == code); }
+   inline bool operator!=(MStatusCode code) const { return (m_code != code); }
+   inline operator bool() const { return (m_code == kSuccess); }
+   inline MStatusCode statusCode() const { return m_code; }
+
+private:
+
+   MStatusCode m_code;
+};
+
+namespace MS
+{
+   const MStatus::MStatusCode kSuccess = MStatus::kSuccess;
+   const MStatus::MStatusCode kFailure = MStatus::kFailure;
+   const MStatus::MStatusCode kInvalidParameter = MStatus::kInvalidParameter;
+   const MStatus::MStatusCode kNotFound = MStatus::kNotFound;
+}
+
+class MString
+{
+public:
+
+   MString();
+   MString(const char *str);
+   MString(const MString &rhs);
+   ~MString();
+
+   MString& operator=(const MString &rhs);
+   MString& operator=(const char *str);
+   MString& operator+=(const MString &rhs);
+   MString& operator+=(const char *str);
+   MString operator+(const MString &rhs) const;
+   MString operator+(const char *str) const;
+   friend MString operator+(const char *str, const MString &rhs);
+
+   bool operator==(const MString &rhs) const;
+   bool operator!=(const MString &rhs) const;
+   bool operator==(const char *str) const;
+   bool operator!=(const char *str) const;
+
+   const char* asChar() const;
+   int asInt() const;
+   float asFloat() const;
+   double asDouble() const;
+   bool isInt() const;
+   unsigned int length() const;
+   int indexW(const MString &str) const;
+   int indexW(char c) const;
+   MString substring(int start, int end) const;
+   MString& set(double value, int precision=6);
+   MStatus split(char c, MStringArray &result) const;
+   MString expandEnvironmentVariablesAndTilde(MStatus *status=NULL) const;
+
+private:
+
+   std::string m_str;
+};
+
+class MStringArray
+{
+public:
+
+   MStringArray();
+
+   unsigned int length() const;
+   MString& operator[](unsigned int i);
+   const MString& operator[](unsigned int i) const;
+   MStatus append(const MString &str);
+   MStatus clear();
+
+private:
+
+   std::vector<MString> m_strs;
+};
+
+namespace MFn
+{
+   enum Type
+   {
+      kInvalid = 0,
+      kBase,
+      kNamedObject,
+      kDependencyNode,
+      kDagNode,
+      kTransform,
+      kShape,
+      kMesh,
+      kCamera,
+      kShadingEngine,
+      kLambert,
+      kAnimCurve,
+      kTime,
+      kRenderLayer,
+      kAttribute,
+      kMatrixData,
+      kPluginDependNode,
+      kPluginShape
+   };
+}
+
+// Null object, node, attribute or data (matrix)
+class MObject
+{
+public:
+
+   MObject();
+   MObject(const MObject &rhs);
+   ~MObject();
+
+   MObject& operator=(const MObject &rhs);
+   bool operator==(const MObject &rhs) const;
+   bool operator!=(const MObject &rhs) const;
+
+   bool isNull() const;
+   MFn::Type apiType() const;
+   bool hasFn(MFn::Type type) const;
+
+   static const MObject kNullObj;
+
+private:
+
+   friend struct CStandinAccess;
+
+   enum Kind
+   {
+      kNone = 0,
+      kNode,
+      kAttr,
+      kData
+   };
+
+   Kind m_kind;
+   void *m_ptr;
+};
+
+class MObjectArray
+{
+public:
+
+   MObjectArray();
+
+   unsigned int length() const;
+   MObject& operator[](unsigned int i);
+   const MObject& operator[](unsigned int i) const;
+   MStatus append(const MObject &obj);
+   MStatus clear();
+
+private:
+
+   std::vector<MObject> m_objs;
+};
+
+class MObjectHandle
+{
+public:
+
+   MObjectHandle();
+   MObjectHandle(const MObject &obj);
+
+   MObject object() const;
+   bool isValid() const;
+   bool isAlive() const;
+   unsigned int hashCode() const;
+
+   bool operator==(const MObject &obj) const;
+   bool operator==(const MObjectHandle &rhs) const;
+   bool operator!=(const MObjectHandle &rhs) const;
+
+private:
+
+   MObject m_object;
+};
+
+class MTime
+{
+public:
+
+   enum Unit
+   {
+      kInvalid = 0,
+      kHours,
+      kMinutes,
+      kSeconds,
+      kMilliseconds,
+      kGames,
+      kFilm,
+      kPALFrame,
+      kNTSCFrame
+   };
+
+   MTime();
+   MTime(double value, Unit unit=kFilm);
+
+   double value() const;
+   Unit unit() const;
+   double as(Unit unit) const;
+
+   bool operator==(const MTime &rhs) const;
+   bool operator!=(const MTime &rhs) const;
+
+   static Unit uiUnit();
+
+private:
+
+   double m_value;
+   Unit m_unit;
+};
+
+class MAnimControl
+{
+public:
+
+   static MTime currentTime();
+   static MStatus setCurrentTime(const MTime &time);
+};
+
+class MDGContext
+{
+public:
+
+   MDGContext();
+   MDGContext(const MTime &time);
+
+   bool isNormal() const;
+   MStatus getTime(MTime &time) const;
+
+   static MDGContext fsNormal;
+
+private:
+
+   bool m_normal;
+   MTime m_time;
+};
+
+// Plugs are evaluated at the innermost guarded context time
+class MDGContextGuard
+{
+public:
+
+   MDGContextGuard(const MDGContext &context);
+   ~MDGContextGuard();
+
+private:
+
+   MDGContextGuard(const MDGContextGuard&);
+   MDGContextGuard& operator=(const MDGContextGuard&);
+
+   MDGContext m_previous;
+};
+
+class MPoint
+{
+public:
+
+   MPoint();
+   MPoint(double x, double y, double z, double w=1.0);
+
+   double x, y, z, w;
+};
+
+class MMatrix
+{
+public:
+
+   MMatrix();
+
+   double operator()(unsigned int row, unsigned int col) const;
+   MMatrix operator*(const MMatrix &rhs) const;
+   bool isEquivalent(const MMatrix &rhs, double tolerance=1.0e-10) const;
+
+   double matrix[4][4];
+};
+
+class MBoundingBox
+{
+public:
+
+   MBoundingBox();
+   MBoundingBox(const MPoint &corner1, const MPoint &corner2);
+
+   MPoint min() const;
+   MPoint max() const;
+   void clear();
+   void expand(const MPoint &point);
+   void expand(const MBoundingBox &box);
+   MBoundingBox& transformUsing(const MMatrix &matrix);
+
+private:
+
+   bool m_empty;
+   MPoint m_min;
+   MPoint m_max;
+};
+
+class MPlug
+{
+public:
+
+   enum MValueSelector
+   {
+      kAll = 0,
+      kNonDefault,
+      kChanged,
+      kLastAttrSelector
+   };
+
+   MPlug();
+   MPlug(const MObject &node, const MObject &attribute);
+
+   bool isNull(MStatus *status=NULL) const;
+   MObject node(MStatus *status=NULL) const;
+   MObject attribute(MStatus *status=NULL) const;
+   MString name(MStatus *status=NULL) const;
+   MString partialName(bool includeNodeName=false) const;
+
+   bool isArray(MStatus *status=NULL) const;
+   bool isElement(MStatus *status=NULL) const;
+   bool isCompound(MStatus *status=NULL) const;
+   bool isDynamic(MStatus *status=NULL) const;
+   bool isConnected(MStatus *status=NULL) const;
+   bool isSource(MStatus *status=NULL) const;
+   bool isDestination(MStatus *status=NULL) const;
+   unsigned int logicalIndex(MStatus *status=NULL) const;
+   unsigned int numElements(MStatus *status=NULL) const;
+   MPlug elementByLogicalIndex(unsigned int index, MStatus *status=NULL) const;
+   MPlug array(MStatus *status=NULL) const;
+
+   bool connectedTo(MPlugArray &plugs, bool asDst, bool asSrc, MStatus *status=NULL) const;
+
+   bool asBool(MStatus *status=NULL) const;
+   short asShort(MStatus *status=NULL) const;
+   int asInt(MStatus *status=NULL) const;
+   float asFloat(MStatus *status=NULL) const;
+   double asDouble(MStatus *status=NULL) const;
+   MString asString(MStatus *status=NULL) const;
+   MObject asMObject(MStatus *status=NULL) const;
+
+   MStatus getValue(MObject &value, MDGContext &context=MDGContext::fsNormal) const;
+   MStatus getValue(double &value, MDGContext &context=MDGContext::fsNormal) const;
+   MStatus getSetAttrCmds(MStringArray &cmds, MValueSelector valueSelector=kAll, bool useLongNames=false);
+
+   bool operator==(const MPlug &rhs) const;
+   bool operator!=(const MPlug &rhs) const;
+
+private:
+
+   friend struct CStandinAccess;
+
+   CStandinNode *m_node;
+   CStandinAttribute *m_attr;
+   // Logical index, -1 for non element plugs
+   int m_index;
+};
+
+class MPlugArray
+{
+public:
+
+   MPlugArray();
+
+   unsigned int length() const;
+   MPlug& operator[](unsigned int i);
+   const MPlug& operator[](unsigned int i) const;
+   MStatus append(const MPlug &plug);
+   MStatus clear();
+
+private:
+
+   std::vector<MPlug> m_plugs;
+};
+
+class MDagPath
+{
+public:
+
+   MDagPath();
+
+   bool isValid(MStatus *status=NULL) const;
+   MObject node(MStatus *status=NULL) const;
+   MObject transform(MStatus *status=NULL) const;
+   unsigned int length(MStatus *status=NULL) const;
+   MStatus pop(unsigned int num=1);
+   bool isInstanced(MStatus *status=NULL) const;
+   unsigned int instanceNumber(MStatus *status=NULL) const;
+   MString fullPathName(MStatus *status=NULL) const;
+   MString partialPathName(MStatus *status=NULL) const;
+   MMatrix inclusiveMatrix(MStatus *status=NULL) const;
+   MMatrix exclusiveMatrix(MStatus *status=NULL) const;
+
+   bool operator==(const MDagPath &rhs) const;
+
+   static MStatus getAPathTo(const MObject &node, MDagPath &path);
+
+private:
+
+   friend struct CStandinAccess;
+
+   // From the top most transform down to the path node
+   std::vector<CStandinNode*> m_nodes;
+};
+
+class MFnBase
+{
+public:
+
+   MFnBase();
+   virtual ~MFnBase();
+
+   MObject object(MStatus *status=NULL) const;
+   virtual MStatus setObject(const MObject &object);
+
+protected:
+
+   MObject m_object;
+};
+
+class MFnDependencyNode : public MFnBase
+{
+public:
+
+   MFnDependencyNode();
+   MFnDependencyNode(const MObject &object, MStatus *status=NULL);
+
+   MString name(MStatus *status=NULL) const;
+   MString typeName(MStatus *status=NULL) const;
+   unsigned int attributeCount(MStatus *status=NULL) const;
+   MObject attribute(unsigned int index, MStatus *status=NULL) const;
+   MObject attribute(const MString &attrName, MStatus *status=NULL) const;
+   bool hasAttribute(const MString &attrName, MStatus *status=NULL) const;
+   MPlug findPlug(const MString &attrName, bool wantNetworkedPlug=true, MStatus *status=NULL) const;
+   MStatus getConnections(MPlugArray &plugs) const;
+   bool isFromReferencedFile(MStatus *status=NULL) const;
+
+   static MString classification(const MString &nodeTypeName);
+};
+
+class MFnDagNode : public MFnDependencyNode
+{
+public:
+
+   MFnDagNode();
+   MFnDagNode(const MObject &object, MStatus *status=NULL);
+
+   MBoundingBox boundingBox(MStatus *status=NULL) const;
+   MStatus getPath(MDagPath &path) const;
+};
+
+class MFnAttribute : public MFnBase
+{
+public:
+
+   MFnAttribute();
+   MFnAttribute(const MObject &object, MStatus *status=NULL);
+
+   MString name(MStatus *status=NULL) const;
+   MString shortName(MStatus *status=NULL) const;
+   MObject parent(MStatus *status=NULL) const;
+   bool isArray(MStatus *status=NULL) const;
+   bool isWritable(MStatus *status=NULL) const;
+   bool isStorable(MStatus *status=NULL) const;
+   bool isHidden(MStatus *status=NULL) const;
+   bool isUsedAsFilename(MStatus *status=NULL) const;
+};
+
+class MFnMatrixData : public MFnBase
+{
+public:
+
+   MFnMatrixData();
+   MFnMatrixData(const MObject &object, MStatus *status=NULL);
+
+   MMatrix matrix(MStatus *status=NULL) const;
+   MObject create(const MMatrix &matrix, MStatus *status=NULL);
+};
+
+class MFnRenderLayer : public MFnDependencyNode
+{
+public:
+
+   static MObject currentLayer(MStatus *status=NULL);
+};
+
+class MNodeClass
+{
+public:
+
+   MNodeClass(const MString &typeName);
+
+   MString typeName(MStatus *status=NULL) const;
+   MObject attribute(const MString &attrName, MStatus *status=NULL) const;
+   MStatus getAttributes(MObjectArray &attrs);
+
+private:
+
+   std::string m_typeName;
+};
+
+// Node level upstream traversal only, the root node is the first item
+class MItDependencyGraph
+{
+public:
+
+   enum Direction
+   {
+      kDownstream = 0,
+      kUpstream
+   };
+
+   enum Traversal
+   {
+      kDepthFirst = 0,
+      kBreadthFirst
+   };
+
+   enum Level
+   {
+      kNodeLevel = 0,
+      kPlugLevel
+   };
+
+   MItDependencyGraph(MObject &rootNode, MFn::Type filter=MFn::kInvalid, Direction direction=kDownstream,
+                      Traversal traversal=kDepthFirst, Level level=kNodeLevel, MStatus *status=NULL);
+
+   bool isDone(MStatus *status=NULL) const;
+   MStatus next();
+   MObject currentItem(MStatus *status=NULL);
+   MObject thisNode(MStatus *status=NULL);
+   MStatus prune();
+
+private:
+
+   std::vector<CStandinNode*> m_items;
+   size_t m_current;
+};
+
+class MGlobal
+{
+public:
+
+   enum MMayaState
+   {
+      kInteractive = 0,
+      kBatch,
+      kLibraryApp,
+      kBaseUIMode
+   };
+
+   static MStatus executePythonCommand(const MString &command, bool displayEnabled=false, bool undoEnabled=false);
+   static MStatus executePythonCommand(const MString &command, MString &result, bool displayEnabled=false, bool undoEnabled=false);
+   static MStatus executeCommand(const MString &command, bool displayEnabled=false, bool undoEnabled=false);
+   static MStatus executeCommand(const MString &command, MStringArray &result, bool displayEnabled=false, bool undoEnabled=false);
+   static void displayInfo(const MString &msg);
+   static void displayWarning(const MString &msg);
+   static void displayError(const MString &msg);
+   static MMayaState mayaState(MStatus *status=NULL);
+};
+
+class MFileIO
+{
+public:
+
+   static MString currentFile();
+};
+
+typedef unsigned long MCallbackId;
+
+class MMessage
+{
+public:
+
+   static MStatus removeCallback(MCallbackId id);
+};
+
+class MSceneMessage : public MMessage
+{
+public:
+
+   enum Message
+   {
+      kBeforeNew = 0,
+      kAfterNew,
+      kBeforeOpen,
+      kAfterOpen,
+      kAfterPluginLoad,
+      kAfterPluginUnload
+   };
+
+   static MCallbackId addCallback(Message msg, void (*func)(void*), void *clientData=NULL, MStatus *status=NULL);
+   static MCallbackId addStringArrayCallback(Message msg, void (*func)(const MStringArray&, void*), void *clientData=NULL, MStatus *status=NULL);
+};
+
+class MEventMessage : public MMessage
+{
+public:
+
+   static MCallbackId addEventCallback(const MString &event, void (*func)(void*), void *clientData=NULL, MStatus *status=NULL);
+};
+
+class MDGMessage : public MMessage
+{
+public:
+
+   static MCallbackId addConnectionCallback(void (*func)(MPlug&, MPlug&, bool, void*), void *clientData=NULL, MStatus *status=NULL);
+};
+
+class MArgList
+{
+public:
+
+   MArgList();
+
+   unsigned int length(MStatus *status=NULL) const;
+   MStatus addArg(const MString &arg);
+   MString asString(unsigned int index, MStatus *status=NULL) const;
+
+private:
+
+   MStringArray m_args;
+};
+
+class MSyntax
+{
+public:
+
+   enum MArgType
+   {
+      kNoArg = 0,
+      kBoolean,
+      kLong,
+      kDouble,
+      kString
+   };
+
+   MSyntax();
+
+   MStatus addFlag(const char *shortName, const char *longName, MArgType argType=kNoArg);
+   void enableQuery(bool supportsQuery);
+   void enableEdit(bool supportsEdit);
+
+private:
+
+   friend class MArgDatabase;
+
+   struct Flag
+   {
+      std::string shortName;
+      std::string longName;
+      MArgType argType;
+   };
+
+   std::vector<Flag> m_flags;
+};
+
+class MArgDatabase
+{
+public:
+
+   MArgDatabase(const MSyntax &syntax, const MArgList &args, MStatus *status=NULL);
+
+   bool isFlagSet(const char *flag, MStatus *status=NULL) const;
+   MStatus getFlagArgument(const char *flag, unsigned int index, MString &result) const;
+   MStatus getFlagArgument(const char *flag, unsigned int index, bool &result) const;
+
+private:
+
+   // Short flag name and argument, if any
+   std::vector<std::pair<std::string, MString> > m_flags;
+};
+
+class MPxCommand
+{
+public:
+
+   MPxCommand();
+   virtual ~MPxCommand();
+
+   virtual MStatus doIt(const MArgList &args) = 0;
+   virtual bool isUndoable() const;
+
+   // Empty, the stand-in doesn't keep the syntax the command was registered with
+   MSyntax syntax() const;
+
+   static void setResult(const MString &result);
+   static void setResult(const MStringArray &result);
+   static void setResult(int result);
+   static void setResult(double result);
+   static void appendToResult(const MString &result);
+   static void appendToResult(double result);
+   static void clearResult();
+};
+
+class MFnPlugin : public MFnBase
+{
+public:
+
+   MFnPlugin();
+   MFnPlugin(MObject &object, const char *vendor="", const char *version="", const char *requiredApiVersion="", MStatus *status=NULL);
+
+   MString loadPath(MStatus *status=NULL) const;
+   MStatus registerCommand(const MString &commandName, void* (*creator)(), MSyntax (*createSyntax)()=NULL);
+   MStatus deregisterCommand(const MString &commandName);
+
+   static MObject findPlugin(const MString &pluginName);
+};
+
+#endif
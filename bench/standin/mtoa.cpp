@@ -0,0 +1,711 @@
+#include "standin.h"
+#include "translators/shape/ShapeTranslator.h"
+#include <cctype>
+
+// MtoA stand-in: translators are driven by CStandinSession, shaders are plain "standard" nodes
+
+// CNodeTranslator
+
+CNodeTranslator::CNodeTranslator()
+   : m_session(NULL)
+   , m_updateMode(AI_UPDATE_ONLY)
+   , m_exported(false)
+{
+}
+
+CNodeTranslator::~CNodeTranslator()
+{
+}
+
+void CNodeTranslator::Init()
+{
+}
+
+void CNodeTranslator::Export(AtNode *)
+{
+}
+
+void CNodeTranslator::ExportMotion(AtNode *)
+{
+}
+
+bool CNodeTranslator::RequiresMotionData()
+{
+   return false;
+}
+
+void CNodeTranslator::RequestUpdate()
+{
+}
+
+void CNodeTranslator::NodeChanged(MObject &, MPlug &)
+{
+   RequestUpdate();
+}
+
+void CNodeTranslator::Delete()
+{
+}
+
+CNodeTranslator* CNodeTranslator::GetTranslator(const MDagPath &dagPath)
+{
+   CStandinSession *session = CStandinSession::GetCurrent();
+   return (session ? session->FindTranslator(dagPath) : NULL);
+}
+
+AtNode* CNodeTranslator::GetArnoldNode(const char *tag)
+{
+   std::string key = (tag ? tag : "");
+
+   for (size_t i=0; i<m_nodes.size(); ++i)
+   {
+      if (m_nodes[i].first == key)
+      {
+         return m_nodes[i].second;
+      }
+   }
+
+   return NULL;
+}
+
+MObject CNodeTranslator::GetMayaObject() const
+{
+   return m_object;
+}
+
+MString CNodeTranslator::GetMayaNodeName() const
+{
+   return MFnDependencyNode(m_object).name();
+}
+
+bool CNodeTranslator::IsExported() const
+{
+   return m_exported;
+}
+
+AtNode* CNodeTranslator::AddArnoldNode(const char *type, const char *tag)
+{
+   std::string key = (tag ? tag : "");
+   AtNode *node = AiNode(type);
+
+   if (!node)
+   {
+      return NULL;
+   }
+
+   AiNodeSetStr(node, "name", (key.length() > 0 ? m_name + "@" + key : m_name).c_str());
+
+   bool found = false;
+
+   for (size_t i=0; i<m_nodes.size() && !found; ++i)
+   {
+      if (m_nodes[i].first == key)
+      {
+         m_nodes[i].second = node;
+         found = true;
+      }
+   }
+
+   if (!found)
+   {
+      m_nodes.push_back(std::make_pair(key, node));
+   }
+
+   if (m_session)
+   {
+      m_session->m_nodes.push_back(node);
+   }
+
+   return node;
+}
+
+MPlug CNodeTranslator::FindMayaPlug(const MString &attrName, MStatus *status) const
+{
+   return MFnDependencyNode(m_object).findPlug(attrName, true, status);
+}
+
+AtNode* CNodeTranslator::ExportConnectedNode(const MPlug &outputPlug)
+{
+   return ((m_session && !outputPlug.isNull()) ? m_session->ExportShader(outputPlug.node()) : NULL);
+}
+
+void CNodeTranslator::SetUpdateMode(int mode)
+{
+   m_updateMode = mode;
+}
+
+double CNodeTranslator::GetExportFrame() const
+{
+   return (m_session ? m_session->m_frame : MAnimControl::currentTime().value());
+}
+
+bool CNodeTranslator::IsExportingMotion() const
+{
+   return (m_session && m_session->m_exportingMotion);
+}
+
+unsigned int CNodeTranslator::GetMotionStep() const
+{
+   return (m_session ? m_session->m_motionStep : 0);
+}
+
+unsigned int CNodeTranslator::GetNumMotionSteps() const
+{
+   return ((m_session && m_session->m_motionFrames.size() > 1) ? (unsigned int) m_session->m_motionFrames.size() : 1);
+}
+
+const double* CNodeTranslator::GetMotionFrames(unsigned int &count) const
+{
+   if (!m_session || m_session->m_motionFrames.size() == 0)
+   {
+      count = 0;
+      return NULL;
+   }
+
+   count = (unsigned int) m_session->m_motionFrames.size();
+
+   return &(m_session->m_motionFrames[0]);
+}
+
+// All motion blur types are enabled together
+bool CNodeTranslator::IsMotionBlurEnabled(int) const
+{
+   return (GetNumMotionSteps() > 1);
+}
+
+bool CNodeTranslator::IsLocalMotionBlurEnabled() const
+{
+   MStatus status;
+   MPlug plug = FindMayaPlug("motionBlur", &status);
+
+   return (status != MS::kSuccess || plug.isNull() || plug.asBool());
+}
+
+bool CNodeTranslator::RequiresShaderExport() const
+{
+   return true;
+}
+
+// CDagTranslator
+
+void CDagTranslator::Init()
+{
+   CNodeTranslator::Init();
+}
+
+CDagTranslator* CDagTranslator::ExportDagPath(const MDagPath &dagPath)
+{
+   return dynamic_cast<CDagTranslator*>(CNodeTranslator::GetTranslator(dagPath));
+}
+
+bool CDagTranslator::IsMasterInstance()
+{
+   return (m_dagPath == m_masterDagPath);
+}
+
+MDagPath& CDagTranslator::GetMasterInstance()
+{
+   return m_masterDagPath;
+}
+
+void CDagTranslator::ConvertMatrix(AtMatrix &matrix, const MMatrix &mayaMatrix)
+{
+   for (int i=0; i<4; ++i)
+   {
+      for (int j=0; j<4; ++j)
+      {
+         matrix[i][j] = (float) mayaMatrix.matrix[i][j];
+      }
+   }
+}
+
+// There are no lights in the stand-in scenes
+void CDagTranslator::ExportLightLinking(AtNode *atNode)
+{
+   AiNodeSetBool(atNode, "use_light_group", false);
+   AiNodeSetBool(atNode, "use_shadow_group", false);
+}
+
+void CDagTranslator::ExportTraceSets(AtNode *atNode, const MPlug &traceSetsPlug)
+{
+   MStringArray sets;
+
+   traceSetsPlug.asString().split(' ', sets);
+
+   AtArray *array = AiArrayAllocate(sets.length(), 1, AI_TYPE_STRING);
+
+   for (unsigned int i=0; i<sets.length(); ++i)
+   {
+      AiArraySetStr(array, i, sets[i].asChar());
+   }
+
+   AiNodeSetArray(atNode, "trace_sets", array);
+}
+
+// CShapeTranslator
+
+MPlug GetNodeShadingGroup(MObject dagNode, int instanceNum)
+{
+   MFnDependencyNode fnNode(dagNode);
+   MPlug plug = fnNode.findPlug("instObjGroups");
+   MPlugArray dsts;
+
+   if (plug.isNull())
+   {
+      return MPlug();
+   }
+
+   plug = plug.elementByLogicalIndex(instanceNum);
+   plug.connectedTo(dsts, false, true);
+
+   for (unsigned int i=0; i<dsts.length(); ++i)
+   {
+      if (dsts[i].node().apiType() == MFn::kShadingEngine)
+      {
+         return dsts[i];
+      }
+   }
+
+   return MPlug();
+}
+
+void CShapeTranslator::Init()
+{
+   CDagTranslator::Init();
+}
+
+void CShapeTranslator::MakeCommonAttributes(CBaseAttrHelper &helper)
+{
+   helper.MakeInput("self_shadows");
+   helper.MakeInput("opaque");
+   helper.MakeInput("matte");
+   helper.MakeInput("sss_setname");
+
+   CAttrData data;
+
+   data.type = AI_TYPE_BOOLEAN;
+   data.defaultValue.BOOL = true;
+   data.name = "aiVisibleInDiffuse";
+   data.shortName = "ai_vid";
+   helper.MakeInput(data);
+
+   data.name = "aiVisibleInGlossy";
+   data.shortName = "ai_vig";
+   helper.MakeInput(data);
+
+   data.type = AI_TYPE_STRING;
+   data.defaultValue.STR = "";
+   data.name = "aiTraceSets";
+   data.shortName = "ai_trace_sets";
+   helper.MakeInput(data);
+}
+
+// Attribute helpers
+
+CAttrData::CAttrData()
+   : type(AI_TYPE_UNDEFINED)
+   , isArray(false)
+   , keyable(true)
+   , hasMin(false)
+   , hasMax(false)
+   , hasSoftMin(false)
+   , hasSoftMax(false)
+   , linkable(true)
+{
+   memset(&defaultValue, 0, sizeof(AtParamValue));
+   memset(&min, 0, sizeof(AtParamValue));
+   memset(&max, 0, sizeof(AtParamValue));
+   memset(&softMin, 0, sizeof(AtParamValue));
+   memset(&softMax, 0, sizeof(AtParamValue));
+}
+
+CBaseAttrHelper::CBaseAttrHelper(const AtNodeEntry *nodeEntry, const MString &prefix)
+   : m_nodeEntry(nodeEntry)
+   , m_prefix(prefix)
+{
+}
+
+CBaseAttrHelper::~CBaseAttrHelper()
+{
+}
+
+// Maya attributes are named <prefix><CamelCaseParam> (short name ai_<param>)
+bool CBaseAttrHelper::GetAttrData(const char *paramName, CAttrData &data)
+{
+   const AtParamEntry *pentry = AiNodeEntryLookUpParameter(m_nodeEntry, paramName);
+
+   if (!pentry)
+   {
+      return false;
+   }
+
+   std::string name = m_prefix.asChar();
+   bool upper = true;
+
+   for (const char *c=paramName; *c != '\0'; ++c)
+   {
+      if (*c == '_')
+      {
+         upper = true;
+         continue;
+      }
+      name += (upper ? (char) toupper(*c) : *c);
+      upper = false;
+   }
+
+   data.name = name.c_str();
+   data.shortName = MString("ai_") + paramName;
+   data.type = AiParamGetType(pentry);
+   data.defaultValue = *AiParamGetDefault(pentry);
+   data.isArray = false;
+
+   if (data.type == AI_TYPE_ARRAY)
+   {
+      data.isArray = true;
+      data.type = (data.defaultValue.ARRAY ? data.defaultValue.ARRAY->type : AI_TYPE_UNDEFINED);
+   }
+
+   data.hasMin = data.hasMax = data.hasSoftMin = data.hasSoftMax = false;
+   data.keyable = true;
+   data.linkable = (data.type != AI_TYPE_STRING && data.type != AI_TYPE_NODE);
+
+   return true;
+}
+
+void CBaseAttrHelper::MakeInput(const char *paramName)
+{
+   CAttrData data;
+
+   if (GetAttrData(paramName, data))
+   {
+      AddAttribute(data);
+   }
+}
+
+void CBaseAttrHelper::MakeInput(CAttrData &data)
+{
+   AddAttribute(data);
+}
+
+MStatus CBaseAttrHelper::AddAttribute(CAttrData &)
+{
+   return MS::kFailure;
+}
+
+CExtensionAttrHelper::CExtensionAttrHelper(MString nodeType, const AtNodeEntry *nodeEntry, const MString &prefix)
+   : CBaseAttrHelper(nodeEntry, prefix)
+   , m_nodeType(nodeType)
+{
+}
+
+CExtensionAttrHelper::CExtensionAttrHelper(MString nodeType, const char *nodeEntryName, const MString &prefix)
+   : CBaseAttrHelper(AiNodeEntryLookUp(nodeEntryName), prefix)
+   , m_nodeType(nodeType)
+{
+}
+
+CExtensionAttrHelper::~CExtensionAttrHelper()
+{
+}
+
+// Compound values (colors, vectors, matrices) are added as a single numeric attribute
+MStatus CExtensionAttrHelper::AddAttribute(CAttrData &data)
+{
+   StandinAttrType type = STANDIN_ATTR_NUMERIC;
+   double defaultValue = 0.0;
+
+   switch (data.type)
+   {
+   case AI_TYPE_STRING:
+      type = STANDIN_ATTR_STRING;
+      break;
+   case AI_TYPE_NODE:
+      type = STANDIN_ATTR_MESSAGE;
+      break;
+   case AI_TYPE_BYTE:
+      defaultValue = (data.isArray ? 0.0 : data.defaultValue.BYTE);
+      break;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      defaultValue = (data.isArray ? 0.0 : data.defaultValue.INT);
+      break;
+   case AI_TYPE_UINT:
+      defaultValue = (data.isArray ? 0.0 : data.defaultValue.UINT);
+      break;
+   case AI_TYPE_BOOLEAN:
+      defaultValue = ((!data.isArray && data.defaultValue.BOOL) ? 1.0 : 0.0);
+      break;
+   case AI_TYPE_FLOAT:
+      defaultValue = (data.isArray ? 0.0 : data.defaultValue.FLT);
+      break;
+   case AI_TYPE_UNDEFINED:
+      return MS::kInvalidParameter;
+   default:
+      break;
+   }
+
+   return (StandinAddAttribute(m_nodeType.asChar(), data.name.asChar(), data.shortName.asChar(), type, data.isArray, defaultValue)
+           ? MS::kSuccess : MS::kFailure);
+}
+
+// Extension
+
+CAbTranslator::CAbTranslator()
+{
+}
+
+CAbTranslator::CAbTranslator(const MString &translatorName, const MString &arnoldNodeName, const MString &mayaNodeName, const MString &providerName)
+   : name(translatorName)
+   , arnold(arnoldNodeName)
+   , maya(mayaNodeName)
+   , provider(providerName)
+{
+}
+
+CExtension::CExtension(const MString &extensionFile)
+   : m_file(extensionFile)
+{
+}
+
+MStatus CExtension::RegisterTranslator(const MString &mayaTypeName, const MString &translatorName,
+                                       TCreatorFunction creatorFunction, TNodeInitFunction nodeInitFunction)
+{
+   if (!creatorFunction || FindCreator(mayaTypeName))
+   {
+      return MS::kFailure;
+   }
+
+   CTranslatorEntry entry;
+
+   entry.mayaTypeName = mayaTypeName;
+   entry.translatorName = translatorName;
+   entry.creator = creatorFunction;
+   entry.nodeInit = nodeInitFunction;
+
+   m_translators.push_back(entry);
+
+   return MS::kSuccess;
+}
+
+MString CExtension::GetExtensionFile() const
+{
+   return m_file;
+}
+
+unsigned int CExtension::InitializeTranslators()
+{
+   unsigned int count = 0;
+
+   for (size_t i=0; i<m_translators.size(); ++i)
+   {
+      if (m_translators[i].nodeInit)
+      {
+         m_translators[i].nodeInit(CAbTranslator(m_translators[i].translatorName, "", m_translators[i].mayaTypeName, "mtoa"));
+         ++count;
+      }
+   }
+
+   return count;
+}
+
+TCreatorFunction CExtension::FindCreator(const MString &mayaTypeName) const
+{
+   for (size_t i=0; i<m_translators.size(); ++i)
+   {
+      if (m_translators[i].mayaTypeName == mayaTypeName)
+      {
+         return m_translators[i].creator;
+      }
+   }
+
+   return NULL;
+}
+
+// Session
+
+static CStandinSession *gCurrentSession = NULL;
+
+CStandinSession::CStandinSession()
+   : m_extension(NULL)
+   , m_frame(1.0)
+   , m_motionStep(0)
+   , m_exportingMotion(false)
+{
+}
+
+CStandinSession::~CStandinSession()
+{
+   Clear();
+
+   if (gCurrentSession == this)
+   {
+      gCurrentSession = NULL;
+   }
+}
+
+void CStandinSession::SetExtension(const CExtension *extension)
+{
+   m_extension = extension;
+}
+
+void CStandinSession::SetFrame(double frame)
+{
+   m_frame = frame;
+}
+
+void CStandinSession::SetMotionBlur(unsigned int steps, double frames)
+{
+   m_motionFrames.clear();
+
+   for (unsigned int i=0; steps > 1 && i<steps; ++i)
+   {
+      m_motionFrames.push_back(m_frame + frames * i / (steps - 1));
+   }
+}
+
+unsigned int CStandinSession::Export(const std::vector<MDagPath> &paths)
+{
+   std::vector<CNodeTranslator*> translators;
+
+   gCurrentSession = this;
+
+   StandinSetCurrentTime(m_frame);
+
+   m_motionStep = 0;
+   m_exportingMotion = false;
+
+   // Masters come first in paths, their translators must exist when the instances ones create their nodes
+   for (size_t i=0; i<paths.size(); ++i)
+   {
+      MObject node = paths[i].node();
+      TCreatorFunction creator = (m_extension ? m_extension->FindCreator(MFnDependencyNode(node).typeName()) : NULL);
+      std::string pathName = paths[i].fullPathName().asChar();
+
+      if (!creator || m_dagTranslators.find(pathName) != m_dagTranslators.end())
+      {
+         continue;
+      }
+
+      CNodeTranslator *translator = (CNodeTranslator*) creator();
+      CDagTranslator *dagTranslator = dynamic_cast<CDagTranslator*>(translator);
+
+      translator->m_session = this;
+      translator->m_object = node;
+      translator->m_name = pathName;
+
+      if (dagTranslator)
+      {
+         dagTranslator->m_dagPath = paths[i];
+         MDagPath::getAPathTo(node, dagTranslator->m_masterDagPath);
+      }
+
+      m_translators.push_back(translator);
+      m_dagTranslators[pathName] = translator;
+      translators.push_back(translator);
+
+      translator->Init();
+      translator->CreateArnoldNodes();
+   }
+
+   for (size_t i=0; i<translators.size(); ++i)
+   {
+      AtNode *node = translators[i]->GetArnoldNode();
+      if (node)
+      {
+         translators[i]->Export(node);
+      }
+   }
+
+   // The scene is evaluated at each motion step frame in turn
+   m_exportingMotion = true;
+
+   for (unsigned int step=1; step<m_motionFrames.size(); ++step)
+   {
+      m_motionStep = step;
+      StandinSetCurrentTime(m_motionFrames[step]);
+
+      for (size_t i=0; i<translators.size(); ++i)
+      {
+         AtNode *node = translators[i]->GetArnoldNode();
+         if (node && translators[i]->RequiresMotionData())
+         {
+            translators[i]->ExportMotion(node);
+         }
+      }
+   }
+
+   m_motionStep = 0;
+   m_exportingMotion = false;
+
+   StandinSetCurrentTime(m_frame);
+
+   for (size_t i=0; i<translators.size(); ++i)
+   {
+      translators[i]->m_exported = true;
+   }
+
+   return (unsigned int) translators.size();
+}
+
+void CStandinSession::Clear()
+{
+   for (size_t i=0; i<m_translators.size(); ++i)
+   {
+      m_translators[i]->Delete();
+      delete m_translators[i];
+   }
+
+   for (size_t i=0; i<m_nodes.size(); ++i)
+   {
+      AiNodeDestroy(m_nodes[i]);
+   }
+
+   m_translators.clear();
+   m_dagTranslators.clear();
+   m_shaders.clear();
+   m_nodes.clear();
+}
+
+unsigned int CStandinSession::GetNumTranslators() const
+{
+   return (unsigned int) m_translators.size();
+}
+
+unsigned int CStandinSession::GetNumArnoldNodes() const
+{
+   return (unsigned int) m_nodes.size();
+}
+
+CStandinSession* CStandinSession::GetCurrent()
+{
+   return gCurrentSession;
+}
+
+CNodeTranslator* CStandinSession::FindTranslator(const MDagPath &dagPath) const
+{
+   std::map<std::string, CNodeTranslator*>::const_iterator it = m_dagTranslators.find(dagPath.fullPathName().asChar());
+   return (it != m_dagTranslators.end() ? it->second : NULL);
+}
+
+// One shader per maya node, the shading engines stand for their surface shader
+AtNode* CStandinSession::ExportShader(const MObject &node)
+{
+   std::string name = MFnDependencyNode(node).name().asChar();
+   std::map<std::string, AtNode*>::iterator it = m_shaders.find(name);
+
+   if (it != m_shaders.end())
+   {
+      return it->second;
+   }
+
+   AtNode *shader = AiNode("standard");
+
+   if (shader)
+   {
+      AiNodeSetStr(shader, "name", name.c_str());
+      m_shaders[name] = shader;
+      m_nodes.push_back(shader);
+   }
+
+   return shader;
+}
@@ -0,0 +1,476 @@
+#include "standin.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Fake python dispatcher implementing pyutils.h: module functions are canned C++ behaviours
+//   (see CStandinModule), function objects point to the registered module they were probed from
+
+struct _object
+{
+   const CStandinModule *module;
+   PyModuleFunc func;
+};
+
+static std::map<std::string, CStandinModule> gModules;
+static unsigned long gPythonCalls = 0;
+
+CStandinModule::CStandinModule()
+   : numUserParams(0)
+{
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      funcs[i] = (i == PYFUNC_EXPORT);
+   }
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      caps[i] = (i == PYCAP_IS_SHAPE);
+   }
+}
+
+void StandinAddModule(const char *moduleName, const CStandinModule &module)
+{
+   gModules[moduleName] = module;
+}
+
+// Function objects still referencing the modules must have been released
+void StandinClearModules()
+{
+   gModules.clear();
+}
+
+unsigned long StandinGetPythonCalls(bool reset)
+{
+   unsigned long count = gPythonCalls;
+   if (reset)
+   {
+      gPythonCalls = 0;
+   }
+   return count;
+}
+
+static const char* gModuleFuncNames[PYFUNC_COUNT] =
+{
+   "Export",
+   "Cleanup",
+   "ExportBatch",
+   "ExportInstance",
+   "ExportMotion",
+   "CleanupBatch",
+   "SetupAttrs",
+   "SetupAE"
+};
+
+static const char* gModuleCapNames[PYCAP_COUNT] =
+{
+   "IsShape",
+   "SupportVolumes",
+   "SupportInstances",
+   "SupportMotionBounds",
+   "PrefetchMotionMatrices",
+   "SupportReplay",
+   "FastInstances"
+};
+
+CPyLock::CPyLock()
+   : m_state(0)
+{
+}
+
+CPyLock::~CPyLock()
+{
+}
+
+bool PyFindModuleFile(const char *moduleName, std::string &path)
+{
+   std::map<std::string, CStandinModule>::const_iterator it = gModules.find(moduleName ? moduleName : "");
+
+   if (it == gModules.end() || it->second.file.length() == 0)
+   {
+      return false;
+   }
+
+   path = it->second.file;
+
+   return true;
+}
+
+void PyRelease(PyObject *obj)
+{
+   delete obj;
+}
+
+const char* PyGetModuleFuncName(PyModuleFunc func)
+{
+   return gModuleFuncNames[func];
+}
+
+const char* PyGetModuleCapName(PyModuleCap cap)
+{
+   return gModuleCapNames[cap];
+}
+
+CPyModuleProbe::CPyModuleProbe()
+{
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      funcs[i] = NULL;
+   }
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      caps[i] = (i == PYCAP_IS_SHAPE);
+   }
+}
+
+bool PyProbeModule(const char *moduleName, CPyModuleProbe &probe)
+{
+   std::map<std::string, CStandinModule>::const_iterator it = gModules.find(moduleName ? moduleName : "");
+
+   // Import
+   ++gPythonCalls;
+
+   if (it == gModules.end())
+   {
+      return false;
+   }
+
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      if (it->second.funcs[i])
+      {
+         probe.funcs[i] = new PyObject();
+         probe.funcs[i]->module = &(it->second);
+         probe.funcs[i]->func = (PyModuleFunc) i;
+      }
+   }
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      probe.caps[i] = it->second.caps[i];
+   }
+
+   return true;
+}
+
+CPyAttrRecord::CPyAttrRecord()
+   : type(AI_TYPE_UNDEFINED), isArray(false), keyable(false)
+{
+   for (int i=0; i<PYATTR_VALUE_COUNT; ++i)
+   {
+      values[i] = NULL;
+   }
+}
+
+bool PyCallBool(PyObject *func, bool &result)
+{
+   if (!func)
+   {
+      return false;
+   }
+   ++gPythonCalls;
+   result = true;
+   return true;
+}
+
+static void SplitFields(const std::string &decl, std::vector<std::string> &fields)
+{
+   size_t p0 = 0;
+
+   fields.clear();
+
+   while (true)
+   {
+      size_t p1 = decl.find('|', p0);
+      fields.push_back(decl.substr(p0, p1 == std::string::npos ? std::string::npos : p1 - p0));
+      if (p1 == std::string::npos)
+      {
+         break;
+      }
+      p0 = p1 + 1;
+   }
+}
+
+// Single element array holding value, NULL if value is empty or type isn't supported
+static AtArray* MakeRecordValue(int type, const std::string &value)
+{
+   if (value.length() == 0)
+   {
+      return NULL;
+   }
+
+   AtArray *array = AiArrayAllocate(1, 1, (AtByte) type);
+
+   switch (type)
+   {
+   case AI_TYPE_BYTE:
+      AiArraySetByte(array, 0, (AtByte) atoi(value.c_str()));
+      break;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      AiArraySetInt(array, 0, atoi(value.c_str()));
+      break;
+   case AI_TYPE_UINT:
+      AiArraySetUInt(array, 0, (unsigned int) strtoul(value.c_str(), NULL, 10));
+      break;
+   case AI_TYPE_BOOLEAN:
+      AiArraySetBool(array, 0, value == "1" || value == "True" || value == "true");
+      break;
+   case AI_TYPE_FLOAT:
+      AiArraySetFlt(array, 0, (float) atof(value.c_str()));
+      break;
+   case AI_TYPE_STRING:
+      AiArraySetStr(array, 0, value.c_str());
+      break;
+   default:
+      AiArrayDestroy(array);
+      array = NULL;
+      break;
+   }
+
+   return array;
+}
+
+bool PyCallAttrRecords(PyObject *func, std::vector<CPyAttrRecord> &records)
+{
+   if (!func || func->func != PYFUNC_SETUP_ATTRS)
+   {
+      return false;
+   }
+
+   ++gPythonCalls;
+
+   const CStandinModule &module = *(func->module);
+   std::vector<std::string> fields;
+
+   for (size_t i=0; i<module.attrDecls.size(); ++i)
+   {
+      CPyAttrRecord record;
+      record.decl = module.attrDecls[i];
+      records.push_back(record);
+   }
+
+   // type|arnoldNode|arnoldAttr|name|shortName|isArray|default|min|max|softMin|softMax|keyable|enums
+   for (size_t i=0; i<module.attrRecords.size(); ++i)
+   {
+      SplitFields(module.attrRecords[i], fields);
+
+      if (fields.size() != 13)
+      {
+         continue;
+      }
+
+      CPyAttrRecord record;
+
+      record.type = atoi(fields[0].c_str());
+      record.arnoldNode = fields[1];
+      record.arnoldAttr = fields[2];
+      record.name = fields[3];
+      record.shortName = fields[4];
+      record.isArray = (fields[5] == "1");
+      record.keyable = (fields[11] == "1");
+
+      for (int v=0; v<PYATTR_VALUE_COUNT; ++v)
+      {
+         record.values[v] = MakeRecordValue(record.type, fields[6 + v]);
+      }
+
+      records.push_back(record);
+   }
+
+   return true;
+}
+
+void PyReleaseAttrRecords(std::vector<CPyAttrRecord> &records)
+{
+   for (size_t i=0; i<records.size(); ++i)
+   {
+      for (int v=0; v<PYATTR_VALUE_COUNT; ++v)
+      {
+         AiArrayDestroy(records[i].values[v]);
+         records[i].values[v] = NULL;
+      }
+   }
+   records.clear();
+}
+
+static void GetUserParamName(unsigned int i, char *buffer)
+{
+   if (i == 0)
+   {
+      strcpy(buffer, "mtoa_frame");
+   }
+   else if (i == 1)
+   {
+      strcpy(buffer, "mtoa_ids");
+   }
+   else
+   {
+      sprintf(buffer, "mtoa_user%u", i);
+   }
+}
+
+static bool HasParam(AtNode *node, const char *param)
+{
+   return (AiNodeEntryLookUpParameter(AiNodeGetNodeEntry(node), param) != NULL);
+}
+
+// What a typical procedural export script does: point the node to a DSO and pass it some data
+static void CannedExport(const CStandinModule &module, double sampleFrame, const CPyNodeNames &names,
+                         AtNode *node, std::vector<std::string> &attrs)
+{
+   char name[64];
+
+   attrs.clear();
+
+   if (HasParam(node, "dso"))
+   {
+      AiNodeSetStr(node, "dso", "standin_procedural.so");
+      AiNodeSetStr(node, "data", names.mayaName ? names.mayaName : "");
+      AiNodeSetBool(node, "load_at_init", true);
+      attrs.push_back("dso");
+      attrs.push_back("data");
+      attrs.push_back("load_at_init");
+   }
+
+   for (unsigned int i=0; i<module.numUserParams; ++i)
+   {
+      GetUserParamName(i, name);
+
+      if (!AiNodeLookUpUserParameter(node, name))
+      {
+         AiNodeDeclare(node, name, "constant FLOAT");
+      }
+
+      AiNodeSetFlt(node, name, (float) (sampleFrame + i));
+      attrs.push_back(name);
+   }
+}
+
+bool PyCallExport(PyObject *func, double, unsigned int, double sampleFrame,
+                  const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs)
+{
+   if (!func || !node)
+   {
+      return false;
+   }
+
+   ++gPythonCalls;
+
+   if (func->func == PYFUNC_EXPORT_INSTANCE)
+   {
+      attrs.clear();
+      AiNodeSetByte(node, "visibility", AI_RAY_ALL & ~AI_RAY_GLOSSY);
+      attrs.push_back("visibility");
+      return true;
+   }
+   else if (func->func != PYFUNC_EXPORT)
+   {
+      return false;
+   }
+
+   CannedExport(*(func->module), sampleFrame, names, node, attrs);
+
+   return true;
+}
+
+bool PyCallExportMotion(PyObject *func, double, const std::vector<double> &sampleFrames,
+                        const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs)
+{
+   if (!func || !node || func->func != PYFUNC_EXPORT_MOTION || sampleFrames.size() == 0)
+   {
+      return false;
+   }
+
+   ++gPythonCalls;
+
+   const CStandinModule &module = *(func->module);
+   unsigned int numUserParams = module.numUserParams;
+
+   // mtoa_frame gets one key per sample, other user parameters are static
+   CStandinModule staticModule = module;
+   staticModule.numUserParams = 0;
+
+   CannedExport(staticModule, sampleFrames[0], names, node, attrs);
+
+   char name[64];
+
+   for (unsigned int i=0; i<numUserParams; ++i)
+   {
+      GetUserParamName(i, name);
+
+      if (i == 0)
+      {
+         if (!AiNodeLookUpUserParameter(node, name))
+         {
+            AiNodeDeclare(node, name, "constant ARRAY FLOAT");
+         }
+
+         AtArray *frames = AiArrayAllocate(1, (AtByte) sampleFrames.size(), AI_TYPE_FLOAT);
+
+         for (size_t s=0; s<sampleFrames.size(); ++s)
+         {
+            AiArraySetFlt(frames, (AtUInt32) s, (float) sampleFrames[s]);
+         }
+
+         AiNodeSetArray(node, name, frames);
+      }
+      else
+      {
+         if (!AiNodeLookUpUserParameter(node, name))
+         {
+            AiNodeDeclare(node, name, "constant FLOAT");
+         }
+
+         AiNodeSetFlt(node, name, (float) (sampleFrames[0] + i));
+      }
+
+      attrs.push_back(name);
+   }
+
+   return true;
+}
+
+bool PyCallExportBatch(PyObject *func, double, unsigned int, double sampleFrame,
+                       const std::vector<CPyNodeNames> &names, const std::vector<AtNode*> &nodes,
+                       std::vector< std::vector<std::string> > &attrs, std::vector<bool> &processed)
+{
+   if (!func || func->func != PYFUNC_EXPORT_BATCH || names.size() != nodes.size())
+   {
+      return false;
+   }
+
+   ++gPythonCalls;
+
+   attrs.resize(nodes.size());
+   processed.assign(nodes.size(), false);
+
+   for (size_t i=0; i<nodes.size(); ++i)
+   {
+      if (nodes[i])
+      {
+         CannedExport(*(func->module), sampleFrame, names[i], nodes[i], attrs[i]);
+         processed[i] = true;
+      }
+   }
+
+   return true;
+}
+
+bool PyCallCleanup(PyObject *func, const CPyNodeNames &)
+{
+   if (!func || func->func != PYFUNC_CLEANUP)
+   {
+      return false;
+   }
+   ++gPythonCalls;
+   return true;
+}
+
+bool PyCallCleanupBatch(PyObject *func, const std::vector<CPyNodeNames> &)
+{
+   if (!func || func->func != PYFUNC_CLEANUP_BATCH)
+   {
+      return false;
+   }
+   ++gPythonCalls;
+   return true;
+}
@@ -0,0 +1,133 @@
+#ifndef __standin_h__
+#define __standin_h__
+
+// Control side of the maya, MtoA, arnold and python stand-ins (benchmark only)
+//   scenes are built with the Standin* functions, exports are driven through CStandinSession
+//   and the fake python dispatcher serves translator modules registered with StandinAddModule
+
+#include <ai.h>
+#include <maya/MStandin.h>
+#include "translators/NodeTranslator.h"
+#include "extension/Extension.h"
+#include "pyutils.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// Maya scene
+
+enum StandinAttrType
+{
+   STANDIN_ATTR_NUMERIC = 0,
+   STANDIN_ATTR_STRING,
+   STANDIN_ATTR_MATRIX,
+   STANDIN_ATTR_MESSAGE
+};
+
+// DAG types get "translate" and "velocity" (units per frame) attributes, both along x only,
+//   the world matrix of a path sums them over its nodes at the current (or guarded) time
+// Shading engine types get "dagSetMembers" and "surfaceShader" attributes
+void StandinAddNodeType(const char *typeName, MFn::Type apiType, const char *classification="");
+bool StandinAddAttribute(const char *typeName, const char *name, const char *shortName, StandinAttrType type,
+                         bool isArray=false, double defaultValue=0.0, bool usedAsFilename=false);
+bool StandinHasAttribute(const char *typeName, const char *name);
+
+// DAG nodes are parented under parent (the world if null), a node with several parents is instanced
+MObject StandinCreateNode(const char *typeName, const char *name, const MObject &parent=MObject::kNullObj);
+bool StandinAddParent(const MObject &node, const MObject &parent);
+bool StandinAddDynamicAttribute(const MObject &node, const char *name, StandinAttrType type, double defaultValue=0.0);
+bool StandinSetValue(const MObject &node, const char *attr, double value, int index=-1);
+bool StandinSetString(const MObject &node, const char *attr, const char *value);
+bool StandinSetBoundingBox(const MObject &node, const MBoundingBox &bbox);
+bool StandinConnect(const MObject &srcNode, const char *srcAttr, int srcIndex, const MObject &dstNode, const char *dstAttr, int dstIndex);
+// Instance paths of a DAG node, one per parent
+bool StandinGetAllPaths(const MObject &node, std::vector<MDagPath> &paths);
+// Destroys all nodes (kBeforeNew callbacks are called first), node types are kept
+void StandinNewScene();
+
+void StandinSetCurrentTime(double frame);
+void StandinLoadPlugin(const char *pluginName);
+// Calls the callbacks registered for an MEventMessage event ("idle")
+void StandinSendEvent(const char *eventName);
+// Messages displayed through MGlobal since the last call
+unsigned long StandinGetDisplayedMessages(bool reset=true);
+
+// Fake python dispatcher
+
+// Canned behaviour of the functions of a translator module:
+//   Export sets the dso, data and load_at_init parameters and declares and sets numUserParams user parameters
+//   (mtoa_frame, then mtoa_ids, mtoa_user2, ...) and returns their names
+//   ExportInstance sets visibility, ExportMotion sets the parameters Export would on the first sample frame
+//   and the mtoa_frame user parameter as an array of all sample frames
+//   SetupAttrs returns the attrDecls declaration strings followed by the attrRecords ones as structured records
+//   (only single numeric or string default values are supported for those)
+// Only Export is defined and only IsShape is set by default
+struct CStandinModule
+{
+   bool funcs[PYFUNC_COUNT];
+   bool caps[PYCAP_COUNT];
+   unsigned int numUserParams;
+   std::vector<std::string> attrDecls;
+   std::vector<std::string> attrRecords;
+   // Source file reported by PyFindModuleFile, empty if not found
+   std::string file;
+
+   CStandinModule();
+};
+
+void StandinAddModule(const char *moduleName, const CStandinModule &module);
+void StandinClearModules();
+
+// Python calls made since the last call
+unsigned long StandinGetPythonCalls(bool reset=true);
+
+// MtoA session
+
+class CStandinSession
+{
+public:
+
+   CStandinSession();
+   ~CStandinSession();
+
+   void SetExtension(const CExtension *extension);
+   void SetFrame(double frame);
+   // Start of frame motion blur over the given number of frames, disabled with less than 2 steps
+   void SetMotionBlur(unsigned int steps, double frames);
+
+   // Export paths as MtoA does: translators for all paths are created then exported at the render frame,
+   //   then exported for each other motion step in turn, returns the number of translated paths
+   unsigned int Export(const std::vector<MDagPath> &paths);
+   // Deletes all translators and the arnold nodes they created
+   void Clear();
+
+   unsigned int GetNumTranslators() const;
+   unsigned int GetNumArnoldNodes() const;
+
+   static CStandinSession* GetCurrent();
+
+private:
+
+   friend class CNodeTranslator;
+   friend class CDagTranslator;
+
+   CStandinSession(const CStandinSession&);
+   CStandinSession& operator=(const CStandinSession&);
+
+   CNodeTranslator* FindTranslator(const MDagPath &dagPath) const;
+   AtNode* ExportShader(const MObject &node);
+
+private:
+
+   const CExtension *m_extension;
+   double m_frame;
+   std::vector<double> m_motionFrames;
+   unsigned int m_motionStep;
+   bool m_exportingMotion;
+   std::vector<CNodeTranslator*> m_translators;
+   std::map<std::string, CNodeTranslator*> m_dagTranslators;
+   std::map<std::string, AtNode*> m_shaders;
+   std::vector<AtNode*> m_nodes;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __standin_mtoa_nodetranslator_h__
+#define __standin_mtoa_nodetranslator_h__
+
+// Stand-in for the MtoA 2.x translator base classes (benchmark only)
+//   translators are created and driven by CStandinSession (see standin.h) in the order MtoA uses:
+//   Init, CreateArnoldNodes, Export at the render frame then ExportMotion for each other motion step
+
+#include <ai.h>
+#include <maya/MStandin.h>
+#include <string>
+#include <vector>
+
+#define MTOA_MBLUR_LIGHT   0x0001
+#define MTOA_MBLUR_CAMERA  0x0002
+#define MTOA_MBLUR_OBJECT  0x0004
+#define MTOA_MBLUR_DEFORM  0x0008
+#define MTOA_MBLUR_SHADER  0x0010
+#define MTOA_MBLUR_ANY     0xFFFF
+
+#define MTOA_MBLUR_TYPE_START  0
+#define MTOA_MBLUR_TYPE_CENTER 1
+#define MTOA_MBLUR_TYPE_END    2
+#define MTOA_MBLUR_TYPE_CUSTOM 3
+
+enum UpdateMode
+{
+   AI_UPDATE_ONLY = 0,
+   AI_RECREATE_NODE,
+   AI_RECREATE_TRANSLATOR,
+   AI_DELETE_NODE
+};
+
+class CArnoldSession;
+class CStandinSession;
+
+class CNodeTranslator
+{
+public:
+
+   virtual ~CNodeTranslator();
+
+   virtual AtNode* CreateArnoldNodes() = 0;
+   virtual void Init();
+   virtual void Export(AtNode *atNode);
+   virtual void ExportMotion(AtNode *atNode);
+   virtual bool RequiresMotionData();
+   virtual void RequestUpdate();
+   virtual void NodeChanged(MObject &node, MPlug &plug);
+   virtual void Delete();
+
+   static CNodeTranslator* GetTranslator(const MDagPath &dagPath);
+
+   AtNode* GetArnoldNode(const char *tag="");
+   MObject GetMayaObject() const;
+   MString GetMayaNodeName() const;
+   bool IsExported() const;
+
+protected:
+
+   CNodeTranslator();
+
+   AtNode* AddArnoldNode(const char *type, const char *tag="");
+   MPlug FindMayaPlug(const MString &attrName, MStatus *status=NULL) const;
+   AtNode* ExportConnectedNode(const MPlug &outputPlug);
+   void SetUpdateMode(int mode);
+
+   double GetExportFrame() const;
+   bool IsExportingMotion() const;
+   unsigned int GetMotionStep() const;
+   unsigned int GetNumMotionSteps() const;
+   const double* GetMotionFrames(unsigned int &count) const;
+   bool IsMotionBlurEnabled(int type=MTOA_MBLUR_ANY) const;
+   bool IsLocalMotionBlurEnabled() const;
+   bool RequiresShaderExport() const;
+
+private:
+
+   friend class CStandinSession;
+
+   CStandinSession *m_session;
+   MObject m_object;
+   // Arnold node name (full path name for DAG nodes)
+   std::string m_name;
+   std::vector<std::pair<std::string, AtNode*> > m_nodes;
+   int m_updateMode;
+   bool m_exported;
+};
+
+class CDagTranslator : public CNodeTranslator
+{
+public:
+
+   virtual void Init();
+
+   static CDagTranslator* ExportDagPath(const MDagPath &dagPath);
+
+protected:
+
+   bool IsMasterInstance();
+   MDagPath& GetMasterInstance();
+   void ConvertMatrix(AtMatrix &matrix, const MMatrix &mayaMatrix);
+   void ExportLightLinking(AtNode *atNode);
+   void ExportTraceSets(AtNode *atNode, const MPlug &traceSetsPlug);
+
+protected:
+
+   MDagPath m_dagPath;
+
+private:
+
+   friend class CStandinSession;
+
+   MDagPath m_masterDagPath;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __standin_mtoa_shapetranslator_h__
+#define __standin_mtoa_shapetranslator_h__
+
+// Stand-in for the MtoA shape translator base class (benchmark only)
+
+#include "translators/NodeTranslator.h"
+#include "attributes/AttrHelper.h"
+
+// Plug of the shading engine instance number of dagNode is connected to, null if none
+MPlug GetNodeShadingGroup(MObject dagNode, int instanceNum);
+
+class CShapeTranslator : public CDagTranslator
+{
+public:
+
+   virtual void Init();
+
+   static void MakeCommonAttributes(CBaseAttrHelper &helper);
+};
+
+#endif
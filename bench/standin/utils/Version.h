@@ -0,0 +1,11 @@
+#ifndef __standin_mtoa_version_h__
+#define __standin_mtoa_version_h__
+
+// Stand-in MtoA version, the extension is built against the 2.x translator API
+
+#define MTOA_ARCH_VERSION_NUM 2
+#define MTOA_MAJOR_VERSION_NUM 0
+#define MTOA_MINOR_VERSION_NUM 0
+#define MTOA_FIX_VERSION "0"
+
+#endif
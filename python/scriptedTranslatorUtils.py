@@ -193,7 +193,7 @@ class AttrData(object):
     
     def elementToString(self, v):
         if self.type in self.ListTypes:
-            return ",".join(v)
+            return ",".join(map(str, v))
         else:
             return str(v)
     
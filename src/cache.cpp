@@ -0,0 +1,314 @@
+#include "cache.h"
+#include <maya/MString.h>
+#include <cstdio>
+#include <fstream>
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+std::string GetCacheDirectory()
+{
+   MString dir = MString("$MTOA_SCRIPTED_TRANSLATORS_CACHE").expandEnvironmentVariablesAndTilde();
+   
+   if (dir.length() == 0 || dir == "$MTOA_SCRIPTED_TRANSLATORS_CACHE")
+   {
+      return "";
+   }
+   
+   return dir.asChar();
+}
+
+unsigned long long HashBytes(const char *bytes, size_t len, unsigned long long hash)
+{
+   for (size_t i=0; i<len; ++i)
+   {
+      hash = (hash ^ (unsigned char) bytes[i]) * 1099511628211ULL;
+   }
+   return hash;
+}
+
+std::string HashToString(unsigned long long hash)
+{
+   char buffer[32];
+   sprintf(buffer, "%016llx", hash);
+   return buffer;
+}
+
+bool HashFile(const std::string &path, unsigned long long &hash)
+{
+   FILE *f = fopen(path.c_str(), "rb");
+   
+   if (!f)
+   {
+      return false;
+   }
+   
+   char buffer[4096];
+   size_t n = fread(buffer, 1, sizeof(buffer), f);
+   
+   hash = HashBytes(NULL, 0);
+   
+   while (n > 0)
+   {
+      hash = HashBytes(buffer, n, hash);
+      n = fread(buffer, 1, sizeof(buffer), f);
+   }
+   
+   fclose(f);
+   
+   return true;
+}
+
+bool ReadCacheFile(const std::string &name, const char *header, const std::string &key, std::vector<std::string> &lines)
+{
+   std::string dir = GetCacheDirectory();
+   
+   lines.clear();
+   
+   if (dir.length() == 0)
+   {
+      return false;
+   }
+   
+   std::string path = dir + "/" + name;
+   std::ifstream in(path.c_str());
+   std::string line;
+   
+   if (!in.is_open() || !std::getline(in, line) || line != header || !std::getline(in, line) || line != key)
+   {
+      return false;
+   }
+   
+   while (std::getline(in, line))
+   {
+      lines.push_back(line);
+   }
+   
+   return true;
+}
+
+// Temporary file next to path, unique to the process and the machine as the cache directory may be shared
+static std::string GetTempPath(const std::string &path)
+{
+   static unsigned int counter = 0;
+   char host[256] = "";
+   char suffix[64];
+   
+#ifdef _WIN32
+   DWORD len = sizeof(host);
+   if (!GetComputerNameA(host, &len))
+   {
+      host[0] = '\0';
+   }
+#else
+   if (gethostname(host, sizeof(host)) != 0)
+   {
+      host[0] = '\0';
+   }
+   host[sizeof(host)-1] = '\0';
+#endif
+   
+   sprintf(suffix, ".%d.%u.tmp", (int) getpid(), counter++);
+   
+   return path + "." + host + suffix;
+}
+
+// Atomically replaces path with the temporary file, which is removed on failure
+static bool CommitTempFile(const std::string &tmpPath, const std::string &path)
+{
+#ifdef _WIN32
+   if (!MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+   if (rename(tmpPath.c_str(), path.c_str()) != 0)
+#endif
+   {
+      remove(tmpPath.c_str());
+      return false;
+   }
+   
+   return true;
+}
+
+bool WriteCacheFile(const std::string &name, const char *header, const std::string &key, const std::vector<std::string> &lines)
+{
+   std::string dir = GetCacheDirectory();
+   
+   if (dir.length() == 0)
+   {
+      return false;
+   }
+   
+   std::string path = dir + "/" + name;
+   std::string tmpPath = GetTempPath(path);
+   std::ofstream out(tmpPath.c_str());
+   
+   if (!out.is_open())
+   {
+      return false;
+   }
+   
+   out << header << std::endl << key << std::endl;
+   
+   for (size_t i=0; i<lines.size(); ++i)
+   {
+      out << lines[i] << std::endl;
+   }
+   
+   out.close();
+   
+   if (out.fail())
+   {
+      remove(tmpPath.c_str());
+      return false;
+   }
+   
+   return CommitTempFile(tmpPath, path);
+}
+
+CMappedFile::CMappedFile()
+   : m_data(0), m_size(0)
+#ifdef _WIN32
+   , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#endif
+{
+}
+
+CMappedFile::~CMappedFile()
+{
+   close();
+}
+
+bool CMappedFile::open(const std::string &name)
+{
+   std::string dir = GetCacheDirectory();
+   
+   close();
+   
+   if (dir.length() == 0)
+   {
+      return false;
+   }
+   
+   std::string path = dir + "/" + name;
+
+#ifdef _WIN32
+   m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   
+   if (m_file == INVALID_HANDLE_VALUE)
+   {
+      return false;
+   }
+   
+   LARGE_INTEGER size;
+   
+   if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+   {
+      close();
+      return false;
+   }
+   
+   m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+   m_data = (m_mapping ? (const char*) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : NULL);
+   
+   if (!m_data)
+   {
+      close();
+      return false;
+   }
+   
+   m_size = (size_t) size.QuadPart;
+#else
+   int fd = ::open(path.c_str(), O_RDONLY);
+   
+   if (fd < 0)
+   {
+      return false;
+   }
+   
+   struct stat st;
+   
+   if (fstat(fd, &st) != 0 || st.st_size == 0)
+   {
+      ::close(fd);
+      return false;
+   }
+   
+   // The mapping stays valid once the descriptor is closed
+   void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   
+   ::close(fd);
+   
+   if (data == MAP_FAILED)
+   {
+      return false;
+   }
+   
+   m_data = (const char*) data;
+   m_size = (size_t) st.st_size;
+#endif
+   
+   return true;
+}
+
+void CMappedFile::close()
+{
+#ifdef _WIN32
+   if (m_data)
+   {
+      UnmapViewOfFile(m_data);
+   }
+   if (m_mapping)
+   {
+      CloseHandle(m_mapping);
+   }
+   if (m_file != INVALID_HANDLE_VALUE)
+   {
+      CloseHandle(m_file);
+   }
+   m_mapping = NULL;
+   m_file = INVALID_HANDLE_VALUE;
+#else
+   if (m_data)
+   {
+      munmap((void*) m_data, m_size);
+   }
+#endif
+   m_data = 0;
+   m_size = 0;
+}
+
+bool WriteCacheData(const std::string &name, const std::string &data)
+{
+   std::string dir = GetCacheDirectory();
+   
+   if (dir.length() == 0)
+   {
+      return false;
+   }
+   
+   std::string path = dir + "/" + name;
+   std::string tmpPath = GetTempPath(path);
+   FILE *f = fopen(tmpPath.c_str(), "wb");
+   
+   if (!f)
+   {
+      return false;
+   }
+   
+   bool written = (fwrite(data.c_str(), 1, data.length(), f) == data.length());
+   
+   if (fclose(f) != 0 || !written)
+   {
+      remove(tmpPath.c_str());
+      return false;
+   }
+   
+   return CommitTempFile(tmpPath, path);
+}
@@ -0,0 +1,53 @@
+#ifndef __cache_h__
+#define __cache_h__
+
+#include <string>
+#include <vector>
+
+// Files saved in the MTOA_SCRIPTED_TRANSLATORS_CACHE directory
+// Returns an empty string when caching to disk is disabled
+std::string GetCacheDirectory();
+
+// 64 bits FNV-1a hash
+unsigned long long HashBytes(const char *bytes, size_t len, unsigned long long hash=14695981039346656037ULL);
+std::string HashToString(unsigned long long hash);
+bool HashFile(const std::string &path, unsigned long long &hash);
+
+// Cache files start with a header line identifying their format and a key line identifying their content
+// Reading fails if either doesn't match, writing goes through a temporary file so that concurrent sessions never read a partial file
+bool ReadCacheFile(const std::string &name, const char *header, const std::string &key, std::vector<std::string> &lines);
+bool WriteCacheFile(const std::string &name, const char *header, const std::string &key, const std::vector<std::string> &lines);
+
+// Read-only memory mapping of a binary cache file
+class CMappedFile
+{
+public:
+   
+   CMappedFile();
+   ~CMappedFile();
+   
+   bool open(const std::string &name);
+   void close();
+   
+   inline const char* data() const { return m_data; }
+   inline size_t size() const { return m_size; }
+   
+private:
+   
+   CMappedFile(const CMappedFile&);
+   CMappedFile& operator=(const CMappedFile&);
+   
+private:
+   
+   const char *m_data;
+   size_t m_size;
+#ifdef _WIN32
+   void *m_file;
+   void *m_mapping;
+#endif
+};
+
+// Binary counterpart of WriteCacheFile
+bool WriteCacheData(const std::string &name, const std::string &data);
+
+#endif
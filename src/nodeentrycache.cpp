@@ -0,0 +1,358 @@
+#include "nodeentrycache.h"
+#include "plugin.h"
+#include "cache.h"
+#include <maya/MString.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <dirent.h>
+#endif
+#include <cstdio>
+#include <map>
+#include <vector>
+
+struct CCachedParam
+{
+   CAttrData data;
+   bool hasDefault;
+   // Serialized declaration
+   std::string decl;
+};
+
+typedef std::map<std::string, CCachedParam> CCachedParams;
+typedef std::map<std::string, CCachedParams> CNodeEntryCache;
+
+static CNodeEntryCache gNodeEntries;
+static std::string gCacheKey;
+static bool gCacheLoaded = false;
+static bool gCacheDirty = false;
+
+static int gQueryDepth = 0;
+static bool gUniverseCreated = false;
+
+static const char* gCacheHeader = "mtoaScriptedTranslators node entries 1";
+static const char* gCacheFile = "nodeEntries.cache";
+
+
+static void ClearParams(CCachedParams &params)
+{
+   for (CCachedParams::iterator it=params.begin(); it!=params.end(); ++it)
+   {
+      ReleaseAttrValues(it->second.data, it->second.hasDefault);
+   }
+   params.clear();
+}
+
+static void ClearEntries()
+{
+   for (CNodeEntryCache::iterator it=gNodeEntries.begin(); it!=gNodeEntries.end(); ++it)
+   {
+      ClearParams(it->second);
+   }
+   gNodeEntries.clear();
+}
+
+static bool AddParam(CCachedParams &params, const std::string &decl)
+{
+   CAttrDeclaration fields;
+   CCachedParam param;
+   
+   if (!ParseAttrDeclaration(decl, param.data, fields) || fields.arnoldAttr.length() == 0)
+   {
+      return false;
+   }
+   
+   param.hasDefault = ReadAttrValues(fields, param.data);
+   param.decl = decl;
+   
+   CCachedParams::iterator it = params.find(fields.arnoldAttr);
+   if (it != params.end())
+   {
+      ReleaseAttrValues(it->second.data, it->second.hasDefault);
+   }
+   
+   params[fields.arnoldAttr] = param;
+   
+   return true;
+}
+
+static void ListPlugins(const std::string &dir, std::vector<std::string> &files)
+{
+#ifdef _WIN32
+   WIN32_FIND_DATA fd;
+   HANDLE hdl = FindFirstFile((dir + "\\*").c_str(), &fd);
+   if (hdl == INVALID_HANDLE_VALUE)
+   {
+      return;
+   }
+   do
+   {
+      files.push_back(dir + "/" + fd.cFileName);
+   } while (FindNextFile(hdl, &fd));
+   FindClose(hdl);
+#else
+   DIR *d = opendir(dir.c_str());
+   if (!d)
+   {
+      return;
+   }
+   struct dirent *de = readdir(d);
+   while (de)
+   {
+      files.push_back(dir + "/" + de->d_name);
+      de = readdir(d);
+   }
+   closedir(d);
+#endif
+}
+
+// Arnold version followed by the FNV-1a hash of the plugin files path, size and modification time
+static std::string ComputeCacheKey()
+{
+#ifdef _WIN32
+   static const char separators[] = ";";
+#else
+   static const char separators[] = ":;";
+#endif
+   
+   MString pluginPath = MString("$ARNOLD_PLUGIN_PATH").expandEnvironmentVariablesAndTilde();
+   std::string paths = (pluginPath == "$ARNOLD_PLUGIN_PATH" ? "" : pluginPath.asChar());
+   std::vector<std::string> files;
+   
+   size_t p0 = 0, p1 = paths.find_first_of(separators, p0);
+   while (p0 < paths.length())
+   {
+      std::string dir = paths.substr(p0, (p1 == std::string::npos ? std::string::npos : p1-p0));
+      if (dir.length() > 0)
+      {
+         files.push_back(dir);
+         ListPlugins(dir, files);
+      }
+      if (p1 == std::string::npos)
+      {
+         break;
+      }
+      p0 = p1 + 1;
+      p1 = paths.find_first_of(separators, p0);
+   }
+   
+   unsigned long long hash = HashBytes(NULL, 0);
+   char buffer[64];
+   struct stat st;
+   
+   for (size_t i=0; i<files.size(); ++i)
+   {
+      std::string item = files[i];
+      
+      if (stat(files[i].c_str(), &st) == 0)
+      {
+         sprintf(buffer, ":%lu:%lu", (unsigned long) st.st_size, (unsigned long) st.st_mtime);
+         item += buffer;
+      }
+      
+      hash = HashBytes(item.c_str(), item.length(), hash);
+   }
+   
+   return std::string(AiGetVersion(NULL, NULL, NULL, NULL)) + " " + HashToString(hash);
+}
+
+static void LoadCache(const std::string &key)
+{
+   std::vector<std::string> lines;
+   
+   if (!ReadCacheFile(gCacheFile, gCacheHeader, key, lines))
+   {
+      return;
+   }
+   
+   CCachedParams *params = NULL;
+   
+   // "entry <name>" followed by the entry parameters declarations
+   for (size_t i=0; i<lines.size(); ++i)
+   {
+      if (lines[i].compare(0, 6, "entry ") == 0)
+      {
+         params = &(gNodeEntries[lines[i].substr(6)]);
+      }
+      else if (params && !AddParam(*params, lines[i]))
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] Invalid node entries cache line: %s", lines[i].c_str());
+      }
+   }
+}
+
+static void SaveCache()
+{
+   if (GetCacheDirectory().length() == 0)
+   {
+      return;
+   }
+   
+   std::vector<std::string> lines;
+   
+   for (CNodeEntryCache::iterator eit=gNodeEntries.begin(); eit!=gNodeEntries.end(); ++eit)
+   {
+      lines.push_back("entry " + eit->first);
+      
+      for (CCachedParams::iterator pit=eit->second.begin(); pit!=eit->second.end(); ++pit)
+      {
+         lines.push_back(pit->second.decl);
+      }
+   }
+   
+   if (!WriteCacheFile(gCacheFile, gCacheHeader, gCacheKey, lines))
+   {
+      AiMsgWarning("[mtoa.scriptedTranslators] Could not write node entries cache to \"%s\".", GetCacheDirectory().c_str());
+   }
+}
+
+static void StartUniverse()
+{
+   if (AiUniverseIsActive())
+   {
+      return;
+   }
+   
+   AiMsgSetConsoleFlags(AI_LOG_NONE);
+   AiMsgSetLogFileFlags(AI_LOG_NONE);
+   
+   AiBegin();
+   
+   MString pluginPath = MString("$ARNOLD_PLUGIN_PATH").expandEnvironmentVariablesAndTilde();
+   if (pluginPath.length() > 0)
+   {
+      AiLoadPlugins(pluginPath.asChar());
+   }
+   
+   gUniverseCreated = true;
+}
+
+void BeginNodeEntryQueries()
+{
+   if (gQueryDepth++ > 0)
+   {
+      return;
+   }
+   
+   std::string key = ComputeCacheKey();
+   
+   if (key != gCacheKey)
+   {
+      ClearEntries();
+      gCacheKey = key;
+      gCacheLoaded = false;
+      gCacheDirty = false;
+   }
+   
+   if (!gCacheLoaded)
+   {
+      LoadCache(key);
+      gCacheLoaded = true;
+   }
+}
+
+void EndNodeEntryQueries()
+{
+   if (gQueryDepth == 0 || --gQueryDepth > 0)
+   {
+      return;
+   }
+   
+   if (gUniverseCreated)
+   {
+      AiEnd();
+      gUniverseCreated = false;
+   }
+   
+   if (gCacheDirty)
+   {
+      SaveCache();
+      gCacheDirty = false;
+   }
+}
+
+void ClearNodeEntryCache()
+{
+   ClearEntries();
+   gCacheKey = "";
+   gCacheLoaded = false;
+   gCacheDirty = false;
+}
+
+CNodeEntryAttrHelper::CNodeEntryAttrHelper(const MString &nodeType, const char *nodeEntry)
+   : CExtensionAttrHelper(nodeType, (const AtNodeEntry*) NULL)
+   , m_nodeEntryName(nodeEntry ? nodeEntry : "")
+{
+}
+
+CNodeEntryAttrHelper::~CNodeEntryAttrHelper()
+{
+}
+
+bool CNodeEntryAttrHelper::GetAttrData(const char *paramName, CAttrData &data)
+{
+   CNodeEntryCache::iterator eit = gNodeEntries.find(m_nodeEntryName);
+   
+   if (!m_nodeEntry && eit != gNodeEntries.end() && !AiUniverseIsActive())
+   {
+      CCachedParams::iterator pit = eit->second.find(paramName);
+      
+      if (pit == eit->second.end())
+      {
+         return false;
+      }
+      
+      // Values remain owned by the cache
+      data = pit->second.data;
+      
+      return true;
+   }
+   
+   if (!m_nodeEntry)
+   {
+      StartUniverse();
+      
+      m_nodeEntry = AiNodeEntryLookUp(m_nodeEntryName.c_str());
+      
+      if (!m_nodeEntry)
+      {
+         return false;
+      }
+   }
+   
+   if (eit == gNodeEntries.end() && gQueryDepth > 0)
+   {
+      // Record all entry parameters
+      CCachedParams &params = gNodeEntries[m_nodeEntryName];
+      AtParamIterator *it = AiNodeEntryGetParamIterator(m_nodeEntry);
+      std::string decl;
+      
+      while (!AiParamIteratorFinished(it))
+      {
+         const char *name = AiParamGetName(AiParamIteratorGetNext(it));
+         CAttrData pdata;
+         
+         if (!CExtensionAttrHelper::GetAttrData(name, pdata))
+         {
+            continue;
+         }
+         
+         // Parameter defaults are always known to arnold
+         if (!FormatAttrDeclaration(pdata, m_nodeEntryName, name, true, decl) || !AddParam(params, decl))
+         {
+            // Can't be represented, always use arnold for this entry
+            ClearParams(params);
+            gNodeEntries.erase(m_nodeEntryName);
+            break;
+         }
+      }
+      
+      AiParamIteratorDestroy(it);
+      
+      gCacheDirty = true;
+   }
+   
+   return CExtensionAttrHelper::GetAttrData(paramName, data);
+}
@@ -0,0 +1,33 @@
+#ifndef __nodeentrycache_h__
+#define __nodeentrycache_h__
+
+#include "common.h"
+#include "attributes/AttrHelper.h"
+#include <string>
+
+// Arnold node entries parameters description, so that attributes can be setup without an arnold universe
+//   entries are recorded whenever they are queried with a universe active
+//   if MTOA_SCRIPTED_TRANSLATORS_CACHE is set to a directory, the cache is also saved there
+//   the cache is dropped when arnold version or the plugins found in ARNOLD_PLUGIN_PATH change
+
+// Queries may be nested, a universe started for an entry missing from the cache is ended with the outermost query
+void BeginNodeEntryQueries();
+void EndNodeEntryQueries();
+void ClearNodeEntryCache();
+
+// Attribute helper reading arnold parameters from the cache when no universe is active
+class CNodeEntryAttrHelper : public CExtensionAttrHelper
+{
+public:
+   
+   CNodeEntryAttrHelper(const MString &nodeType, const char *nodeEntry);
+   virtual ~CNodeEntryAttrHelper();
+   
+   virtual bool GetAttrData(const char *paramName, CAttrData &data);
+
+private:
+   
+   std::string m_nodeEntryName;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "nodetranslator.h"
 #include "plugin.h"
+#include "replay.h"
 
 void* CScriptedNodeTranslator::creator()
 {
@@ -7,27 +8,51 @@ void* CScriptedNodeTranslator::creator()
 }
 
 CScriptedNodeTranslator::CScriptedNodeTranslator()
-   : CNodeTranslator(), m_motionBlur(false)
+   : CNodeTranslator(), m_translator(0), m_motionBlur(false), m_replayed(false)
 {
+   AddStatsTranslator();
 }
 
 CScriptedNodeTranslator::~CScriptedNodeTranslator()
 {
+   RemoveBatchEntry(&m_batchEntry);
+   RemoveStatsTranslator();
+}
+
+bool CScriptedNodeTranslator::ResolveTranslator()
+{
+   if (!m_translator)
+   {
+      MFnDependencyNode fnNode(GetMayaObject());
+      
+      m_translator = FindTranslator(fnNode.typeName().asChar());
+      if (!m_translator)
+      {
+         AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
+         return false;
+      }
+      if (!LoadTranslator(*m_translator))
+      {
+         m_translator = NULL;
+         return false;
+      }
+   }
+   return true;
 }
 
 AtNode* CScriptedNodeTranslator::CreateArnoldNodes()
 {
-   std::map<std::string, CScriptedTranslator>::iterator translatorIt;
-   MFnDependencyNode fnNode(GetMayaObject());
-   
-   translatorIt = gTranslators.find(fnNode.typeName().asChar());
-   if (translatorIt == gTranslators.end())
+   // With the old API, nodes are created from within the base class Init
+   if (!ResolveTranslator())
    {
-      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
       return NULL;
    }
-
-   return AddArnoldNode("procedural");
+   
+   m_batchEntry.object = GetMayaObject();
+   m_batchEntry.node = AddArnoldNode("procedural");
+   AddBatchEntry(*m_translator, &m_batchEntry);
+   
+   return m_batchEntry.node;
 }
 
 #ifdef OLD_API
@@ -36,6 +61,8 @@ AtNode* CScriptedNodeTranslator::Init(CArnoldSession* session, const MObject& ob
 {
    AtNode *rv = CNodeTranslator::Init(session, object, outputAttr);
    m_motionBlur = (IsMotionBlurEnabled(MTOA_MBLUR_DEFORM|MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled());
+   m_batchEntry.numSteps = (m_motionBlur ? GetNumMotionSteps() : 1);
+   ResolveTranslator();
    return rv;
 }
 
@@ -69,6 +96,8 @@ void CScriptedNodeTranslator::Init()
 {
    CNodeTranslator::Init();
    m_motionBlur = (IsMotionBlurEnabled(MTOA_MBLUR_DEFORM|MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled());
+   m_batchEntry.numSteps = (m_motionBlur ? GetNumMotionSteps() : 1);
+   ResolveTranslator();
 }
 
 void CScriptedNodeTranslator::Export(AtNode *atNode)
@@ -81,9 +110,10 @@ void CScriptedNodeTranslator::ExportMotion(AtNode *atNode)
    RunScripts(atNode, GetMotionStep(), IsExported());
 }
 
+// Always a procedural, parameters are updated in place
 void CScriptedNodeTranslator::RequestUpdate()
 {
-   SetUpdateMode(AI_RECREATE_NODE);
+   SetUpdateMode(GetArnoldNode() ? AI_UPDATE_ONLY : AI_RECREATE_NODE);
    CNodeTranslator::RequestUpdate();
 }
 
@@ -94,75 +124,133 @@ bool CScriptedNodeTranslator::RequiresMotionData()
    return m_motionBlur;
 }
 
-void CScriptedNodeTranslator::RunScripts(AtNode *atNode, unsigned int step, bool /* update */)
+double CScriptedNodeTranslator::GetStepFrame(unsigned int step)
 {
-   std::map<std::string, CScriptedTranslator>::iterator translatorIt;
-   MFnDependencyNode fnNode(GetMayaObject());
+#ifdef OLD_API
+   return GetSampleFrame(m_session, step);
+#else
+   unsigned int nsteps = 0;
+   const double *mframes = GetMotionFrames(nsteps);
+   return (step < nsteps ? mframes[step] : GetExportFrame());
+#endif
+}
+
+bool CScriptedNodeTranslator::IsFirstStep(unsigned int step)
+{
+#ifdef OLD_API
+   return (step == 0);
+#else
+   return !IsExportingMotion();
+#endif
+}
+
+// When the module defines ExportMotion, all motion steps are exported at once on the first one
+bool CScriptedNodeTranslator::RunExportScript(unsigned int step, bool update, std::vector<std::string> &attrs)
+{
+   CReplayKey replayKey;
+   bool replay = false;
    
-   translatorIt = gTranslators.find(fnNode.typeName().asChar());
-   if (translatorIt == gTranslators.end())
+   if (IsFirstStep(step))
    {
-      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
-      return;
+      m_replayed = false;
+      
+      MObject object = GetMayaObject();
+      MDagPath dagPath;
+      
+      if (object.hasFn(MFn::kDagNode))
+      {
+         MDagPath::getAPathTo(object, dagPath);
+      }
+      
+      replay = (!update && (m_batchEntry.numSteps == 1 || m_batchEntry.owner->exportMotionFunc) &&
+                GetReplayKey(*m_batchEntry.owner, object, dagPath, MFnDependencyNode(object).name(), replayKey));
+      
+      if (replay && RunReplay(m_batchEntry, step, replayKey, attrs))
+      {
+         ResetRemovedParameters(m_batchEntry, attrs);
+         m_overrides.assign(attrs);
+         m_replayed = true;
+         return true;
+      }
+   }
+   
+   if (m_batchEntry.owner->exportMotionFunc && m_batchEntry.numSteps > 1)
+   {
+      if (!IsFirstStep(step))
+      {
+         return true;
+      }
+      
+      std::vector<double> sampleFrames(m_batchEntry.numSteps);
+      for (unsigned int i=0; i<m_batchEntry.numSteps; ++i)
+      {
+         sampleFrames[i] = GetStepFrame(i);
+      }
+      
+      if (!RunExportMotion(m_batchEntry, GetExportFrame(), sampleFrames, attrs))
+      {
+         return false;
+      }
+   }
+   else if (!RunExport(m_batchEntry, GetExportFrame(), step, GetStepFrame(step), IsFirstStep(step), update, attrs))
+   {
+      return false;
    }
    
-   MString exportCmd = translatorIt->second.exportCmd;
-   MString cleanupCmd = translatorIt->second.cleanupCmd;
+   if (IsFirstStep(step))
+   {
+      ResetRemovedParameters(m_batchEntry, attrs);
+   }
    
-   MFnDependencyNode node(GetMayaObject());
+   if (replay)
+   {
+      RecordExport(replayKey, m_batchEntry.node, attrs);
+   }
    
-   char buffer[64];
+   m_overrides.assign(attrs);
    
-   MString command = exportCmd;
-   command += "(";
+   return true;
+}
+
+void CScriptedNodeTranslator::RunScripts(AtNode *atNode, unsigned int step, bool update)
+{
+   MFnDependencyNode node(GetMayaObject());
    
-   sprintf(buffer, "%f", GetExportFrame());
-   command += buffer;
-   command += ", ";
+   CStatScope stats(m_stats, m_translator, GetMayaObject());
    
-   sprintf(buffer, "%d", step);
-   command += buffer;
-   command += ", ";
+   if (!m_batchEntry.owner)
+   {
+      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", node.name().asChar(), node.typeName().asChar());
+      return;
+   }
    
-#ifdef OLD_API
-   sprintf(buffer, "%f", GetSampleFrame(m_session, step));
-#else
-   unsigned int nsteps = 0;
-   const double *mframes = GetMotionFrames(nsteps);
-   sprintf(buffer, "%f", (step < nsteps ? mframes[step] : GetExportFrame()));
-#endif
-   command += buffer;
+   m_batchEntry.node = atNode;
    
-   command += ", \"(" + node.name() + "\", \"";
-   command += AiNodeGetName(atNode);
-   command += "\"), None)";
+   std::vector<std::string> attrs;
+   bool exported = false;
    
-   MStringArray attrs;
-   MStatus status = MGlobal::executePythonCommand(command, attrs);
-   if (!status)
    {
-      AiMsgError("[mtoa.scriptedTranslators] Failed to export node \"%s\".", node.name().asChar());
-      return;
+      CStatTimer timer(m_stats, STAT_EXPORT_SCRIPT);
+      exported = RunExportScript(step, update, attrs);
    }
    
-   std::set<std::string> attrsSet;
-   for (unsigned int i=0; i<attrs.length(); ++i)
+   if (!exported)
    {
-      attrsSet.insert(attrs[i].asChar());
+      AiMsgError("[mtoa.scriptedTranslators] Failed to export node \"%s\".", node.name().asChar());
+      return;
    }
-   std::set<std::string>::iterator attrsEnd = attrsSet.end();
    
-   if (attrsSet.find("min") == attrsEnd || attrsSet.find("max") == attrsEnd)
+   if (!m_overrides.has(PARAM_MIN) || !m_overrides.has(PARAM_MAX))
    {
       // Either min or max is missing, force load_at_init
       AiNodeSetBool(atNode, "load_at_init", true);
    }
-
+   
    if (!IsExportingMotion())
    {
       m_exportedSteps.clear();
    }
-
+   
    if (m_exportedSteps.find(step) != m_exportedSteps.end())
    {
       char numstr[16];
@@ -171,20 +259,10 @@ void CScriptedNodeTranslator::RunScripts(AtNode *atNode, unsigned int step, bool
    }
    m_exportedSteps.insert(step);
    
-   if (!m_motionBlur || m_exportedSteps.size() == GetNumMotionSteps())
+   // Cleanup is paired with Export, which a replayed export didn't call
+   if ((!m_motionBlur || m_exportedSteps.size() == GetNumMotionSteps()) && !m_replayed)
    {
-      if (cleanupCmd != "")
-      {
-         command = cleanupCmd + "((\"" + node.name() + "\", \"";
-         command += AiNodeGetName(atNode);
-         command += "\"), None)";
-         
-         status = MGlobal::executePythonCommand(command);
-         
-         if (!status)
-         {
-            AiMsgError("[mtoa.scriptedTranslators] Failed to cleanup node \"%s\".", node.name().asChar());
-         }
-      }
+      CStatTimer timer(m_stats, STAT_CLEANUP_SCRIPT);
+      RunCleanup(m_batchEntry);
    }
 }
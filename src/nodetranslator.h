@@ -4,6 +4,9 @@
 #include "common.h"
 #include "translators/NodeTranslator.h"
 #include "extension/Extension.h"
+#include "plugin.h"
+#include "params.h"
+#include "stats.h"
 #include <set>
 
 class CScriptedNodeTranslator : public CNodeTranslator
@@ -33,12 +36,22 @@ public:
    
 private:
    
+   bool ResolveTranslator();
+   double GetStepFrame(unsigned int step);
+   bool IsFirstStep(unsigned int step);
+   bool RunExportScript(unsigned int step, bool update, std::vector<std::string> &attrs);
    void RunScripts(AtNode *atNode, unsigned int step, bool update=false);
    
 private:
    
+   CScriptedTranslator *m_translator;
    bool m_motionBlur;
+   // Parameters set from the replay cache, Export wasn't called
+   bool m_replayed;
    std::set<unsigned int> m_exportedSteps;
+   CScriptedBatchEntry m_batchEntry;
+   COverrides m_overrides;
+   CExportStats m_stats;
 };
 
 #endif
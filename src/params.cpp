@@ -0,0 +1,271 @@
+#include "params.h"
+#include <ai.h>
+#include <cstring>
+#include <algorithm>
+
+struct CParamInfo
+{
+   const char *name;
+   // User parameter declaration, NULL if the parameter shouldn't be declared
+   const char *decl;
+};
+
+static const CParamInfo gParams[PARAM_COUNT] =
+{
+   {"matrix", NULL},
+   {"min", NULL},
+   {"max", NULL},
+   {"subdiv_type", "constant INT"},
+   {"subdiv_iterations", "constant BYTE"},
+   {"subdiv_adaptive_metric", "constant INT"},
+   {"subdiv_pixel_error", "constant FLOAT"},
+   {"subdiv_dicing_camera", "constant NODE"},
+   {"subdiv_uv_smoothing", "constant INT"},
+   {"subdiv_smooth_derivs", "constant BOOL"},
+   {"smoothing", "constant BOOL"},
+   {"disp_height", "constant FLOAT"},
+   {"disp_zero_value", "constant FLOAT"},
+   {"disp_autobump", "constant BOOL"},
+   {"disp_padding", "constant FLOAT"},
+   {"disp_map", "constant ARRAY NODE"},
+   {"sss_sample_distribution", "constant INT"},
+   {"sss_sample_spacing", "constant FLOAT"},
+   {"min_pixel_width", "constant FLOAT"},
+   {"mode", "constant INT"},
+   {"basis", "constant INT"},
+   {"node", NULL},
+   {"inherit_xform", NULL},
+   {"step_size", "constant FLOAT"},
+   {"sidedness", "constant BYTE"},
+   {"invert_normals", "constant BOOL"},
+   {"receive_shadows", "constant BOOL"},
+   {"self_shadows", "constant BOOL"},
+   {"opaque", "constant BOOL"},
+   {"matte", "constant BOOL"},
+   {"visibility", "constant BYTE"},
+   {"sss_setname", "constant STRING"},
+   {"shader", "constant NODE"}
+};
+
+// Parameter ids sorted by name
+static const ParamId gSortedParams[PARAM_COUNT] =
+{
+   PARAM_BASIS,
+   PARAM_DISP_AUTOBUMP,
+   PARAM_DISP_HEIGHT,
+   PARAM_DISP_MAP,
+   PARAM_DISP_PADDING,
+   PARAM_DISP_ZERO_VALUE,
+   PARAM_INHERIT_XFORM,
+   PARAM_INVERT_NORMALS,
+   PARAM_MATRIX,
+   PARAM_MATTE,
+   PARAM_MAX,
+   PARAM_MIN,
+   PARAM_MIN_PIXEL_WIDTH,
+   PARAM_MODE,
+   PARAM_NODE,
+   PARAM_OPAQUE,
+   PARAM_RECEIVE_SHADOWS,
+   PARAM_SELF_SHADOWS,
+   PARAM_SHADER,
+   PARAM_SIDEDNESS,
+   PARAM_SMOOTHING,
+   PARAM_SSS_SAMPLE_DISTRIBUTION,
+   PARAM_SSS_SAMPLE_SPACING,
+   PARAM_SSS_SETNAME,
+   PARAM_STEP_SIZE,
+   PARAM_SUBDIV_ADAPTIVE_METRIC,
+   PARAM_SUBDIV_DICING_CAMERA,
+   PARAM_SUBDIV_ITERATIONS,
+   PARAM_SUBDIV_PIXEL_ERROR,
+   PARAM_SUBDIV_SMOOTH_DERIVS,
+   PARAM_SUBDIV_TYPE,
+   PARAM_SUBDIV_UV_SMOOTHING,
+   PARAM_VISIBILITY
+};
+
+const char* GetParamName(ParamId id)
+{
+   return (id < PARAM_COUNT ? gParams[id].name : NULL);
+}
+
+const char* GetParamDeclaration(ParamId id)
+{
+   return (id < PARAM_COUNT ? gParams[id].decl : NULL);
+}
+
+ParamId FindParam(const char *name)
+{
+   int lo = 0;
+   int hi = PARAM_COUNT - 1;
+   
+   while (lo <= hi)
+   {
+      int mid = (lo + hi) / 2;
+      int cmp = strcmp(name, gParams[gSortedParams[mid]].name);
+      
+      if (cmp == 0)
+      {
+         return gSortedParams[mid];
+      }
+      else if (cmp < 0)
+      {
+         hi = mid - 1;
+      }
+      else
+      {
+         lo = mid + 1;
+      }
+   }
+   
+   return PARAM_COUNT;
+}
+
+COverrides::COverrides()
+{
+}
+
+void COverrides::clear()
+{
+   m_known.reset();
+   m_unknown.clear();
+}
+
+void COverrides::assign(const std::vector<std::string> &names)
+{
+   clear();
+   
+   for (size_t i=0; i<names.size(); ++i)
+   {
+      insert(names[i]);
+   }
+}
+
+void COverrides::insert(const std::string &name)
+{
+   ParamId id = FindParam(name.c_str());
+   
+   if (id != PARAM_COUNT)
+   {
+      m_known.set(id);
+   }
+   else if (std::find(m_unknown.begin(), m_unknown.end(), name) == m_unknown.end())
+   {
+      m_unknown.push_back(name);
+   }
+}
+
+bool COverrides::has(const char *name) const
+{
+   ParamId id = FindParam(name);
+   
+   if (id != PARAM_COUNT)
+   {
+      return m_known.test(id);
+   }
+   
+   for (size_t i=0; i<m_unknown.size(); ++i)
+   {
+      if (m_unknown[i] == name)
+      {
+         return true;
+      }
+   }
+   
+   return false;
+}
+
+struct CEntryParams
+{
+   const AtNodeEntry *entry;
+   std::string name;
+   std::bitset<PARAM_COUNT> builtin;
+};
+
+// Only a handful of node entries are ever used (procedural, box, ginstance)
+static std::vector<CEntryParams> gEntryParams;
+
+const std::bitset<PARAM_COUNT>& GetBuiltinParams(const AtNodeEntry *entry)
+{
+   static const std::bitset<PARAM_COUNT> sNone;
+   
+   if (!entry)
+   {
+      return sNone;
+   }
+   
+   const char *name = AiNodeEntryGetName(entry);
+   size_t i = 0;
+   
+   for (; i<gEntryParams.size(); ++i)
+   {
+      if (gEntryParams[i].entry == entry)
+      {
+         // Node entries may be re-allocated when arnold universe is restarted
+         if (gEntryParams[i].name == name)
+         {
+            return gEntryParams[i].builtin;
+         }
+         break;
+      }
+   }
+   
+   if (i >= gEntryParams.size())
+   {
+      gEntryParams.push_back(CEntryParams());
+   }
+   
+   CEntryParams &ep = gEntryParams[i];
+   
+   ep.entry = entry;
+   ep.name = name;
+   ep.builtin.reset();
+   
+   for (int p=0; p<PARAM_COUNT; ++p)
+   {
+      if (AiNodeEntryLookUpParameter(entry, gParams[p].name) != NULL)
+      {
+         ep.builtin.set(p);
+      }
+   }
+   
+   return ep.builtin;
+}
+
+CNodeParams::CNodeParams()
+   : m_node(0)
+{
+}
+
+void CNodeParams::reset(AtNode *node)
+{
+   m_node = node;
+   m_builtin = GetBuiltinParams(node ? AiNodeGetNodeEntry(node) : NULL);
+   m_user.reset();
+}
+
+bool CNodeParams::has(ParamId id, bool declare)
+{
+   if (m_builtin.test(id) || m_user.test(id))
+   {
+      return true;
+   }
+   else if (!m_node)
+   {
+      return false;
+   }
+   
+   const char *name = gParams[id].name;
+   
+   if (AiNodeLookUpUserParameter(m_node, name) != NULL ||
+       (declare && gParams[id].decl != NULL && AiNodeDeclare(m_node, name, gParams[id].decl)))
+   {
+      m_user.set(id);
+      return true;
+   }
+   else
+   {
+      return false;
+   }
+}
@@ -0,0 +1,106 @@
+#ifndef __params_h__
+#define __params_h__
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+// Arnold parameters the extension knows how to export for scripted shapes
+enum ParamId
+{
+   PARAM_MATRIX = 0,
+   PARAM_MIN,
+   PARAM_MAX,
+   PARAM_SUBDIV_TYPE,
+   PARAM_SUBDIV_ITERATIONS,
+   PARAM_SUBDIV_ADAPTIVE_METRIC,
+   PARAM_SUBDIV_PIXEL_ERROR,
+   PARAM_SUBDIV_DICING_CAMERA,
+   PARAM_SUBDIV_UV_SMOOTHING,
+   PARAM_SUBDIV_SMOOTH_DERIVS,
+   PARAM_SMOOTHING,
+   PARAM_DISP_HEIGHT,
+   PARAM_DISP_ZERO_VALUE,
+   PARAM_DISP_AUTOBUMP,
+   PARAM_DISP_PADDING,
+   PARAM_DISP_MAP,
+   PARAM_SSS_SAMPLE_DISTRIBUTION,
+   PARAM_SSS_SAMPLE_SPACING,
+   PARAM_MIN_PIXEL_WIDTH,
+   PARAM_MODE,
+   PARAM_BASIS,
+   PARAM_NODE,
+   PARAM_INHERIT_XFORM,
+   PARAM_STEP_SIZE,
+   PARAM_SIDEDNESS,
+   PARAM_INVERT_NORMALS,
+   PARAM_RECEIVE_SHADOWS,
+   PARAM_SELF_SHADOWS,
+   PARAM_OPAQUE,
+   PARAM_MATTE,
+   PARAM_VISIBILITY,
+   PARAM_SSS_SETNAME,
+   PARAM_SHADER,
+   PARAM_COUNT
+};
+
+struct AtNode;
+struct AtNodeEntry;
+
+const char* GetParamName(ParamId id);
+
+// Declaration used when the parameter has to be added as a user parameter, NULL if it shouldn't be
+const char* GetParamDeclaration(ParamId id);
+
+// Returns PARAM_COUNT if name is not a known parameter
+ParamId FindParam(const char *name);
+
+// Set of parameters explicitly set by a translator Export function
+class COverrides
+{
+public:
+   
+   COverrides();
+   
+   void clear();
+   void assign(const std::vector<std::string> &names);
+   void insert(const std::string &name);
+   
+   inline bool has(ParamId id) const { return m_known.test(id); }
+   bool has(const char *name) const;
+   
+   inline const std::vector<std::string>& unknown() const { return m_unknown; }
+   
+private:
+   
+   std::bitset<PARAM_COUNT> m_known;
+   std::vector<std::string> m_unknown;
+};
+
+// Known parameters that are builtin to an arnold node entry, looked up once per entry
+const std::bitset<PARAM_COUNT>& GetBuiltinParams(const AtNodeEntry *entry);
+
+// Availability of known parameters on an arnold node
+class CNodeParams
+{
+public:
+   
+   CNodeParams();
+   
+   void reset(AtNode *node);
+   
+   inline AtNode* node() const { return m_node; }
+   inline bool builtin(ParamId id) const { return m_builtin.test(id); }
+   
+   // Whether the parameter exists either as a builtin or a user parameter
+   // Missing user parameters are declared when declare is true and the parameter has a known declaration
+   bool has(ParamId id, bool declare=true);
+   
+private:
+   
+   AtNode *m_node;
+   std::bitset<PARAM_COUNT> m_builtin;
+   std::bitset<PARAM_COUNT> m_user;
+};
+
+#endif
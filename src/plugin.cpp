@@ -1,15 +1,56 @@
 #include "shapetranslator.h"
 #include "nodetranslator.h"
 #include "plugin.h"
+#include "shadingengine.h"
+#include "nodeentrycache.h"
+#include "cache.h"
+#include "stats.h"
+#include "replay.h"
 
 #define MNoVersionString
 #define MNoPluginEntry
 #include <maya/MFnPlugin.h>
 #include <maya/MSceneMessage.h>
 
-std::map<std::string, CScriptedTranslator> gTranslators;
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+std::vector<CScriptedTranslator*> gTranslators;
 MCallbackId gPluginLoadedCallbackId = 0;
 
+// Deferred translators node types, by required maya plugin name
+static std::map<std::string, std::vector<std::string> > gPendingTranslators;
+
+
+struct CNodeTypeLess
+{
+   bool operator()(const CScriptedTranslator *t, const std::string &nodeType) const
+   {
+      return (t->nodeType < nodeType);
+   }
+   bool operator()(const std::string &nodeType, const CScriptedTranslator *t) const
+   {
+      return (nodeType < t->nodeType);
+   }
+   bool operator()(const CScriptedTranslator *t0, const CScriptedTranslator *t1) const
+   {
+      return (t0->nodeType < t1->nodeType);
+   }
+};
+
+CScriptedTranslator* FindTranslator(const char *nodeType)
+{
+   std::string key(nodeType ? nodeType : "");
+   
+   std::vector<CScriptedTranslator*>::iterator it = std::lower_bound(gTranslators.begin(), gTranslators.end(), key, CNodeTypeLess());
+   
+   return ((it != gTranslators.end() && (*it)->nodeType == key) ? *it : NULL);
+}
+
 
 static const char* gModuleSetup =
 "import os, sys, glob\n\
@@ -24,44 +65,37 @@ for d in os.environ.get(\"MTOA_EXTENSIONS_PATH\", \"\").split(os.pathsep):\n\
 void MayaPluginLoadedCallback(const MStringArray &strs, void *)
 {
    // 0 = pluginPath, 1 = pluginName
-   MString pluginName = strs[1];
+   std::map<std::string, std::vector<std::string> >::iterator pit = gPendingTranslators.find(strs[1].asChar());
    
-   // Start the arnold universe so that attribute helpers can query arnold nodes
-   bool AiUniverseCreated = false;
-   if (!AiUniverseIsActive())
+   if (pit == gPendingTranslators.end())
    {
-      AiMsgSetConsoleFlags(AI_LOG_NONE);
-      AiMsgSetLogFileFlags(AI_LOG_NONE);
-      
-      AiBegin();
-      
-      MString pluginPath = MString("$ARNOLD_PLUGIN_PATH").expandEnvironmentVariablesAndTilde();
-      if (pluginPath.length() > 0)
-      {
-         AiLoadPlugins(pluginPath.asChar());
-      }
-      
-      AiUniverseCreated = true;
+      return;
    }
    
-   std::map<std::string, CScriptedTranslator>::iterator it = gTranslators.begin();
-   while (it != gTranslators.end())
+   std::vector<std::string> nodeTypes;
+   nodeTypes.swap(pit->second);
+   gPendingTranslators.erase(pit);
+   
+   // Keep any arnold universe started to describe node entries missing from the cache alive for all translators
+   BeginNodeEntryQueries();
+   
+   for (size_t i=0; i<nodeTypes.size(); ++i)
    {
-      if (!it->second.attrsAdded)
+      CScriptedTranslator *translator = FindTranslator(nodeTypes[i].c_str());
+      
+      if (translator && !translator->attrsAdded)
       {
-         if (it->second.requiredPlugin == pluginName)
-         {
-            // Provider name ?
-            CAbTranslator context("scriptedTranslators", "", MString(it->first.c_str()));
-            NodeInitializer(context);
-         }
+         // Provider name ?
+         CAbTranslator context("scriptedTranslators", "", MString(translator->nodeType.c_str()));
+         NodeInitializer(context);
       }
-      ++it;
    }
    
-   if (AiUniverseCreated)
+   EndNodeEntryQueries();
+   
+   if (gPendingTranslators.empty())
    {
-      AiEnd();
+      RemovePluginLoadedCallback();
    }
 }
 
@@ -146,443 +180,1516 @@ float GetSampleFrame(CArnoldSession *session, unsigned int step)
 }
 #endif
 
+// Values are parsed in place from the declaration string:
+//   array elements are counted first, the AtArray allocated once and each element written directly
+//   element parsing is resolved per type at compile time through CValueParser specializations
+
+static const char* SkipSpaces(const char *p, const char *end)
+{
+   while (p < end && (*p == ' ' || *p == '\t'))
+   {
+      ++p;
+   }
+   return p;
+}
+
+static bool ParseInteger(const char *p, const char *end, long minValue, unsigned long maxValue, long &value)
+{
+   char *e = NULL;
+   
+   p = SkipSpaces(p, end);
+   
+   if (p >= end)
+   {
+      return false;
+   }
+   
+   if (*p == '-')
+   {
+      value = strtol(p, &e, 10);
+      if (e == p || e > end || value < minValue)
+      {
+         return false;
+      }
+   }
+   else
+   {
+      unsigned long uvalue = strtoul(p, &e, 10);
+      if (e == p || e > end || uvalue > maxValue)
+      {
+         return false;
+      }
+      value = (long) uvalue;
+   }
+   
+   return true;
+}
+
+// Comma separated floats (points, vectors, colors and matrices)
+static bool ParseFloats(const char *p, const char *end, float *values, int count)
+{
+   char *e = NULL;
+   
+   for (int i=0; i<count; ++i)
+   {
+      p = SkipSpaces(p, end);
+      
+      if (p >= end)
+      {
+         return false;
+      }
+      
+      values[i] = (float) strtod(p, &e);
+      
+      if (e == p || e > end)
+      {
+         return false;
+      }
+      
+      p = e;
+      
+      if (i + 1 < count)
+      {
+         p = SkipSpaces(p, end);
+         if (p >= end || *p != ',')
+         {
+            return false;
+         }
+         ++p;
+      }
+   }
+   
+   return true;
+}
+
+static bool TokenEquals(const char *p, const char *end, const char *s)
+{
+   size_t len = strlen(s);
+   return ((size_t)(end - p) == len && !strncmp(p, s, len));
+}
+
+template <int T> struct CValueParser;
+
+template <> struct CValueParser<AI_TYPE_BOOLEAN>
+{
+   typedef bool Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v)
+   {
+      if (TokenEquals(p, end, "1") || TokenEquals(p, end, "on") || TokenEquals(p, end, "true") || TokenEquals(p, end, "True"))
+      {
+         v = true;
+         return true;
+      }
+      else if (TokenEquals(p, end, "0") || TokenEquals(p, end, "off") || TokenEquals(p, end, "false") || TokenEquals(p, end, "False"))
+      {
+         v = false;
+         return true;
+      }
+      return false;
+   }
+   static void Store(AtParamValue *val, const Type &v) { val->BOOL = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetBool(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_BYTE>
+{
+   // scriptedTranslatorUtils writes bytes as integers
+   typedef AtByte Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v)
+   {
+      long l = 0;
+      if (!ParseInteger(p, end, 0, 255, l))
+      {
+         return false;
+      }
+      v = (AtByte) l;
+      return true;
+   }
+   static void Store(AtParamValue *val, const Type &v) { val->BYTE = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetByte(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_INT>
+{
+   typedef int Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v)
+   {
+      long l = 0;
+      if (!ParseInteger(p, end, INT_MIN, INT_MAX, l))
+      {
+         return false;
+      }
+      v = (int) l;
+      return true;
+   }
+   static void Store(AtParamValue *val, const Type &v) { val->INT = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetInt(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_UINT>
+{
+   typedef unsigned int Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v)
+   {
+      long l = 0;
+      if (!ParseInteger(p, end, 0, UINT_MAX, l))
+      {
+         return false;
+      }
+      v = (unsigned int) (unsigned long) l;
+      return true;
+   }
+   static void Store(AtParamValue *val, const Type &v) { val->UINT = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetUInt(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_ENUM>
+{
+   // Enum name or index
+   typedef int Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &data, Type &v)
+   {
+      for (unsigned int i=0; i<data.enums.length(); ++i)
+      {
+         if (TokenEquals(p, end, data.enums[i].asChar()))
+         {
+            v = (int) i;
+            return true;
+         }
+      }
+      long l = 0;
+      if (!ParseInteger(p, end, 0, UINT_MAX, l) || (unsigned long) l >= data.enums.length())
+      {
+         return false;
+      }
+      v = (int) l;
+      return true;
+   }
+   static void Store(AtParamValue *val, const Type &v) { val->INT = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetInt(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_FLOAT>
+{
+   typedef float Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &v, 1); }
+   static void Store(AtParamValue *val, const Type &v) { val->FLT = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetFlt(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_POINT2>
+{
+   typedef AtPoint2 Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.x), 2); }
+   static void Store(AtParamValue *val, const Type &v) { val->PNT2 = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetPnt2(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_POINT>
+{
+   typedef AtPoint Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.x), 3); }
+   static void Store(AtParamValue *val, const Type &v) { val->PNT = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetPnt(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_VECTOR>
+{
+   typedef AtVector Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.x), 3); }
+   static void Store(AtParamValue *val, const Type &v) { val->VEC = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetVec(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_RGB>
+{
+   typedef AtRGB Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.r), 3); }
+   static void Store(AtParamValue *val, const Type &v) { val->RGB = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetRGB(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_RGBA>
+{
+   typedef AtRGBA Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.r), 4); }
+   static void Store(AtParamValue *val, const Type &v) { val->RGBA = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetRGBA(array, i, v); }
+};
+
+struct CMatrixValue
+{
+   AtMatrix m;
+};
+
+template <> struct CValueParser<AI_TYPE_MATRIX>
+{
+   typedef CMatrixValue Type;
+   static bool Parse(const char *p, const char *end, const CAttrData &, Type &v) { return ParseFloats(p, end, &(v.m[0][0]), 16); }
+   static void Store(AtParamValue *val, const Type &v)
+   {
+      // Single values own their matrix (see DestroyValue)
+      val->pMTX = (AtMatrix*) malloc(sizeof(AtMatrix));
+      memcpy(val->pMTX, v.m, sizeof(AtMatrix));
+   }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetMtx(array, i, *const_cast<AtMatrix*>(&(v.m))); }
+};
+
+template <> struct CValueParser<AI_TYPE_STRING>
+{
+   // Tokens are null terminated (see ParseStringArray)
+   typedef const char* Type;
+   static bool Parse(const char *p, const char *, const CAttrData &, Type &v) { v = p; return true; }
+   static void Store(AtParamValue *val, const Type &v)
+   {
+      // Single values own their string (see DestroyValue)
+      char *tmp = new char[strlen(v)+1];
+      strcpy(tmp, v);
+      val->STR = tmp;
+   }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetStr(array, i, v); }
+};
+
+template <> struct CValueParser<AI_TYPE_NODE>
+{
+   typedef void* Type;
+   static bool Parse(const char *, const char *, const CAttrData &, Type &v) { v = NULL; return true; }
+   static void Store(AtParamValue *val, const Type &v) { val->PTR = v; }
+   static void Store(AtArray *array, AtUInt32 i, const Type &v) { AiArraySetPtr(array, i, v); }
+};
+
+// str holds len characters followed by a null character, separator is either ';' or '\0'
+template <int T>
+static bool ParseValue(const char *str, size_t len, char separator, const CAttrData &data, AtParamValue *val)
+{
+   typedef CValueParser<T> Parser;
+   typename Parser::Type v;
+   const char *end = str + len;
+   
+   if (!data.isArray)
+   {
+      if (!Parser::Parse(str, end, data, v))
+      {
+         return false;
+      }
+      Parser::Store(val, v);
+      return true;
+   }
+   
+   AtUInt32 count = 1;
+   
+   for (const char *p=str; p<end; ++p)
+   {
+      if (*p == separator)
+      {
+         ++count;
+      }
+   }
+   
+   AtArray *array = AiArrayAllocate(count, 1, (AtByte) data.type);
+   AtUInt32 n = 0;
+   const char *p0 = str;
+   
+   while (p0 <= end)
+   {
+      const char *p1 = (const char*) memchr(p0, separator, end - p0);
+      
+      if (!p1)
+      {
+         p1 = end;
+      }
+      
+      // Invalid elements are skipped
+      if (Parser::Parse(p0, p1, data, v))
+      {
+         Parser::Store(array, n++, v);
+      }
+      
+      p0 = p1 + 1;
+   }
+   
+   // Drop the trailing elements left unset by invalid ones
+   array->nelements = n;
+   
+   val->ARRAY = array;
+   
+   return true;
+}
+
 bool StringToValue(const std::string &sval, CAttrData &data, AtParamValue *val)
+{
+   const char *str = sval.c_str();
+   size_t len = sval.length();
+   
+   switch (data.type)
+   {
+   case AI_TYPE_BOOLEAN:
+      return ParseValue<AI_TYPE_BOOLEAN>(str, len, ';', data, val);
+   case AI_TYPE_BYTE:
+      return ParseValue<AI_TYPE_BYTE>(str, len, ';', data, val);
+   case AI_TYPE_INT:
+      return ParseValue<AI_TYPE_INT>(str, len, ';', data, val);
+   case AI_TYPE_UINT:
+      return ParseValue<AI_TYPE_UINT>(str, len, ';', data, val);
+   case AI_TYPE_ENUM:
+      return ParseValue<AI_TYPE_ENUM>(str, len, ';', data, val);
+   case AI_TYPE_FLOAT:
+      return ParseValue<AI_TYPE_FLOAT>(str, len, ';', data, val);
+   case AI_TYPE_POINT2:
+      return ParseValue<AI_TYPE_POINT2>(str, len, ';', data, val);
+   case AI_TYPE_POINT:
+      return ParseValue<AI_TYPE_POINT>(str, len, ';', data, val);
+   case AI_TYPE_VECTOR:
+      return ParseValue<AI_TYPE_VECTOR>(str, len, ';', data, val);
+   case AI_TYPE_RGB:
+      return ParseValue<AI_TYPE_RGB>(str, len, ';', data, val);
+   case AI_TYPE_RGBA:
+      return ParseValue<AI_TYPE_RGBA>(str, len, ';', data, val);
+   case AI_TYPE_MATRIX:
+      return ParseValue<AI_TYPE_MATRIX>(str, len, ';', data, val);
+   case AI_TYPE_STRING:
+      if (data.isArray)
+      {
+         // Single copy of the declaration with separators replaced by null characters
+         std::vector<char> buffer(str, str + len + 1);
+         std::replace(buffer.begin(), buffer.end() - 1, ';', '\0');
+         return ParseValue<AI_TYPE_STRING>(&buffer[0], len, '\0', data, val);
+      }
+      return ParseValue<AI_TYPE_STRING>(str, len, '\0', data, val);
+   case AI_TYPE_NODE:
+      return ParseValue<AI_TYPE_NODE>(str, len, ';', data, val);
+   default:
+      return false;
+   }
+}
+
+void DestroyValue(CAttrData &data, AtParamValue *val)
 {
    if (data.isArray)
    {
-      // Temporarily reset isArray so we can call StringToValue for each element
-      data.isArray = false;
-      
-      std::string elt;
-      std::vector<AtParamValue> values;
-      AtParamValue eval;
-      size_t p0 = 0, p1 = sval.find(';', p0);
-      while (p1 != std::string::npos)
+      AiArrayDestroy(val->ARRAY);
+   }
+   else
+   {
+      switch (data.type)
+      {
+      case AI_TYPE_STRING:
+         delete[] val->STR;
+         break;
+      case AI_TYPE_MATRIX:
+         free(val->pMTX);
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+static bool ElementToString(const CAttrData &data, const AtArray *array, AtUInt32 i, const AtParamValue *val, std::string &sval)
+{
+   char buffer[512];
+   
+   switch (data.type)
+   {
+   case AI_TYPE_BOOLEAN:
+      sval = ((array ? AiArrayGetBool(array, i) : val->BOOL) ? "1" : "0");
+      return true;
+   case AI_TYPE_BYTE:
+      sprintf(buffer, "%u", (unsigned int) (array ? AiArrayGetByte(array, i) : val->BYTE));
+      break;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      sprintf(buffer, "%d", (array ? AiArrayGetInt(array, i) : val->INT));
+      break;
+   case AI_TYPE_UINT:
+      sprintf(buffer, "%u", (array ? AiArrayGetUInt(array, i) : val->UINT));
+      break;
+   case AI_TYPE_FLOAT:
+      sprintf(buffer, "%.9g", (array ? AiArrayGetFlt(array, i) : val->FLT));
+      break;
+   case AI_TYPE_POINT2:
+      {
+         AtPoint2 p = (array ? AiArrayGetPnt2(array, i) : val->PNT2);
+         sprintf(buffer, "%.9g,%.9g", p.x, p.y);
+      }
+      break;
+   case AI_TYPE_POINT:
+      {
+         AtPoint p = (array ? AiArrayGetPnt(array, i) : val->PNT);
+         sprintf(buffer, "%.9g,%.9g,%.9g", p.x, p.y, p.z);
+      }
+      break;
+   case AI_TYPE_VECTOR:
       {
-         elt = sval.substr(p0, p1-p0);
-         if (StringToValue(elt, data, &eval))
+         AtVector v = (array ? AiArrayGetVec(array, i) : val->VEC);
+         sprintf(buffer, "%.9g,%.9g,%.9g", v.x, v.y, v.z);
+      }
+      break;
+   case AI_TYPE_RGB:
+      {
+         AtRGB c = (array ? AiArrayGetRGB(array, i) : val->RGB);
+         sprintf(buffer, "%.9g,%.9g,%.9g", c.r, c.g, c.b);
+      }
+      break;
+   case AI_TYPE_RGBA:
+      {
+         AtRGBA c = (array ? AiArrayGetRGBA(array, i) : val->RGBA);
+         sprintf(buffer, "%.9g,%.9g,%.9g,%.9g", c.r, c.g, c.b, c.a);
+      }
+      break;
+   case AI_TYPE_MATRIX:
+      {
+         AtMatrix m;
+         if (array)
          {
-            values.push_back(eval);
+            AiArrayGetMtx(array, i, m);
          }
-         p0 = p1 + 1;
-         p1 = sval.find(';', p0);
+         else if (val->pMTX)
+         {
+            AiM4Copy(m, *(val->pMTX));
+         }
+         else
+         {
+            return false;
+         }
+         sprintf(buffer, "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g",
+                 m[0][0], m[0][1], m[0][2], m[0][3],
+                 m[1][0], m[1][1], m[1][2], m[1][3],
+                 m[2][0], m[2][1], m[2][2], m[2][3],
+                 m[3][0], m[3][1], m[3][2], m[3][3]);
+      }
+      break;
+   case AI_TYPE_STRING:
+      {
+         const char *str = (array ? AiArrayGetStr(array, i) : val->STR);
+         sval = (str ? str : "");
+         // Separators can't be escaped
+         return (sval.find_first_of(array ? "|;\n" : "|\n") == std::string::npos);
       }
-      elt = sval.substr(p0);
-      if (StringToValue(elt, data, &eval))
+   case AI_TYPE_NODE:
+      sval = "";
+      return true;
+   default:
+      return false;
+   }
+   
+   sval = buffer;
+   
+   return true;
+}
+
+bool ValueToString(const CAttrData &data, const AtParamValue *val, std::string &sval)
+{
+   if (data.isArray)
+   {
+      std::string elt;
+      
+      sval = "";
+      
+      if (!val->ARRAY)
       {
-         values.push_back(eval);
+         return true;
       }
       
-      val->ARRAY = AiArrayAllocate(values.size(), 1, data.type);
-      for (size_t i=0; i<values.size(); ++i)
+      for (AtUInt32 i=0; i<val->ARRAY->nelements; ++i)
       {
-         switch (data.type)
+         if (!ElementToString(data, val->ARRAY, i, val, elt))
+         {
+            return false;
+         }
+         if (i > 0)
          {
-         case AI_TYPE_BOOLEAN:
-            AiArraySetBool(val->ARRAY, i, values[i].BOOL);
-            break;
-         case AI_TYPE_BYTE:
-            AiArraySetByte(val->ARRAY, i, values[i].BYTE);
-            break;
-         case AI_TYPE_INT:
-            AiArraySetInt(val->ARRAY, i, values[i].INT);
-            break;
-         case AI_TYPE_UINT:
-            AiArraySetUInt(val->ARRAY, i, values[i].UINT);
-            break;
-         case AI_TYPE_ENUM:
-            AiArraySetInt(val->ARRAY, i, values[i].INT);
-            break;
-         case AI_TYPE_FLOAT:
-            AiArraySetFlt(val->ARRAY, i, values[i].FLT);
-            break;
-         case AI_TYPE_POINT2:
-            AiArraySetPnt2(val->ARRAY, i, values[i].PNT2);
-            break;
-         case AI_TYPE_POINT:
-            AiArraySetPnt(val->ARRAY, i, values[i].PNT);
-            break;
-         case AI_TYPE_VECTOR:
-            AiArraySetVec(val->ARRAY, i, values[i].VEC);
-            break;
-         case AI_TYPE_RGB:
-            AiArraySetRGB(val->ARRAY, i, values[i].RGB);
-            break;
-         case AI_TYPE_RGBA:
-            AiArraySetRGBA(val->ARRAY, i, values[i].RGBA);
-            break;
-         case AI_TYPE_MATRIX:
-            AiArraySetMtx(val->ARRAY, i, *(values[i].pMTX));
-            break;
-         case AI_TYPE_STRING:
-            AiArraySetStr(val->ARRAY, i, values[i].STR);
-            break;
-         case AI_TYPE_NODE:
-            AiArraySetPtr(val->ARRAY, i, NULL);
-            break;
-         default:
-            break;
+            sval += ";";
          }
-         DestroyValue(data, &(values[i]));
+         sval += elt;
+      }
+      
+      return true;
+   }
+   else
+   {
+      return ElementToString(data, NULL, 0, val, sval);
+   }
+}
+
+bool ParseAttrDeclaration(const std::string &decl, CAttrData &data, CAttrDeclaration &fields)
+{
+   std::string *dsts[] = {NULL, &fields.arnoldNode, &fields.arnoldAttr, NULL, NULL, NULL,
+                          &fields.defaultValue, &fields.min, &fields.max, &fields.softMin, &fields.softMax,
+                          NULL, NULL};
+   std::string field;
+   size_t p0 = 0, p1 = 0;
+   
+   for (int i=0; i<13; ++i)
+   {
+      p1 = decl.find('|', p0);
+      
+      // enums are the last field
+      if ((i < 12) != (p1 != std::string::npos))
+      {
+         return false;
+      }
+      
+      field = (i < 12 ? decl.substr(p0, p1-p0) : decl.substr(p0));
+      
+      switch (i)
+      {
+      case 0:
+         // attribute type
+         if (sscanf(field.c_str(), "%d", &data.type) != 1)
+         {
+            return false;
+         }
+         break;
+      case 3:
+         data.name = field.c_str();
+         break;
+      case 4:
+         data.shortName = field.c_str();
+         break;
+      case 5:
+         data.isArray = (field == "1");
+         break;
+      case 11:
+         data.keyable = (field == "1");
+         break;
+      case 12:
+         {
+            size_t p2 = 0, p3 = field.find(',', p2);
+            while (p3 != std::string::npos)
+            {
+               data.enums.append(field.substr(p2, p3-p2).c_str());
+               p2 = p3 + 1;
+               p3 = field.find(',', p2);
+            }
+            data.enums.append(field.substr(p2).c_str());
+         }
+         break;
+      default:
+         dsts[i]->swap(field);
+         break;
+      }
+      
+      p0 = p1 + 1;
+   }
+   
+   if (fields.arnoldNode.length() == 0)
+   {
+      fields.arnoldNode = "procedural";
+   }
+   
+   return true;
+}
+
+bool FormatAttrDeclaration(const CAttrData &data, const std::string &arnoldNode, const std::string &arnoldAttr, bool hasDefault, std::string &decl)
+{
+   const AtParamValue *vals[] = {(hasDefault ? &data.defaultValue : NULL),
+                                 (data.hasMin ? &data.min : NULL),
+                                 (data.hasMax ? &data.max : NULL),
+                                 (data.hasSoftMin ? &data.softMin : NULL),
+                                 (data.hasSoftMax ? &data.softMax : NULL)};
+   std::string sval;
+   char buffer[16];
+   
+   sprintf(buffer, "%d", data.type);
+   
+   decl = buffer;
+   decl += "|" + arnoldNode;
+   decl += "|" + arnoldAttr;
+   decl += "|" + std::string(data.name.asChar());
+   decl += "|" + std::string(data.shortName.asChar());
+   decl += (data.isArray ? "|1" : "|0");
+   
+   for (int i=0; i<5; ++i)
+   {
+      sval = "";
+      if (vals[i] && !ValueToString(data, vals[i], sval))
+      {
+         return false;
+      }
+      decl += "|" + sval;
+   }
+   
+   decl += (data.keyable ? "|1|" : "|0|");
+   
+   for (unsigned int i=0; i<data.enums.length(); ++i)
+   {
+      if (i > 0)
+      {
+         decl += ",";
+      }
+      decl += data.enums[i].asChar();
+   }
+   
+   return true;
+}
+
+bool ReadAttrValues(const CAttrDeclaration &fields, CAttrData &data)
+{
+   bool hasDefault = StringToValue(fields.defaultValue, data, &(data.defaultValue));
+   
+   data.hasMin = false;
+   data.hasMax = false;
+   data.hasSoftMin = false;
+   data.hasSoftMax = false;
+   
+   if (data.type == AI_TYPE_BYTE ||
+       data.type == AI_TYPE_INT ||
+       data.type == AI_TYPE_UINT ||
+       data.type == AI_TYPE_FLOAT)
+   {
+      data.hasMin = StringToValue(fields.min, data, &(data.min));
+      data.hasMax = StringToValue(fields.max, data, &(data.max));
+      data.hasSoftMin = StringToValue(fields.softMin, data, &(data.softMin));
+      data.hasSoftMax = StringToValue(fields.softMax, data, &(data.softMax));
+   }
+   
+   return hasDefault;
+}
+
+void ReleaseAttrValues(CAttrData &data, bool hasDefault)
+{
+   if (hasDefault) DestroyValue(data, &(data.defaultValue));
+   if (data.hasMin) DestroyValue(data, &(data.min));
+   if (data.hasMax) DestroyValue(data, &(data.max));
+   if (data.hasSoftMin) DestroyValue(data, &(data.softMin));
+   if (data.hasSoftMax) DestroyValue(data, &(data.softMax));
+}
+
+// Single values are allocated as StringToValue does, arrays are moved from the record
+static bool ArrayToValue(const CAttrData &data, AtArray *&array, AtParamValue *val)
+{
+   if (data.isArray)
+   {
+      val->ARRAY = array;
+      array = NULL;
+      return true;
+   }
+   
+   if (array->nelements == 0)
+   {
+      return false;
+   }
+   
+   switch (data.type)
+   {
+   case AI_TYPE_BOOLEAN:
+      val->BOOL = AiArrayGetBool(array, 0);
+      return true;
+   case AI_TYPE_BYTE:
+      val->BYTE = AiArrayGetByte(array, 0);
+      return true;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      val->INT = AiArrayGetInt(array, 0);
+      return true;
+   case AI_TYPE_UINT:
+      val->UINT = AiArrayGetUInt(array, 0);
+      return true;
+   case AI_TYPE_FLOAT:
+      val->FLT = AiArrayGetFlt(array, 0);
+      return true;
+   case AI_TYPE_POINT2:
+      val->PNT2 = AiArrayGetPnt2(array, 0);
+      return true;
+   case AI_TYPE_POINT:
+      val->PNT = AiArrayGetPnt(array, 0);
+      return true;
+   case AI_TYPE_VECTOR:
+      val->VEC = AiArrayGetVec(array, 0);
+      return true;
+   case AI_TYPE_RGB:
+      val->RGB = AiArrayGetRGB(array, 0);
+      return true;
+   case AI_TYPE_RGBA:
+      val->RGBA = AiArrayGetRGBA(array, 0);
+      return true;
+   case AI_TYPE_MATRIX:
+      {
+         CMatrixValue m;
+         AiArrayGetMtx(array, 0, m.m);
+         CValueParser<AI_TYPE_MATRIX>::Store(val, m);
+      }
+      return true;
+   case AI_TYPE_STRING:
+      {
+         const char *str = AiArrayGetStr(array, 0);
+         CValueParser<AI_TYPE_STRING>::Store(val, (str ? str : ""));
+      }
+      return true;
+   case AI_TYPE_NODE:
+      val->PTR = NULL;
+      return true;
+   default:
+      return false;
+   }
+}
+
+// Structured SetupAttrs record counterpart of ParseAttrDeclaration and ReadAttrValues
+//   returns whether or not a default value was read
+static bool ReadAttrRecord(CPyAttrRecord &record, CAttrData &data, CAttrDeclaration &fields)
+{
+   fields.arnoldNode = (record.arnoldNode.length() > 0 ? record.arnoldNode : "procedural");
+   fields.arnoldAttr = record.arnoldAttr;
+   
+   data.type = record.type;
+   data.name = record.name.c_str();
+   data.shortName = record.shortName.c_str();
+   data.isArray = record.isArray;
+   data.keyable = record.keyable;
+   
+   for (size_t i=0; i<record.enums.size(); ++i)
+   {
+      data.enums.append(record.enums[i].c_str());
+   }
+   
+   bool hasDefault = false;
+   bool numeric = (data.type == AI_TYPE_BYTE ||
+                   data.type == AI_TYPE_INT ||
+                   data.type == AI_TYPE_UINT ||
+                   data.type == AI_TYPE_FLOAT);
+   AtParamValue *vals[] = {&data.defaultValue, &data.min, &data.max, &data.softMin, &data.softMax};
+   bool *flags[] = {&hasDefault, &data.hasMin, &data.hasMax, &data.hasSoftMin, &data.hasSoftMax};
+   
+   for (int i=0; i<PYATTR_VALUE_COUNT; ++i)
+   {
+      *(flags[i]) = (record.values[i] && (i == PYATTR_DEFAULT || numeric) && ArrayToValue(data, record.values[i], vals[i]));
+   }
+   
+   return hasDefault;
+}
+
+CScriptedTranslator::CScriptedTranslator()
+   : exportFunc(0), cleanupFunc(0), exportBatchFunc(0), exportInstanceFunc(0), exportMotionFunc(0), cleanupBatchFunc(0), setupAttrsFunc(0)
+   , isShape(true), supportInstances(false), supportVolumes(false), supportMotionBounds(false), prefetchMotionMatrices(false), supportReplay(false), fastInstances(false), attrsAdded(false), deferred(false), loaded(false)
+{
+}
+
+CScriptedBatchEntry::CScriptedBatchEntry()
+   : owner(0), node(0), masterNode(0), numSteps(1), joined(false), cleanupPending(false), exportedNode(0)
+{
+}
+
+static MString GetMayaNodeName(const CScriptedBatchEntry &entry)
+{
+   return (entry.dagPath.isValid() ? entry.dagPath.partialPathName() : MFnDependencyNode(entry.object).name());
+}
+
+// mayaName and masterMayaName hold the strings names point to
+static void GetNodeNames(const CScriptedBatchEntry &entry, MString &mayaName, MString &masterMayaName, CPyNodeNames &names)
+{
+   mayaName = GetMayaNodeName(entry);
+   names.mayaName = mayaName.asChar();
+   names.arnoldName = AiNodeGetName(entry.node);
+   
+   if (entry.masterNode)
+   {
+      masterMayaName = entry.masterDagPath.partialPathName();
+      names.masterMayaName = masterMayaName.asChar();
+      names.masterArnoldName = AiNodeGetName(entry.masterNode);
+   }
+   else
+   {
+      names.masterMayaName = NULL;
+      names.masterArnoldName = NULL;
+   }
+}
+
+static void FlushCleanupBatch(CScriptedTranslator &translator)
+{
+   std::vector<MString> mayaNames(2 * translator.batchEntries.size());
+   std::vector<CPyNodeNames> names;
+   
+   names.reserve(translator.batchEntries.size());
+   
+   for (size_t i=0; i<translator.batchEntries.size(); ++i)
+   {
+      CScriptedBatchEntry *entry = translator.batchEntries[i];
+      
+      if (entry->cleanupPending)
+      {
+         names.push_back(CPyNodeNames());
+         GetNodeNames(*entry, mayaNames[2*i], mayaNames[2*i+1], names.back());
+         entry->cleanupPending = false;
+      }
+   }
+   
+   if (names.size() > 0)
+   {
+      if (!PyCallCleanupBatch(translator.cleanupBatchFunc, names))
+      {
+         AiMsgError("[mtoa.scriptedTranslators] Failed to cleanup %u node(s).", (unsigned int) names.size());
+      }
+   }
+}
+
+void AddBatchEntry(CScriptedTranslator &translator, CScriptedBatchEntry *entry)
+{
+   if (entry->owner != &translator)
+   {
+      RemoveBatchEntry(entry);
+      
+      translator.batchEntries.push_back(entry);
+      entry->owner = &translator;
+   }
+   
+   // Arnold node (re)created, its export is about to start
+   entry->joined = true;
+   entry->steps.clear();
+   entry->results.clear();
+}
+
+void RemoveBatchEntry(CScriptedBatchEntry *entry)
+{
+   CScriptedTranslator *translator = entry->owner;
+   
+   if (!translator)
+   {
+      return;
+   }
+   
+   if (entry->cleanupPending)
+   {
+      FlushCleanupBatch(*translator);
+   }
+   
+   std::vector<CScriptedBatchEntry*>::iterator it = std::find(translator->batchEntries.begin(), translator->batchEntries.end(), entry);
+   if (it != translator->batchEntries.end())
+   {
+      translator->batchEntries.erase(it);
+   }
+   
+   entry->owner = 0;
+   entry->joined = false;
+   entry->steps.clear();
+   entry->results.clear();
+}
+
+// Called when entry starts exporting, steps batched during a previous export are forgotten
+static void JoinExportPass(CScriptedBatchEntry &entry)
+{
+   entry.joined = true;
+   entry.steps.clear();
+   entry.results.clear();
+}
+
+// Once all its steps are exported and consumed, entry doesn't take part in batched exports anymore
+static void LeaveExportPassIfDone(CScriptedBatchEntry &entry)
+{
+   if (entry.steps.size() >= entry.numSteps && entry.results.empty())
+   {
+      entry.joined = false;
+   }
+}
+
+// Whether other is exporting and still waits for step
+static bool NeedsBatchStep(const CScriptedBatchEntry &other, unsigned int step)
+{
+   return (other.joined && other.node && step < other.numSteps && other.steps.find(step) == other.steps.end());
+}
+
+bool RunExport(CScriptedBatchEntry &entry, double renderFrame, unsigned int step, double sampleFrame, bool firstStep, bool update, std::vector<std::string> &attrs)
+{
+   CScriptedTranslator *translator = entry.owner;
+   
+   attrs.clear();
+   
+   if (!translator || !entry.node)
+   {
+      return false;
+   }
+   
+   // IPR updates are never batched nor take results batched during a previous export
+   if (update || !translator->exportBatchFunc)
+   {
+      MString mayaName, masterMayaName;
+      CPyNodeNames names;
+      
+      if (firstStep)
+      {
+         entry.steps.clear();
+         entry.results.clear();
+      }
+      entry.joined = false;
+      
+      GetNodeNames(entry, mayaName, masterMayaName, names);
+      
+      entry.steps.insert(step);
+      
+      return PyCallExport(translator->exportFunc, renderFrame, step, sampleFrame, names, entry.node, attrs);
+   }
+   
+   // Already processed by another translator of the same type during this export
+   std::map<unsigned int, std::vector<std::string> >::iterator rit = entry.results.find(step);
+   if (entry.joined && rit != entry.results.end())
+   {
+      attrs.swap(rit->second);
+      entry.results.erase(rit);
+      LeaveExportPassIfDone(entry);
+      return true;
+   }
+   
+   if (firstStep || !entry.joined)
+   {
+      JoinExportPass(entry);
+   }
+   
+   // Gather all the translators of the same type still waiting for this step, starting with this one
+   std::vector<CScriptedBatchEntry*> batch;
+   
+   batch.push_back(&entry);
+   
+   for (size_t i=0; i<translator->batchEntries.size(); ++i)
+   {
+      CScriptedBatchEntry *other = translator->batchEntries[i];
+      
+      if (other == &entry || !NeedsBatchStep(*other, step))
+      {
+         continue;
+      }
+      
+      batch.push_back(other);
+   }
+   
+   std::vector<MString> mayaNames(2 * batch.size());
+   std::vector<CPyNodeNames> names(batch.size());
+   std::vector<AtNode*> nodes(batch.size());
+   std::vector< std::vector<std::string> > results;
+   std::vector<bool> processed;
+   
+   for (size_t i=0; i<batch.size(); ++i)
+   {
+      GetNodeNames(*(batch[i]), mayaNames[2*i], mayaNames[2*i+1], names[i]);
+      nodes[i] = batch[i]->node;
+   }
+   
+   if (!PyCallExportBatch(translator->exportBatchFunc, renderFrame, step, sampleFrame, names, nodes, results, processed))
+   {
+      entry.steps.insert(step);
+      LeaveExportPassIfDone(entry);
+      return false;
+   }
+   
+   for (size_t i=0; i<batch.size(); ++i)
+   {
+      // Missing or invalid ExportBatch result, fallback to Export
+      if (!processed[i])
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] No ExportBatch result for node \"%s\", call Export.", names[i].mayaName);
+         
+         if (!PyCallExport(translator->exportFunc, renderFrame, step, sampleFrame, names[i], nodes[i], results[i]))
+         {
+            if (i == 0)
+            {
+               entry.steps.insert(step);
+               LeaveExportPassIfDone(entry);
+               return false;
+            }
+            // Left for the node own export to report
+            continue;
+         }
+      }
+      
+      if (i == 0)
+      {
+         attrs.swap(results[0]);
+         entry.steps.insert(step);
+      }
+      else
+      {
+         batch[i]->results[step].swap(results[i]);
+         batch[i]->steps.insert(step);
+      }
+   }
+   
+   LeaveExportPassIfDone(entry);
+   
+   return true;
+}
+
+bool RunExportMotion(CScriptedBatchEntry &entry, double renderFrame, const std::vector<double> &sampleFrames, std::vector<std::string> &attrs)
+{
+   CScriptedTranslator *translator = entry.owner;
+   MString mayaName, masterMayaName;
+   CPyNodeNames names;
+   
+   attrs.clear();
+   
+   if (!translator || !translator->exportMotionFunc || !entry.node)
+   {
+      return false;
+   }
+   
+   // All steps are processed at once, keep batched exports off this entry
+   JoinExportPass(entry);
+   for (unsigned int i=0; i<(unsigned int)sampleFrames.size(); ++i)
+   {
+      entry.steps.insert(i);
+   }
+   entry.joined = false;
+   
+   GetNodeNames(entry, mayaName, masterMayaName, names);
+   
+   return PyCallExportMotion(translator->exportMotionFunc, renderFrame, sampleFrames, names, entry.node, attrs);
+}
+
+bool RunExportInstance(CScriptedTranslator &translator, CScriptedBatchEntry &entry, double renderFrame, unsigned int step, double sampleFrame, std::vector<std::string> &attrs)
+{
+   MString mayaName, masterMayaName;
+   CPyNodeNames names;
+   
+   attrs.clear();
+   
+   if (!translator.exportInstanceFunc || !entry.node)
+   {
+      return false;
+   }
+   
+   GetNodeNames(entry, mayaName, masterMayaName, names);
+   
+   return PyCallExport(translator.exportInstanceFunc, renderFrame, step, sampleFrame, names, entry.node, attrs);
+}
+
+bool RunReplay(CScriptedBatchEntry &entry, unsigned int step, const CReplayKey &key, std::vector<std::string> &attrs)
+{
+   attrs.clear();
+   
+   // Already processed by a batched export started by another translator of the same type
+   if (!entry.owner || !entry.node || (entry.joined && entry.results.find(step) != entry.results.end()))
+   {
+      return false;
+   }
+   
+   if (!ReplayExport(key, entry.node, attrs))
+   {
+      return false;
+   }
+   
+   // Keep batched exports off this entry
+   JoinExportPass(entry);
+   for (unsigned int i=0; i<entry.numSteps; ++i)
+   {
+      entry.steps.insert(i);
+   }
+   entry.joined = false;
+   
+   return true;
+}
+
+void RunCleanup(CScriptedBatchEntry &entry)
+{
+   CScriptedTranslator *translator = entry.owner;
+   
+   if (!translator)
+   {
+      return;
+   }
+   
+   if (!translator->cleanupBatchFunc)
+   {
+      if (translator->cleanupFunc)
+      {
+         MString mayaName, masterMayaName;
+         CPyNodeNames names;
+         
+         GetNodeNames(entry, mayaName, masterMayaName, names);
+         
+         if (!PyCallCleanup(translator->cleanupFunc, names))
+         {
+            AiMsgError("[mtoa.scriptedTranslators] Failed to cleanup node \"%s\".", mayaName.asChar());
+         }
+      }
+      return;
+   }
+   
+   entry.cleanupPending = true;
+   
+   // Wait for all the translators of this type that started exporting to be done
+   for (size_t i=0; i<translator->batchEntries.size(); ++i)
+   {
+      CScriptedBatchEntry *other = translator->batchEntries[i];
+      
+      if (other->cleanupPending)
+      {
+         continue;
+      }
+      
+      if ((other->joined && !other->results.empty()) || (!other->steps.empty() && other->steps.size() < other->numSteps))
+      {
+         return;
       }
-      
-      data.isArray = true;
-      
-      return true;
    }
-   else
+   
+   FlushCleanupBatch(*translator);
+}
+
+void ResetRemovedParameters(CScriptedBatchEntry &entry, const std::vector<std::string> &attrs)
+{
+   std::vector<std::string> current(attrs);
+   
+   std::sort(current.begin(), current.end());
+   current.erase(std::unique(current.begin(), current.end()), current.end());
+   
+   if (entry.node && entry.node == entry.exportedNode)
    {
-      switch (data.type)
+      std::vector<std::string> removed;
+      const AtNodeEntry *nodeEntry = AiNodeGetNodeEntry(entry.node);
+      
+      std::set_difference(entry.exportedAttrs.begin(), entry.exportedAttrs.end(),
+                          current.begin(), current.end(),
+                          std::back_inserter(removed));
+      
+      for (size_t i=0; i<removed.size(); ++i)
       {
-      case AI_TYPE_BOOLEAN:
-         if (sval == "1" || sval == "on" || sval == "true" || sval == "True")
-         {
-            val->BOOL = true;
-            return true;
-         }
-         else if (sval == "0" || sval == "off" || sval == "false" || sval == "False")
-         {
-            val->BOOL = false;
-            return true;
-         }
-         else if (sval != "")
-         {
-            return false;
-         }
-      case AI_TYPE_BYTE:
-         if (sscanf(sval.c_str(), "%c", &(val->BYTE)) != 1)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_INT:
-         if (sscanf(sval.c_str(), "%d", &(val->INT)) != 1)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_UINT:
-         if (sscanf(sval.c_str(), "%u", &(val->UINT)) != 1)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_ENUM:
-         for (unsigned int i=0; i<data.enums.length(); ++i)
-         {
-            if (!strcmp(sval.c_str(), data.enums[i].asChar()))
-            {
-               val->INT = (int) i;
-               return true;
-            }
-         }
-         {
-            unsigned int index = 0;
-            if (sscanf(sval.c_str(), "%u", &index) == 1 && index < data.enums.length())
-            {
-               val->INT = index;
-               return true;
-            }
-         }
-         return false;
-      case AI_TYPE_FLOAT:
-         if (sscanf(sval.c_str(), "%f", &(val->FLT)) != 1)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_POINT2:
-         if (sscanf(sval.c_str(), "%f,%f",
-                    &(val->PNT2.x), &(val->PNT2.y)) != 2)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_POINT:
-         if (sscanf(sval.c_str(), "%f,%f,%f",
-                    &(val->PNT.x), &(val->PNT.y), &(val->PNT.z)) != 3)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_VECTOR:
-         if (sscanf(sval.c_str(), "%f,%f,%f",
-                    &(val->VEC.x), &(val->VEC.y), &(val->VEC.z)) != 3)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_RGB:
-         if (sscanf(sval.c_str(), "%f,%f,%f",
-                    &(val->RGB.r), &(val->RGB.g), &(val->RGB.b)) != 3)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_RGBA:
-         if (sscanf(sval.c_str(), "%f,%f,%f,%f",
-                    &(val->RGBA.r), &(val->RGBA.g), &(val->RGBA.b), &(val->RGBA.a)) != 4)
-         {
-            return false;
-         }
-         return true;
-      case AI_TYPE_MATRIX:
+         const char *param = removed[i].c_str();
+         
+         if (AiNodeEntryLookUpParameter(nodeEntry, param) || AiNodeLookUpUserParameter(entry.node, param))
          {
-            AtMatrix *mat = (AtMatrix*) malloc(sizeof(AtMatrix));
-            if (sscanf(sval.c_str(), "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
-                       &((*mat)[0][0]), &((*mat)[0][1]), &((*mat)[0][2]), &((*mat)[0][3]),
-                       &((*mat)[1][0]), &((*mat)[1][1]), &((*mat)[1][2]), &((*mat)[1][3]),
-                       &((*mat)[2][0]), &((*mat)[2][1]), &((*mat)[2][2]), &((*mat)[2][3]),
-                       &((*mat)[3][0]), &((*mat)[3][1]), &((*mat)[3][2]), &((*mat)[3][3])) != 16)
-            {
-               free(mat);
-               return false;
-            }
-            val->pMTX = mat;
+            AiNodeResetParameter(entry.node, param);
          }
-         return true;
-      case AI_TYPE_STRING:
-         {  
-            char *tmp = new char[sval.length()+1];
-            strcpy(tmp, sval.c_str());
-            val->STR = tmp;
-         }
-         return true;
-      case AI_TYPE_NODE:
-         val->PTR = NULL; 
-         return true;
-      default:
-         return false;
       }
    }
+   
+   entry.exportedAttrs.swap(current);
+   entry.exportedNode = entry.node;
 }
 
-void DestroyValue(CAttrData &data, AtParamValue *val)
+static const char* gSetupAttrsCacheHeader = "mtoaScriptedTranslators setupAttrs 1";
+
+// MtoA and arnold versions followed by the hash of the module source
+static std::string GetModuleKey(const std::string &pymod)
 {
-   if (data.isArray)
+   std::string path;
+   unsigned long long hash = 0;
+   
+   // Module isn't imported
+   if (!PyFindModuleFile(pymod.c_str(), path))
    {
-      AiArrayDestroy(val->ARRAY);
+      return "";
+   }
+   
+   // Prefer source over compiled module
+   size_t n = path.length();
+   if (n > 4 && (path.compare(n-4, 4, ".pyc") == 0 || path.compare(n-4, 4, ".pyo") == 0))
+   {
+      path.erase(n-1);
+   }
+   
+   if (!HashFile(path, hash) && !HashFile(path + "c", hash))
+   {
+      return "";
+   }
+   
+   char buffer[64];
+   sprintf(buffer, "mtoa %d.%d.%d arnold ", MTOA_ARCH_VERSION_NUM, MTOA_MAJOR_VERSION_NUM, MTOA_MINOR_VERSION_NUM);
+   
+   return buffer + std::string(AiGetVersion(NULL, NULL, NULL, NULL)) + " module " + HashToString(hash);
+}
+
+static const char* gManifestCacheHeader = "mtoaScriptedTranslators manifest 1";
+
+static bool IsLazyRegistration()
+{
+   MString lazy = MString("$MTOA_SCRIPTED_TRANSLATORS_LAZY").expandEnvironmentVariablesAndTilde();
+   
+   return (lazy.length() > 0 && lazy != "0" && lazy != "$MTOA_SCRIPTED_TRANSLATORS_LAZY");
+}
+
+static void ReleaseProbe(CPyModuleProbe &probe)
+{
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      PyRelease(probe.funcs[i]);
+      probe.funcs[i] = NULL;
+   }
+}
+
+// Translator takes ownership of the probed functions, isShape is left untouched
+static void ApplyProbe(CScriptedTranslator &translator, CPyModuleProbe &probe)
+{
+   translator.exportFunc = probe.funcs[PYFUNC_EXPORT];
+   translator.cleanupFunc = probe.funcs[PYFUNC_CLEANUP];
+   translator.exportBatchFunc = probe.funcs[PYFUNC_EXPORT_BATCH];
+   translator.exportMotionFunc = probe.funcs[PYFUNC_EXPORT_MOTION];
+   translator.cleanupBatchFunc = probe.funcs[PYFUNC_CLEANUP_BATCH];
+   translator.setupAttrsFunc = probe.funcs[PYFUNC_SETUP_ATTRS];
+   
+   if (translator.isShape)
+   {
+      translator.exportInstanceFunc = probe.funcs[PYFUNC_EXPORT_INSTANCE];
    }
    else
    {
-      switch (data.type)
-      {
-      case AI_TYPE_STRING:
-         delete[] val->STR;
-         break;
-      case AI_TYPE_MATRIX:
-         free(val->pMTX);
-         break;
-      default:
-         break;
-      }
+      PyRelease(probe.funcs[PYFUNC_EXPORT_INSTANCE]);
    }
+   
+   // SetupAE is run as a python command
+   PyRelease(probe.funcs[PYFUNC_SETUP_AE]);
+   
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      probe.funcs[i] = NULL;
+   }
+   
+   translator.supportVolumes = (translator.isShape && probe.caps[PYCAP_SUPPORT_VOLUMES]);
+   translator.supportInstances = (translator.isShape && probe.caps[PYCAP_SUPPORT_INSTANCES]);
+   translator.supportMotionBounds = (translator.isShape && probe.caps[PYCAP_SUPPORT_MOTION_BOUNDS]);
+   translator.prefetchMotionMatrices = (translator.isShape && probe.caps[PYCAP_PREFETCH_MOTION_MATRICES]);
+   translator.supportReplay = probe.caps[PYCAP_SUPPORT_REPLAY];
+   translator.fastInstances = (translator.isShape && (probe.caps[PYCAP_FAST_INSTANCES] || translator.exportInstanceFunc != NULL));
+   
+   translator.loaded = true;
 }
 
-bool HasParameter(const AtNodeEntry *anodeEntry, const char *param, AtNode *anode, const char *decl)
+// One "<name> <0|1>" line per module function and capability
+static void WriteManifestCache(const std::string &nodeType, const CPyModuleProbe &probe, const std::string &key)
 {
-   if (AiNodeEntryLookUpParameter(anodeEntry, param) != NULL)
+   std::vector<std::string> lines;
+   
+   for (int i=0; i<PYFUNC_COUNT; ++i)
    {
-      return true;
+      lines.push_back(std::string(PyGetModuleFuncName((PyModuleFunc) i)) + (probe.funcs[i] ? " 1" : " 0"));
    }
-   else if (anode)
+   for (int i=0; i<PYCAP_COUNT; ++i)
    {
-      if (AiNodeLookUpUserParameter(anode, param) != NULL)
+      lines.push_back(std::string(PyGetModuleCapName((PyModuleCap) i)) + (probe.caps[i] ? " 1" : " 0"));
+   }
+   
+   WriteCacheFile(nodeType + ".manifest.cache", gManifestCacheHeader, key, lines);
+}
+
+static bool ReadManifestCache(CScriptedTranslator &translator, const std::string &key, bool funcs[PYFUNC_COUNT])
+{
+   std::vector<std::string> lines;
+   std::map<std::string, bool> values;
+   
+   if (!ReadCacheFile(translator.nodeType + ".manifest.cache", gManifestCacheHeader, key, lines))
+   {
+      return false;
+   }
+   
+   for (size_t i=0; i<lines.size(); ++i)
+   {
+      size_t p = lines[i].find(' ');
+      if (p != std::string::npos)
       {
-         return true;
+         values[lines[i].substr(0, p)] = (lines[i].substr(p+1) == "1");
       }
-      else if (decl != NULL)
+   }
+   
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      std::map<std::string, bool>::iterator it = values.find(PyGetModuleFuncName((PyModuleFunc) i));
+      if (it == values.end())
       {
-         return AiNodeDeclare(anode, param, decl);
+         return false;
       }
-      else
+      funcs[i] = it->second;
+   }
+   
+   bool caps[PYCAP_COUNT];
+   
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      std::map<std::string, bool>::iterator it = values.find(PyGetModuleCapName((PyModuleCap) i));
+      if (it == values.end())
       {
          return false;
       }
+      caps[i] = it->second;
    }
-   else
+   
+   translator.isShape = caps[PYCAP_IS_SHAPE];
+   translator.supportVolumes = (translator.isShape && caps[PYCAP_SUPPORT_VOLUMES]);
+   translator.supportInstances = (translator.isShape && caps[PYCAP_SUPPORT_INSTANCES]);
+   translator.supportMotionBounds = (translator.isShape && caps[PYCAP_SUPPORT_MOTION_BOUNDS]);
+   translator.prefetchMotionMatrices = (translator.isShape && caps[PYCAP_PREFETCH_MOTION_MATRICES]);
+   translator.supportReplay = caps[PYCAP_SUPPORT_REPLAY];
+   translator.fastInstances = (translator.isShape && (caps[PYCAP_FAST_INSTANCES] || funcs[PYFUNC_EXPORT_INSTANCE]));
+   
+   return funcs[PYFUNC_EXPORT];
+}
+
+bool LoadTranslator(CScriptedTranslator &translator)
+{
+   if (translator.loaded)
+   {
+      return true;
+   }
+   
+   std::string pymod = "mtoa_" + translator.nodeType;
+   CPyModuleProbe probe;
+   
+   if (!PyProbeModule(pymod.c_str(), probe) || !probe.funcs[PYFUNC_EXPORT])
    {
+      AiMsgError("[mtoa.scriptedTranslators] Could not load translator module \"%s\".", pymod.c_str());
+      ReleaseProbe(probe);
       return false;
    }
+   
+   // Translator class was chosen from the cached manifest
+   if (probe.caps[PYCAP_IS_SHAPE] != translator.isShape)
+   {
+      AiMsgWarning("[mtoa.scriptedTranslators] %s.IsShape changed since registration, ignored until next session.", pymod.c_str());
+   }
+   
+   ApplyProbe(translator, probe);
+   
+   return true;
 }
 
 void NodeInitializer(CAbTranslator context)
 {
-   std::map<std::string, CScriptedTranslator>::iterator it = gTranslators.find(context.maya.asChar());
+   CScriptedTranslator *translator = FindTranslator(context.maya.asChar());
    
-   if (it != gTranslators.end())
+   if (translator)
    {
-      MObject plugin = MFnPlugin::findPlugin(it->second.requiredPlugin);
+      MObject plugin = MFnPlugin::findPlugin(translator->requiredPlugin);
       if (plugin.isNull())
       {
          AiMsgWarning("[mtoa.scriptedTranslators] %s requires Maya plugin %s, registering will be deferred until plugin is loaded",
-                      it->first.c_str(), it->second.requiredPlugin.asChar());
+                      translator->nodeType.c_str(), translator->requiredPlugin.asChar());
+         std::vector<std::string> &pending = gPendingTranslators[translator->requiredPlugin.asChar()];
+         if (std::find(pending.begin(), pending.end(), translator->nodeType) == pending.end())
+         {
+            pending.push_back(translator->nodeType);
+         }
          AddPluginLoadedCallback();
-         it->second.deferred = true;
+         translator->deferred = true;
          return;
       }
       
-      CExtensionAttrHelper procHelper(context.maya, "procedural");
+      // Arnold node entries are described from the cache when no universe is active
+      BeginNodeEntryQueries();
+      
+      CNodeEntryAttrHelper procHelper(context.maya, "procedural");
       
-      if (it->second.isShape)
+      if (translator->isShape)
       {
          CScriptedShapeTranslator::MakeCommonAttributes(procHelper);
       }
       
-      MString setupAttrsCmd = it->second.setupAttrsCmd + "()";
-      
-      if (setupAttrsCmd.length() > 0)
+      if (translator->setupAttrsFunc || translator->setupAttrsKey.length() > 0)
       {
-         MStringArray rv;
-         MStatus stat = MGlobal::executePythonCommand(setupAttrsCmd, rv);
+         std::vector<std::string> lines;
+         std::vector<CPyAttrRecord> records;
+         std::string cacheFile = translator->nodeType + ".setupAttrs.cache";
+         
+         // SetupAttrs results only change with the module, MtoA or arnold
+         bool cached = (translator->setupAttrsKey.length() > 0 &&
+                        ReadCacheFile(cacheFile, gSetupAttrsCacheHeader, translator->setupAttrsKey, lines));
+         
+         bool called = (!cached && LoadTranslator(*translator) && translator->setupAttrsFunc &&
+                        PyCallAttrRecords(translator->setupAttrsFunc, records));
+         
+         bool cacheable = (called && translator->setupAttrsKey.length() > 0);
+         
+         // One helper per arnold node, so that each node entry is only looked up once
+         std::map<std::string, CNodeEntryAttrHelper*> helpers;
+         std::string line;
+         
+         helpers["procedural"] = &procHelper;
+         
+         // Cache lines are written back from the records
+         if (!cached)
+         {
+            lines.clear();
+         }
+         
+         size_t count = (cached ? lines.size() : records.size());
          
-         if (stat == MStatus::kSuccess && rv.length() > 1)
+         for (size_t i=0; i<count; ++i)
          {
-            for (unsigned int i=0; i<rv.length(); ++i)
+            CAttrData data;
+            CAttrDeclaration decl;
+            bool hasDefault = false;
+            bool hasValues = false;
+            
+            if (cached || records[i].decl.length() > 0)
             {
-               CAttrData data;
-               std::string arnoldNode, arnoldAttr;
-               
-               std::string decl = rv[i].asChar();
-               size_t p0 = 0, p1;
-               
-               // attribute type
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               if (sscanf(decl.substr(p0, p1-p0).c_str(), "%d", &data.type) != 1) continue;
-               
-               // arnold node name
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               arnoldNode = decl.substr(p0, p1-p0);
-               if (arnoldNode.length() == 0) arnoldNode = "procedural";
-               
-               // arnold attr name
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               arnoldAttr = decl.substr(p0, p1-p0);
-               
-               // name
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               data.name = decl.substr(p0, p1-p0).c_str();
-               
-               // shortName
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               data.shortName = decl.substr(p0, p1-p0).c_str();
-               
-               // isArray
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               data.isArray = (decl.substr(p0, p1-p0) == "1");
-               
-               // default
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               std::string sdefval = decl.substr(p0, p1-p0);
-               
-               // min
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               std::string sminval = decl.substr(p0, p1-p0);
-               
-               // max
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               std::string smaxval = decl.substr(p0, p1-p0);
-               
-               // softMin
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               std::string ssoftminval = decl.substr(p0, p1-p0);
-               
-               // softMax
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               std::string ssoftmaxval = decl.substr(p0, p1-p0);
-               
-               // keyable
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 == std::string::npos) continue;
-               data.keyable = (decl.substr(p0, p1-p0) == "1");
+               line = (cached ? lines[i] : records[i].decl);
                
-               // enums
-               p0 = p1 + 1;
-               p1 = decl.find('|', p0);
-               if (p1 != std::string::npos) continue;
-               std::string senumvals = decl.substr(p0);
-               size_t p2 = 0, p3 = senumvals.find(',', p2);
-               while (p3 != std::string::npos)
+               if (!ParseAttrDeclaration(line, data, decl))
                {
-                  data.enums.append(senumvals.substr(p2, p3-p2).c_str());
-                  p2 = p3 + 1;
-                  p3 = senumvals.find(',', p2);
+                  continue;
                }
-               data.enums.append(senumvals.substr(p2).c_str());
-
-               CExtensionAttrHelper helper(context.maya, arnoldNode.c_str());
-
+               
                // if arnold name is set, ignore any other value
-               if (arnoldAttr.length() > 0)
+               if (decl.arnoldAttr.length() == 0 && data.type != AI_TYPE_UNDEFINED)
                {
-                  helper.MakeInput(arnoldAttr.c_str());
+                  hasDefault = ReadAttrValues(decl, data);
+                  hasValues = true;
                }
-               else if (data.type != AI_TYPE_UNDEFINED)
-               {
-                  // read values
-                  bool hasDefault = StringToValue(sdefval, data, &(data.defaultValue));
-                  data.hasMin = false;
-                  data.hasMax = false;
-                  data.hasSoftMin = false;
-                  data.hasSoftMax = false;
-                  
-                  if (data.type == AI_TYPE_BYTE ||
-                      data.type == AI_TYPE_INT ||
-                      data.type == AI_TYPE_UINT ||
-                      data.type == AI_TYPE_FLOAT)
-                  {
-                     data.hasMin = StringToValue(sminval, data, &(data.min));
-                     data.hasMax = StringToValue(smaxval, data, &(data.max));
-                     data.hasSoftMin = StringToValue(ssoftminval, data, &(data.softMin));
-                     data.hasSoftMax = StringToValue(ssoftmaxval, data, &(data.softMax));
-                  }
-                  
-                  // create attributes
-                  helper.MakeInput(data);
                
-                  // cleanup values
-                  if (hasDefault) DestroyValue(data, &(data.defaultValue));
-                  if (data.hasMin) DestroyValue(data, &(data.min));
-                  if (data.hasMax) DestroyValue(data, &(data.max));
-                  if (data.hasSoftMin) DestroyValue(data, &(data.softMin));
-                  if (data.hasSoftMax) DestroyValue(data, &(data.softMax));
-               }
+               cacheable = (cacheable && line.find('\n') == std::string::npos);
+            }
+            else
+            {
+               hasDefault = ReadAttrRecord(records[i], data, decl);
+               hasValues = true;
+               
+               // Values that can't be represented in a declaration string prevent caching
+               cacheable = (cacheable && FormatAttrDeclaration(data, decl.arnoldNode, decl.arnoldAttr, hasDefault, line));
+            }
+            
+            if (cacheable)
+            {
+               lines.push_back(line);
+            }
+            
+            CNodeEntryAttrHelper *&helper = helpers[decl.arnoldNode];
+            
+            if (!helper)
+            {
+               helper = new CNodeEntryAttrHelper(context.maya, decl.arnoldNode.c_str());
+            }
+            
+            if (decl.arnoldAttr.length() > 0)
+            {
+               helper->MakeInput(decl.arnoldAttr.c_str());
+            }
+            else if (data.type != AI_TYPE_UNDEFINED)
+            {
+               helper->MakeInput(data);
+            }
+            
+            if (hasValues)
+            {
+               ReleaseAttrValues(data, hasDefault);
+            }
+         }
+         
+         for (std::map<std::string, CNodeEntryAttrHelper*>::iterator it=helpers.begin(); it!=helpers.end(); ++it)
+         {
+            if (it->second != &procHelper)
+            {
+               delete it->second;
             }
          }
+         
+         PyReleaseAttrRecords(records);
+         
+         if (cacheable)
+         {
+            WriteCacheFile(cacheFile, gSetupAttrsCacheHeader, translator->setupAttrsKey, lines);
+         }
       }
       
-      it->second.attrsAdded = true;
+      translator->attrsAdded = true;
       
-      if (it->second.deferred)
+      // Attributes changed, resolve them again on next export
+      translator->plugs.reset();
+      
+      EndNodeEntryQueries();
+      
+      if (translator->deferred)
       {
          // Was deferred, so that SetupAE should not have been called yet
-         if (it->second.setupAECmd.length() > 0)
+         if (translator->setupAECmd.length() > 0)
          {
-            MGlobal::executePythonCommand(it->second.setupAECmd + "(\"scriptedTranslators\")");
+            MGlobal::executePythonCommand(translator->setupAECmd + "(\"scriptedTranslators\")");
          }
-         it->second.deferred = false;
+         translator->deferred = false;
       }
    }
 }
@@ -670,115 +1777,93 @@ bool RegisterTranslator(CExtension& plugin, std::string &nodeType, const std::st
       if (nodeType.length() > 0)
       {
          // Check if nodeType already registered
-         std::map<std::string, CScriptedTranslator>::iterator it = gTranslators.find(nodeType);
+         std::vector<CScriptedTranslator*>::iterator it = std::lower_bound(gTranslators.begin(), gTranslators.end(), nodeType, CNodeTypeLess());
          
-         if (it == gTranslators.end())
+         if (it == gTranslators.end() || (*it)->nodeType != nodeType)
          {
-            // Check if Export function can be found
             std::string pymod = "mtoa_" + nodeType;
+            bool diskCache = (GetCacheDirectory().length() > 0);
+            std::string moduleKey = ((diskCache || IsReplayEnabled()) ? GetModuleKey(pymod) : "");
+            bool funcs[PYFUNC_COUNT];
             
-            if (MGlobal::executePythonCommand(MString("import ") + pymod.c_str()) != MS::kSuccess)
-            {
-               return false;
-            }
+            CScriptedTranslator translator;
             
-            std::string exportScript = pymod + ".Export";
+            translator.nodeType = nodeType;
+            translator.requiredPlugin = providedByPlugin.c_str();
             
-            int rv = 0;
-            MString checkCmdBeg = MString("hasattr(") + pymod.c_str() + ", \"";
-            MString checkCmdEnd = "\")";
+            translator.moduleKey = moduleKey;
             
-            if (MGlobal::executePythonCommand(checkCmdBeg + "Export" + checkCmdEnd, rv) == MS::kSuccess && rv != 0)
+            if (IsLazyRegistration() && diskCache && moduleKey.length() > 0 && ReadManifestCache(translator, moduleKey, funcs))
+            {
+               // Module is imported when the first node of that type gets exported
+               MGlobal::displayInfo(MString("[mtoa.scriptedTranslators] Defer import of module \"") + pymod.c_str() + "\"");
+            }
+            else
             {
-               gTranslators[nodeType].exportCmd = exportScript.c_str();
-               gTranslators[nodeType].attrsAdded = false;
-               gTranslators[nodeType].deferred = false;
-               gTranslators[nodeType].isShape = true;
-               gTranslators[nodeType].supportVolumes = false;
-               gTranslators[nodeType].supportInstances = false;
-               gTranslators[nodeType].requiredPlugin = providedByPlugin.c_str();
+               // Check if Export function can be found
+               CPyModuleProbe probe;
                
-               std::string isShapeScript = pymod + ".IsShape";
-               if (MGlobal::executePythonCommand(checkCmdBeg + "IsShape" + checkCmdEnd, rv) == MS::kSuccess && rv != 0)
+               if (!PyProbeModule(pymod.c_str(), probe) || !probe.funcs[PYFUNC_EXPORT])
                {
-                  int result = 0;
-                  MGlobal::executePythonCommand(MString(isShapeScript.c_str()) + "()", result);
-                  gTranslators[nodeType].isShape = (result != 0);
+                  ReleaseProbe(probe);
+                  return false;
                }
                
-               if (gTranslators[nodeType].isShape)
+               for (int i=0; i<PYFUNC_COUNT; ++i)
                {
-                  std::string volumeScript = pymod + ".SupportVolumes";
-                  if (MGlobal::executePythonCommand(checkCmdBeg + "SupportVolumes" + checkCmdEnd, rv) == MS::kSuccess && rv != 0)
-                  {
-                     int result = 0;
-                     MGlobal::executePythonCommand(MString(volumeScript.c_str()) + "()", result);
-                     gTranslators[nodeType].supportVolumes = (result != 0);
-                  }
-                  else
-                  {
-                     gTranslators[nodeType].supportVolumes = false;
-                  }
-                  
-                  std::string instanceScript = pymod + ".SupportInstances";
-                  if (MGlobal::executePythonCommand(checkCmdBeg + "SupportInstances" + checkCmdEnd, rv) == MS::kSuccess && rv != 0)
-                  {
-                     int result = 0;
-                     MGlobal::executePythonCommand(MString(instanceScript.c_str()) + "()", result);
-                     gTranslators[nodeType].supportInstances = (result != 0);
-                  }
-                  else
-                  {
-                     gTranslators[nodeType].supportInstances = false;
-                  }
+                  funcs[i] = (probe.funcs[i] != NULL);
                }
                
-               std::string cleanupScript = pymod + ".Cleanup";
-               if (MGlobal::executePythonCommand(checkCmdBeg + "Cleanup" + checkCmdEnd, rv) != MS::kSuccess || rv == 0)
+               if (diskCache && moduleKey.length() > 0)
                {
-                  cleanupScript = "";
+                  WriteManifestCache(nodeType, probe, moduleKey);
                }
-               gTranslators[nodeType].cleanupCmd = cleanupScript.c_str();
                
-               std::string attrScript = pymod + ".SetupAttrs";
-               if (MGlobal::executePythonCommand(checkCmdBeg + "SetupAttrs" + checkCmdEnd, rv) != MS::kSuccess || rv == 0)
-               {
-                  attrScript = "";
-               }
-               gTranslators[nodeType].setupAttrsCmd = attrScript.c_str();
+               translator.isShape = probe.caps[PYCAP_IS_SHAPE];
                
-               std::string aeScript = pymod + ".SetupAE";
-               if (MGlobal::executePythonCommand(checkCmdBeg + "SetupAE" + checkCmdEnd, rv) != MS::kSuccess || rv == 0)
-               {
-                  std::string tempPy = "def mtoa_" + nodeType + "_SetupAE(translator):\n";
-                  tempPy += "  import scriptedTranslatorUtils\n";
-                  tempPy += "  scriptedTranslatorUtils.DefaultSetupAE('" + providedByPlugin + "', '" + nodeType + "', translator, asShape=";
-                  tempPy += (gTranslators[nodeType].isShape ? "True)" : "False)");
-                  
-                  if (MGlobal::executePythonCommand(tempPy.c_str()) != MS::kSuccess)
-                  {
-                     MGlobal::displayInfo("[mtoa.scriptedTranslators] Could not generate default AE template for node " + MString(nodeType.c_str()));
-                     aeScript = "";
-                  }
-                  else
-                  {
-                     aeScript = "mtoa_" + nodeType + "_SetupAE";
-                  }
-               }
-               gTranslators[nodeType].setupAECmd = aeScript.c_str();
+               ApplyProbe(translator, probe);
+            }
+            
+            if (funcs[PYFUNC_SETUP_ATTRS] && diskCache)
+            {
+               translator.setupAttrsKey = moduleKey;
+            }
+            
+            std::string aeScript = "__import__(\"" + pymod + "\").SetupAE";
+            if (!funcs[PYFUNC_SETUP_AE])
+            {
+               std::string tempPy = "def mtoa_" + nodeType + "_SetupAE(translator):\n";
+               tempPy += "  import scriptedTranslatorUtils\n";
+               tempPy += "  scriptedTranslatorUtils.DefaultSetupAE('" + providedByPlugin + "', '" + nodeType + "', translator, asShape=";
+               tempPy += (translator.isShape ? "True)" : "False)");
                
-               if (gTranslators[nodeType].isShape)
+               if (MGlobal::executePythonCommand(tempPy.c_str()) != MS::kSuccess)
                {
-                  MGlobal::displayInfo(MString("[mtoa.scriptedTranslators] Register \"") + nodeType.c_str() + "\" as shape");
-                  plugin.RegisterTranslator(nodeType.c_str(), "scriptedTranslators", CScriptedShapeTranslator::creator, NodeInitializer);
+                  MGlobal::displayInfo("[mtoa.scriptedTranslators] Could not generate default AE template for node " + MString(nodeType.c_str()));
+                  aeScript = "";
                }
                else
                {
-                  MGlobal::displayInfo(MString("[mtoa.scriptedTranslators] Register \"") + nodeType.c_str() + "\" as node");
-                  plugin.RegisterTranslator(nodeType.c_str(), "scriptedTranslators", CScriptedNodeTranslator::creator, NodeInitializer);
+                  aeScript = "mtoa_" + nodeType + "_SetupAE";
                }
-               return true;
             }
+            translator.setupAECmd = aeScript.c_str();
+            
+            // Register before MtoA gets a chance to call NodeInitializer
+            //   the heap allocated copy takes over the python references, its address never changes
+            gTranslators.insert(it, new CScriptedTranslator(translator));
+            
+            if (translator.isShape)
+            {
+               MGlobal::displayInfo(MString("[mtoa.scriptedTranslators] Register \"") + nodeType.c_str() + "\" as shape");
+               plugin.RegisterTranslator(nodeType.c_str(), "scriptedTranslators", CScriptedShapeTranslator::creator, NodeInitializer);
+            }
+            else
+            {
+               MGlobal::displayInfo(MString("[mtoa.scriptedTranslators] Register \"") + nodeType.c_str() + "\" as node");
+               plugin.RegisterTranslator(nodeType.c_str(), "scriptedTranslators", CScriptedNodeTranslator::creator, NodeInitializer);
+            }
+            return true;
          }
       }
    }
@@ -786,6 +1871,27 @@ bool RegisterTranslator(CExtension& plugin, std::string &nodeType, const std::st
    return false;
 }
 
+void ReleaseTranslators()
+{
+   std::vector<CScriptedTranslator*>::iterator it = gTranslators.begin();
+   while (it != gTranslators.end())
+   {
+      CScriptedTranslator *translator = *it;
+      
+      PyRelease(translator->exportFunc);
+      PyRelease(translator->cleanupFunc);
+      PyRelease(translator->exportBatchFunc);
+      PyRelease(translator->exportInstanceFunc);
+      PyRelease(translator->exportMotionFunc);
+      PyRelease(translator->cleanupBatchFunc);
+      PyRelease(translator->setupAttrsFunc);
+      delete translator;
+      ++it;
+   }
+   gTranslators.clear();
+   gPendingTranslators.clear();
+}
+
 
 
 extern "C"
@@ -794,11 +1900,17 @@ extern "C"
 DLLEXPORT void initializeExtension(CExtension &extension)
 {
    RegisterTranslators(extension);
+   RegisterStatsCommand();
 }
 
 DLLEXPORT void deinitializeExtension(CExtension &)
 {
    RemovePluginLoadedCallback();
+   RemoveShadingEngineCacheCallbacks();
+   DeregisterStatsCommand();
+   ClearNodeEntryCache();
+   ClearReplayCache();
+   ReleaseTranslators();
 }
 
 }
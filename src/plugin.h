@@ -4,32 +4,91 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include "common.h"
+#include "pyutils.h"
+#include "plugs.h"
 #include "extension/Extension.h"
+#include <maya/MDagPath.h>
+
+struct CScriptedTranslator;
+struct CReplayKey;
+
+// Per translator instance export state, shared with the other translators of the same type
+//   so that a single ExportBatch/CleanupBatch call can process all of them
+struct CScriptedBatchEntry
+{
+   CScriptedTranslator *owner;
+   MObject object;
+   MDagPath dagPath;
+   MDagPath masterDagPath;
+   AtNode *node;
+   AtNode *masterNode;
+   unsigned int numSteps;
+   // Steps exported (or batched) and results waiting to be consumed by the current export
+   std::set<unsigned int> steps;
+   std::map<unsigned int, std::vector<std::string> > results;
+   // Export started (or arnold node created) and not all steps consumed yet: only joined entries are batched
+   bool joined;
+   bool cleanupPending;
+   // Sorted parameters set by the last export of exportedNode
+   std::vector<std::string> exportedAttrs;
+   AtNode *exportedNode;
+   
+   CScriptedBatchEntry();
+};
 
 struct CScriptedTranslator
 {
-   MString exportCmd;
-   MString cleanupCmd;
+   std::string nodeType;
+   PyObject *exportFunc;
+   PyObject *cleanupFunc;
+   PyObject *exportBatchFunc;
+   PyObject *exportInstanceFunc;
+   PyObject *exportMotionFunc;
+   PyObject *cleanupBatchFunc;
+   PyObject *setupAttrsFunc;
+   // SetupAttrs cache key, empty if not cached
+   std::string setupAttrsKey;
+   // Module source and versions key, empty if neither disk caching nor replay are enabled
+   std::string moduleKey;
    MString setupAECmd;
-   MString setupAttrsCmd;
    MString requiredPlugin;
+   CPlugPlan plugs;
    bool isShape;
    bool supportInstances;
    bool supportVolumes;
+   bool supportMotionBounds;
+   bool prefetchMotionMatrices;
+   // Export results only depend on the node inputs and may be replayed on other frames
+   bool supportReplay;
+   // ginstance secondary instances skip Export (and Cleanup), only ExportInstance is called if defined
+   bool fastInstances;
    bool attrsAdded;
    bool deferred;
+   // Module functions looked up, only delayed on lazy registration
+   bool loaded;
+   std::vector<CScriptedBatchEntry*> batchEntries;
+   
+   CScriptedTranslator();
 };
 
 
-extern std::map<std::string, CScriptedTranslator> gTranslators;
+// Registered translators, sorted by node type
+// Heap allocated so that batch entries and translator instances may keep pointers to them across registrations
+extern std::vector<CScriptedTranslator*> gTranslators;
 extern MCallbackId gPluginLoadedCallbackId;
 
 
+CScriptedTranslator* FindTranslator(const char *nodeType);
+
 void NodeInitializer(CAbTranslator context);
 
 void RegisterTranslators(CExtension& plugin);
 bool RegisterTranslator(CExtension& plugin, std::string &nodeType, const std::string &providedByPlugin="");
+void ReleaseTranslators();
+// Import the translator module if registration was lazy
+bool LoadTranslator(CScriptedTranslator &translator);
 
 void MayaPluginLoadedCallback(const MStringArray &strs, void *clientData);
 MCallbackId AddPluginLoadedCallback();
@@ -38,8 +97,38 @@ MStatus RemovePluginLoadedCallback();
 float GetSampleFrame(CArnoldSession *session, unsigned int step);
 
 bool StringToValue(const std::string &sval, CAttrData &data, AtParamValue *val);
+bool ValueToString(const CAttrData &data, const AtParamValue *val, std::string &sval);
 void DestroyValue(CAttrData &data, AtParamValue *val);
 
-bool HasParameter(const AtNodeEntry *anodeEntry, const char *param, AtNode *anode=NULL, const char *decl=NULL);
+// Attribute declaration fields, as generated by scriptedTranslatorUtils.AttrData:
+//   type|arnoldNode|arnoldAttr|name|shortName|isArray|default|min|max|softMin|softMax|keyable|enums
+struct CAttrDeclaration
+{
+   std::string arnoldNode;
+   std::string arnoldAttr;
+   std::string defaultValue;
+   std::string min;
+   std::string max;
+   std::string softMin;
+   std::string softMax;
+};
+
+bool ParseAttrDeclaration(const std::string &decl, CAttrData &data, CAttrDeclaration &fields);
+bool FormatAttrDeclaration(const CAttrData &data, const std::string &arnoldNode, const std::string &arnoldAttr, bool hasDefault, std::string &decl);
+// Returns whether or not a default value was read, min/max values are only read for numeric types
+bool ReadAttrValues(const CAttrDeclaration &fields, CAttrData &data);
+void ReleaseAttrValues(CAttrData &data, bool hasDefault);
+
+void AddBatchEntry(CScriptedTranslator &translator, CScriptedBatchEntry *entry);
+void RemoveBatchEntry(CScriptedBatchEntry *entry);
+bool RunExport(CScriptedBatchEntry &entry, double renderFrame, unsigned int step, double sampleFrame, bool firstStep, bool update, std::vector<std::string> &attrs);
+void RunCleanup(CScriptedBatchEntry &entry);
+// Reset the parameters a previous export of the same arnold node has set but attrs doesn't hold (user parameters are removed)
+void ResetRemovedParameters(CScriptedBatchEntry &entry, const std::vector<std::string> &attrs);
+bool RunExportMotion(CScriptedBatchEntry &entry, double renderFrame, const std::vector<double> &sampleFrames, std::vector<std::string> &attrs);
+bool RunExportInstance(CScriptedTranslator &translator, CScriptedBatchEntry &entry, double renderFrame, unsigned int step, double sampleFrame, std::vector<std::string> &attrs);
+// Sets the parameters recorded by a previous frame export instead of calling python, covers all motion steps
+//   step is the first step exported
+bool RunReplay(CScriptedBatchEntry &entry, unsigned int step, const CReplayKey &key, std::vector<std::string> &attrs);
 
 #endif
@@ -0,0 +1,152 @@
+#include "plugs.h"
+#include <maya/MNodeClass.h>
+#include <maya/MFnDependencyNode.h>
+
+struct CPlugNames
+{
+   const char *name;
+   const char *altName;
+};
+
+static const CPlugNames gPlugNames[PLUG_COUNT] =
+{
+   {"subdiv_type", "aiSubdivType"},
+   {"subdiv_iterations", "aiSubdivIterations"},
+   {"subdiv_adaptive_metric", "aiSubdivAdaptiveMetric"},
+   {"subdiv_pixel_error", "aiSubdivPixelError"},
+   {"subdiv_dicing_camera", "aiSubdivDicingCamera"},
+   {"subdiv_uv_smoothing", "aiSubdivUvSmoothing"},
+   {"aiSubdivSmoothDerivs", NULL},
+   {"smoothShading", NULL},
+   {"aiDispHeight", NULL},
+   {"aiDispZeroValue", NULL},
+   {"aiDispAutobump", NULL},
+   {"aiDispPadding", NULL},
+   {"sss_sample_distribution", "aiSssSampleDistribution"},
+   {"sss_sample_spacing", "aiSssSampleSpacing"},
+   {"aiMinPixelWidth", NULL},
+   {"aiMode", NULL},
+   {"aiBasis", NULL},
+   {"step_size", "aiStepSize"},
+   {"aiStepSize", NULL},
+   {"doubleSided", NULL},
+   {"opposite", NULL},
+   {"receiveShadows", NULL},
+   {"self_shadows", "aiSelfShadows"},
+   {"opaque", "aiOpaque"},
+   {"matte", "aiMatte"},
+   {"castsShadows", NULL},
+   {"primaryVisibility", NULL},
+   {"visibleInReflections", NULL},
+   {"visibleInRefractions", NULL},
+   {"diffuse_visibility", "aiVisibleInDiffuse"},
+   {"glossy_visibility", "aiVisibleInGlossy"},
+   {"aiSssSetname", NULL},
+   {"aiTraceSets", NULL},
+   {"worldMatrix", NULL}
+};
+
+CPlugPlan::CPlugPlan()
+   : m_built(false)
+{
+}
+
+void CPlugPlan::reset()
+{
+   m_built = false;
+   for (int i=0; i<PLUG_COUNT; ++i)
+   {
+      m_attributes[i] = MObject::kNullObj;
+   }
+}
+
+void CPlugPlan::build(const MString &nodeType)
+{
+   MNodeClass nodeClass(nodeType);
+   MStatus status;
+   
+   reset();
+   
+   for (int i=0; i<PLUG_COUNT; ++i)
+   {
+      MObject attr = nodeClass.attribute(gPlugNames[i].name, &status);
+      
+      if ((status != MS::kSuccess || attr.isNull()) && gPlugNames[i].altName)
+      {
+         attr = nodeClass.attribute(gPlugNames[i].altName, &status);
+      }
+      
+      if (status == MS::kSuccess && !attr.isNull())
+      {
+         m_attributes[i] = attr;
+      }
+   }
+   
+   m_built = true;
+}
+
+MObject CPlugPlan::findAttribute(const MObject &node, PlugId id)
+{
+   MFnDependencyNode fnNode(node);
+   MStatus status;
+   
+   MObject attr = fnNode.attribute(gPlugNames[id].name, &status);
+   
+   if ((status != MS::kSuccess || attr.isNull()) && gPlugNames[id].altName)
+   {
+      attr = fnNode.attribute(gPlugNames[id].altName, &status);
+   }
+   
+   return (status == MS::kSuccess ? attr : MObject::kNullObj);
+}
+
+CNodePlugs::CNodePlugs()
+   : m_plan(0), m_attributeCount(0)
+{
+   for (int i=0; i<PLUG_COUNT; ++i)
+   {
+      m_searched[i] = false;
+   }
+}
+
+void CNodePlugs::prepare(const CPlugPlan &plan, const MObject &node)
+{
+   unsigned int attributeCount = MFnDependencyNode(node).attributeCount();
+   
+   // Dynamic attributes added or removed since the last lookups
+   if (m_plan != &plan || m_node != node || m_attributeCount != attributeCount)
+   {
+      for (int i=0; i<PLUG_COUNT; ++i)
+      {
+         m_searched[i] = false;
+         m_attributes[i] = MObject::kNullObj;
+      }
+   }
+   
+   m_plan = &plan;
+   m_node = node;
+   m_attributeCount = attributeCount;
+}
+
+MPlug CNodePlugs::plug(PlugId id)
+{
+   if (!m_plan)
+   {
+      return MPlug();
+   }
+   
+   const MObject &attr = m_plan->attribute(id);
+   
+   if (!attr.isNull())
+   {
+      return MPlug(m_node, attr);
+   }
+   
+   if (!m_searched[id])
+   {
+      m_attributes[id] = CPlugPlan::findAttribute(m_node, id);
+      m_searched[id] = true;
+   }
+   
+   return (m_attributes[id].isNull() ? MPlug() : MPlug(m_node, m_attributes[id]));
+}
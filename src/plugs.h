@@ -0,0 +1,95 @@
+#ifndef __plugs_h__
+#define __plugs_h__
+
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+
+// Maya attributes read by the extension when exporting scripted shapes
+enum PlugId
+{
+   PLUG_SUBDIV_TYPE = 0,
+   PLUG_SUBDIV_ITERATIONS,
+   PLUG_SUBDIV_ADAPTIVE_METRIC,
+   PLUG_SUBDIV_PIXEL_ERROR,
+   PLUG_SUBDIV_DICING_CAMERA,
+   PLUG_SUBDIV_UV_SMOOTHING,
+   PLUG_SUBDIV_SMOOTH_DERIVS,
+   PLUG_SMOOTH_SHADING,
+   PLUG_DISP_HEIGHT,
+   PLUG_DISP_ZERO_VALUE,
+   PLUG_DISP_AUTOBUMP,
+   PLUG_DISP_PADDING,
+   PLUG_SSS_SAMPLE_DISTRIBUTION,
+   PLUG_SSS_SAMPLE_SPACING,
+   PLUG_MIN_PIXEL_WIDTH,
+   PLUG_MODE,
+   PLUG_BASIS,
+   PLUG_STEP_SIZE,
+   PLUG_VOLUME_STEP_SIZE,
+   PLUG_DOUBLE_SIDED,
+   PLUG_OPPOSITE,
+   PLUG_RECEIVE_SHADOWS,
+   PLUG_SELF_SHADOWS,
+   PLUG_OPAQUE,
+   PLUG_MATTE,
+   PLUG_CASTS_SHADOWS,
+   PLUG_PRIMARY_VISIBILITY,
+   PLUG_VISIBLE_IN_REFLECTIONS,
+   PLUG_VISIBLE_IN_REFRACTIONS,
+   PLUG_DIFFUSE_VISIBILITY,
+   PLUG_GLOSSY_VISIBILITY,
+   PLUG_SSS_SETNAME,
+   PLUG_TRACE_SETS,
+   PLUG_WORLD_MATRIX,
+   PLUG_COUNT
+};
+
+// Attributes resolved once per maya node type
+// For each plug, the attribute name is looked up first then the alternate 'ai' prefixed one, if any
+class CPlugPlan
+{
+public:
+   
+   CPlugPlan();
+   
+   void reset();
+   void build(const MString &nodeType);
+   
+   inline bool isBuilt() const { return m_built; }
+   
+   // Null if the node class doesn't have the attribute
+   inline const MObject& attribute(PlugId id) const { return m_attributes[id]; }
+   
+   // Searches node attributes by name, for the dynamic attributes the node class doesn't know about
+   static MObject findAttribute(const MObject &node, PlugId id);
+
+private:
+   
+   bool m_built;
+   MObject m_attributes[PLUG_COUNT];
+};
+
+// Attributes of a single node: the plan ones, then for each attribute missing from the plan
+//   a name based lookup done once and kept until the node attribute count changes
+class CNodePlugs
+{
+public:
+   
+   CNodePlugs();
+   
+   void prepare(const CPlugPlan &plan, const MObject &node);
+   
+   // Returns a null plug if the attribute doesn't exist
+   MPlug plug(PlugId id);
+
+private:
+   
+   const CPlugPlan *m_plan;
+   MObject m_node;
+   unsigned int m_attributeCount;
+   bool m_searched[PLUG_COUNT];
+   MObject m_attributes[PLUG_COUNT];
+};
+
+#endif
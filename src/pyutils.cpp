@@ -0,0 +1,1386 @@
+#include <Python.h>
+#include "pyutils.h"
+
+#include <ai.h>
+#include <algorithm>
+
+#if PY_MAJOR_VERSION >= 3
+#  define PyInt_FromLong PyLong_FromLong
+#  define PyInt_AsLong PyLong_AsLong
+#  define PyInteger_Check(obj) PyLong_Check(obj)
+#  define PyStr_Check(obj) PyUnicode_Check(obj)
+#else
+#  define PyInteger_Check(obj) (PyInt_Check(obj) || PyLong_Check(obj))
+#  define PyStr_Check(obj) (PyString_Check(obj) || PyUnicode_Check(obj))
+#endif
+
+static bool PyToString(PyObject *obj, std::string &str)
+{
+#if PY_MAJOR_VERSION >= 3
+   if (PyUnicode_Check(obj))
+   {
+      const char *s = PyUnicode_AsUTF8(obj);
+      if (s)
+      {
+         str = s;
+         return true;
+      }
+      PyErr_Clear();
+   }
+#else
+   if (PyString_Check(obj))
+   {
+      str = PyString_AsString(obj);
+      return true;
+   }
+   else if (PyUnicode_Check(obj))
+   {
+      PyObject *utf8 = PyUnicode_AsUTF8String(obj);
+      if (utf8)
+      {
+         str = PyString_AsString(utf8);
+         Py_DECREF(utf8);
+         return true;
+      }
+      PyErr_Clear();
+   }
+#endif
+   return false;
+}
+
+static bool PyToStringList(PyObject *obj, std::vector<std::string> &strs)
+{
+   strs.clear();
+   
+   if (obj == Py_None)
+   {
+      return true;
+   }
+   
+   // A bare string is a single name, not a sequence of characters
+   if (PyStr_Check(obj))
+   {
+      std::string str;
+      if (PyToString(obj, str))
+      {
+         strs.push_back(str);
+      }
+      return true;
+   }
+   
+   PyObject *seq = PySequence_Fast(obj, "expected a sequence");
+   if (!seq)
+   {
+      return false;
+   }
+   
+   Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+   PyObject **items = PySequence_Fast_ITEMS(seq);
+   
+   strs.reserve(n);
+   
+   std::string str;
+   for (Py_ssize_t i=0; i<n; ++i)
+   {
+      if (PyToString(items[i], str))
+      {
+         strs.push_back(str);
+      }
+   }
+   
+   Py_DECREF(seq);
+   
+   return true;
+}
+
+// Reads n floats from a flat sequence (or a sequence of sequences for matrices)
+static bool PyToFloats(PyObject *obj, float *out, int n)
+{
+   PyObject *seq = PySequence_Fast(obj, "expected a sequence");
+   if (!seq)
+   {
+      PyErr_Clear();
+      return false;
+   }
+   
+   Py_ssize_t len = PySequence_Fast_GET_SIZE(seq);
+   PyObject **items = PySequence_Fast_ITEMS(seq);
+   bool success = true;
+   
+   if (len == n)
+   {
+      for (Py_ssize_t i=0; i<len && success; ++i)
+      {
+         out[i] = (float) PyFloat_AsDouble(items[i]);
+         success = (PyErr_Occurred() == NULL);
+      }
+   }
+   else if (n == 16 && len == 4)
+   {
+      for (Py_ssize_t i=0; i<len && success; ++i)
+      {
+         success = PyToFloats(items[i], out + 4 * i, 4);
+      }
+   }
+   else
+   {
+      success = false;
+   }
+   
+   Py_DECREF(seq);
+   
+   if (!success)
+   {
+      PyErr_Clear();
+   }
+   
+   return success;
+}
+
+static bool PyToInt(PyObject *obj, long &val)
+{
+   val = PyInt_AsLong(obj);
+   if (val == -1 && PyErr_Occurred())
+   {
+      PyErr_Clear();
+      return false;
+   }
+   return true;
+}
+
+static bool PySetArrayElement(AtArray *array, AtUInt32 i, int type, PyObject *obj)
+{
+   long ival = 0;
+   float fval[16];
+   std::string sval;
+   
+   switch (type)
+   {
+   case AI_TYPE_BOOLEAN:
+      return AiArraySetBool(array, i, PyObject_IsTrue(obj) == 1);
+   case AI_TYPE_BYTE:
+      return (PyToInt(obj, ival) && AiArraySetByte(array, i, (AtByte) ival));
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      return (PyToInt(obj, ival) && AiArraySetInt(array, i, (int) ival));
+   case AI_TYPE_UINT:
+      return (PyToInt(obj, ival) && AiArraySetUInt(array, i, (unsigned int) ival));
+   case AI_TYPE_FLOAT:
+      fval[0] = (float) PyFloat_AsDouble(obj);
+      if (PyErr_Occurred())
+      {
+         PyErr_Clear();
+         return false;
+      }
+      return AiArraySetFlt(array, i, fval[0]);
+   case AI_TYPE_POINT2:
+      {
+         AtPoint2 p;
+         if (!PyToFloats(obj, fval, 2)) return false;
+         p.x = fval[0]; p.y = fval[1];
+         return AiArraySetPnt2(array, i, p);
+      }
+   case AI_TYPE_POINT:
+   case AI_TYPE_VECTOR:
+      {
+         AtPoint p;
+         if (!PyToFloats(obj, fval, 3)) return false;
+         p.x = fval[0]; p.y = fval[1]; p.z = fval[2];
+         return (type == AI_TYPE_POINT ? AiArraySetPnt(array, i, p) : AiArraySetVec(array, i, p));
+      }
+   case AI_TYPE_RGB:
+      {
+         AtRGB c;
+         if (!PyToFloats(obj, fval, 3)) return false;
+         c.r = fval[0]; c.g = fval[1]; c.b = fval[2];
+         return AiArraySetRGB(array, i, c);
+      }
+   case AI_TYPE_RGBA:
+      {
+         AtRGBA c;
+         if (!PyToFloats(obj, fval, 4)) return false;
+         c.r = fval[0]; c.g = fval[1]; c.b = fval[2]; c.a = fval[3];
+         return AiArraySetRGBA(array, i, c);
+      }
+   case AI_TYPE_MATRIX:
+      {
+         AtMatrix m;
+         if (!PyToFloats(obj, &(m[0][0]), 16)) return false;
+         return AiArraySetMtx(array, i, m);
+      }
+   case AI_TYPE_STRING:
+      return (PyToString(obj, sval) && AiArraySetStr(array, i, sval.c_str()));
+   case AI_TYPE_NODE:
+      if (obj == Py_None)
+      {
+         return AiArraySetPtr(array, i, NULL);
+      }
+      return (PyToString(obj, sval) && AiArraySetPtr(array, i, AiNodeLookUpByName(sval.c_str())));
+   default:
+      return false;
+   }
+}
+
+static bool PySetParameter(AtNode *node, const char *param, int type, int arrayType, PyObject *obj)
+{
+   long ival = 0;
+   float fval[16];
+   std::string sval;
+   
+   switch (type)
+   {
+   case AI_TYPE_BOOLEAN:
+      AiNodeSetBool(node, param, PyObject_IsTrue(obj) == 1);
+      return true;
+   case AI_TYPE_BYTE:
+      if (!PyToInt(obj, ival)) return false;
+      AiNodeSetByte(node, param, (AtByte) ival);
+      return true;
+   case AI_TYPE_INT:
+      if (!PyToInt(obj, ival)) return false;
+      AiNodeSetInt(node, param, (int) ival);
+      return true;
+   case AI_TYPE_ENUM:
+      // Enums accept both index and name
+      if (PyToString(obj, sval))
+      {
+         AiNodeSetStr(node, param, sval.c_str());
+         return true;
+      }
+      if (!PyToInt(obj, ival)) return false;
+      AiNodeSetInt(node, param, (int) ival);
+      return true;
+   case AI_TYPE_UINT:
+      if (!PyToInt(obj, ival)) return false;
+      AiNodeSetUInt(node, param, (unsigned int) ival);
+      return true;
+   case AI_TYPE_FLOAT:
+      fval[0] = (float) PyFloat_AsDouble(obj);
+      if (PyErr_Occurred())
+      {
+         PyErr_Clear();
+         return false;
+      }
+      AiNodeSetFlt(node, param, fval[0]);
+      return true;
+   case AI_TYPE_POINT2:
+      if (!PyToFloats(obj, fval, 2)) return false;
+      AiNodeSetPnt2(node, param, fval[0], fval[1]);
+      return true;
+   case AI_TYPE_POINT:
+      if (!PyToFloats(obj, fval, 3)) return false;
+      AiNodeSetPnt(node, param, fval[0], fval[1], fval[2]);
+      return true;
+   case AI_TYPE_VECTOR:
+      if (!PyToFloats(obj, fval, 3)) return false;
+      AiNodeSetVec(node, param, fval[0], fval[1], fval[2]);
+      return true;
+   case AI_TYPE_RGB:
+      if (!PyToFloats(obj, fval, 3)) return false;
+      AiNodeSetRGB(node, param, fval[0], fval[1], fval[2]);
+      return true;
+   case AI_TYPE_RGBA:
+      if (!PyToFloats(obj, fval, 4)) return false;
+      AiNodeSetRGBA(node, param, fval[0], fval[1], fval[2], fval[3]);
+      return true;
+   case AI_TYPE_MATRIX:
+      {
+         AtMatrix m;
+         if (!PyToFloats(obj, &(m[0][0]), 16)) return false;
+         AiNodeSetMatrix(node, param, m);
+      }
+      return true;
+   case AI_TYPE_STRING:
+      if (!PyToString(obj, sval)) return false;
+      AiNodeSetStr(node, param, sval.c_str());
+      return true;
+   case AI_TYPE_NODE:
+      if (obj == Py_None)
+      {
+         AiNodeSetPtr(node, param, NULL);
+         return true;
+      }
+      if (!PyToString(obj, sval)) return false;
+      AiNodeSetPtr(node, param, AiNodeLookUpByName(sval.c_str()));
+      return true;
+   case AI_TYPE_ARRAY:
+      {
+         PyObject *seq = PySequence_Fast(obj, "expected a sequence");
+         if (!seq)
+         {
+            PyErr_Clear();
+            return false;
+         }
+         
+         Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+         PyObject **items = PySequence_Fast_ITEMS(seq);
+         AtArray *array = AiArrayAllocate((AtUInt32) n, 1, arrayType);
+         bool success = true;
+         
+         for (Py_ssize_t i=0; i<n && success; ++i)
+         {
+            success = PySetArrayElement(array, (AtUInt32) i, arrayType, items[i]);
+         }
+         
+         Py_DECREF(seq);
+         
+         if (!success)
+         {
+            AiArrayDestroy(array);
+            return false;
+         }
+         
+         AiNodeSetArray(node, param, array);
+      }
+      return true;
+   default:
+      return false;
+   }
+}
+
+// Arnold type used to declare a user parameter from a python value
+static int PyGetDeclType(PyObject *obj)
+{
+   if (PyBool_Check(obj))
+   {
+      return AI_TYPE_BOOLEAN;
+   }
+   else if (PyFloat_Check(obj))
+   {
+      return AI_TYPE_FLOAT;
+   }
+   else if (PyInteger_Check(obj))
+   {
+      return AI_TYPE_INT;
+   }
+   else if (PyStr_Check(obj))
+   {
+      return AI_TYPE_STRING;
+   }
+   else
+   {
+      return AI_TYPE_UNDEFINED;
+   }
+}
+
+// Get parameter type, declaring it as a constant user parameter from the python value if needed
+// When motion is true, new user parameters are always declared as arrays
+static bool PyResolveParameter(AtNode *node, const char *param, PyObject *obj, bool motion, int &type, int &arrayType)
+{
+   type = AI_TYPE_UNDEFINED;
+   arrayType = AI_TYPE_UNDEFINED;
+   
+   const AtParamEntry *pentry = AiNodeEntryLookUpParameter(AiNodeGetNodeEntry(node), param);
+   
+   if (pentry)
+   {
+      type = AiParamGetType(pentry);
+      if (type == AI_TYPE_ARRAY)
+      {
+         const AtParamValue *defval = AiParamGetDefault(pentry);
+         arrayType = (defval && defval->ARRAY ? defval->ARRAY->type : AI_TYPE_UNDEFINED);
+      }
+   }
+   else
+   {
+      const AtUserParamEntry *upentry = AiNodeLookUpUserParameter(node, param);
+      
+      if (upentry)
+      {
+         type = AiUserParamGetType(upentry);
+         arrayType = AiUserParamGetArrayType(upentry);
+      }
+      else
+      {
+         // Declare new constant user parameter
+         std::string decl = "constant ";
+         
+         type = PyGetDeclType(obj);
+         
+         if (type == AI_TYPE_UNDEFINED && PyList_Check(obj) && PyList_GET_SIZE(obj) > 0)
+         {
+            arrayType = PyGetDeclType(PyList_GET_ITEM(obj, 0));
+            if (arrayType != AI_TYPE_UNDEFINED)
+            {
+               type = AI_TYPE_ARRAY;
+               decl += "ARRAY ";
+            }
+         }
+         else if (type != AI_TYPE_UNDEFINED && motion)
+         {
+            arrayType = type;
+            type = AI_TYPE_ARRAY;
+            decl += "ARRAY ";
+         }
+         
+         switch (type == AI_TYPE_ARRAY ? arrayType : type)
+         {
+         case AI_TYPE_BOOLEAN:
+            decl += "BOOL";
+            break;
+         case AI_TYPE_INT:
+            decl += "INT";
+            break;
+         case AI_TYPE_FLOAT:
+            decl += "FLOAT";
+            break;
+         case AI_TYPE_STRING:
+            decl += "STRING";
+            break;
+         default:
+            return false;
+         }
+         
+         if (!AiNodeDeclare(node, param, decl.c_str()))
+         {
+            return false;
+         }
+      }
+   }
+   
+   return (type != AI_TYPE_ARRAY || arrayType != AI_TYPE_UNDEFINED);
+}
+
+static bool PyApplyParameter(AtNode *node, const char *param, PyObject *obj)
+{
+   int type, arrayType;
+   
+   if (!PyResolveParameter(node, param, obj, false, type, arrayType))
+   {
+      return false;
+   }
+   
+   return PySetParameter(node, param, type, arrayType, obj);
+}
+
+// Set per motion step values as the keys of an array parameter
+// A python list holds the array elements for that step, any other value is a single element
+// Steps with no value use the one of the previous step (or the first defined one)
+static bool PyApplyMotionParameter(AtNode *node, const char *param, std::vector<PyObject*> &values)
+{
+   PyObject *first = NULL;
+   
+   for (size_t i=0; i<values.size() && !first; ++i)
+   {
+      first = values[i];
+   }
+   
+   if (!first)
+   {
+      return false;
+   }
+   
+   int type, arrayType;
+   
+   if (!PyResolveParameter(node, param, first, true, type, arrayType))
+   {
+      return false;
+   }
+   
+   if (type != AI_TYPE_ARRAY)
+   {
+      // Parameter cannot hold motion keys, only the first value is used
+      for (size_t i=0; i<values.size(); ++i)
+      {
+         if (values[i] && values[i] != first && PyObject_RichCompareBool(values[i], first, Py_EQ) != 1)
+         {
+            PyErr_Clear();
+            AiMsgWarning("[mtoa.scriptedTranslators] Parameter \"%s\" of node \"%s\" is not an array, motion steps values ignored.", param, AiNodeGetName(node));
+            break;
+         }
+      }
+      return PySetParameter(node, param, type, arrayType, first);
+   }
+   
+   for (size_t i=0; i<values.size(); ++i)
+   {
+      if (!values[i])
+      {
+         values[i] = (i > 0 ? values[i-1] : first);
+      }
+   }
+   
+   Py_ssize_t nelements = (PyList_Check(first) ? PyList_GET_SIZE(first) : 1);
+   
+   for (size_t i=0; i<values.size(); ++i)
+   {
+      if ((PyList_Check(values[i]) ? PyList_GET_SIZE(values[i]) : 1) != nelements)
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] Element count varies across motion steps for parameter \"%s\".", param);
+         return false;
+      }
+   }
+   
+   AtArray *array = AiArrayAllocate((AtUInt32) nelements, (AtByte) values.size(), arrayType);
+   bool success = true;
+   
+   for (size_t i=0; i<values.size() && success; ++i)
+   {
+      AtUInt32 offset = (AtUInt32) (i * nelements);
+      
+      if (PyList_Check(values[i]))
+      {
+         for (Py_ssize_t j=0; j<nelements && success; ++j)
+         {
+            success = PySetArrayElement(array, offset + (AtUInt32) j, arrayType, PyList_GET_ITEM(values[i], j));
+         }
+      }
+      else
+      {
+         success = PySetArrayElement(array, offset, arrayType, values[i]);
+      }
+   }
+   
+   if (!success)
+   {
+      AiArrayDestroy(array);
+      return false;
+   }
+   
+   AiNodeSetArray(node, param, array);
+   
+   return true;
+}
+
+// ExportMotion returns one Export like result per motion step
+static bool PyProcessExportMotionResult(PyObject *rv, size_t nsteps, AtNode *node, std::vector<std::string> &attrs)
+{
+   PyObject *seq = PySequence_Fast(rv, "ExportMotion must return a sequence");
+   
+   if (!seq)
+   {
+      return false;
+   }
+   
+   Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+   PyObject **items = PySequence_Fast_ITEMS(seq);
+   
+   if (n != (Py_ssize_t) nsteps)
+   {
+      PyErr_SetString(PyExc_ValueError, "ExportMotion must return one item per motion step");
+      Py_DECREF(seq);
+      return false;
+   }
+   
+   // Parameter names in order of appearance
+   std::vector<std::string> params;
+   std::vector<std::string> names;
+   std::string param;
+   
+   attrs.clear();
+   
+   for (Py_ssize_t i=0; i<n; ++i)
+   {
+      if (PyDict_Check(items[i]))
+      {
+         PyObject *key = NULL;
+         PyObject *value = NULL;
+         Py_ssize_t pos = 0;
+         
+         while (PyDict_Next(items[i], &pos, &key, &value))
+         {
+            if (PyToString(key, param) && std::find(params.begin(), params.end(), param) == params.end())
+            {
+               params.push_back(param);
+            }
+         }
+      }
+      else if (PyToStringList(items[i], names))
+      {
+         for (size_t j=0; j<names.size(); ++j)
+         {
+            if (std::find(attrs.begin(), attrs.end(), names[j]) == attrs.end())
+            {
+               attrs.push_back(names[j]);
+            }
+         }
+      }
+      else
+      {
+         Py_DECREF(seq);
+         return false;
+      }
+   }
+   
+   std::vector<PyObject*> values(nsteps);
+   
+   for (size_t i=0; i<params.size(); ++i)
+   {
+      for (Py_ssize_t j=0; j<n; ++j)
+      {
+         // borrowed references, kept alive by seq
+         values[j] = (PyDict_Check(items[j]) ? PyDict_GetItemString(items[j], params[i].c_str()) : NULL);
+      }
+      
+      if (!node || !PyApplyMotionParameter(node, params[i].c_str(), values))
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] Could not set parameter \"%s\" on node \"%s\".", params[i].c_str(), (node ? AiNodeGetName(node) : ""));
+         continue;
+      }
+      
+      if (std::find(attrs.begin(), attrs.end(), params[i]) == attrs.end())
+      {
+         attrs.push_back(params[i]);
+      }
+   }
+   
+   Py_DECREF(seq);
+   
+   return true;
+}
+
+// Export functions may either return the list of parameters they have set themselves
+//   or a {param: value} dictionary that is applied to node here
+static bool PyProcessExportResult(PyObject *rv, AtNode *node, std::vector<std::string> &attrs)
+{
+   if (!PyDict_Check(rv))
+   {
+      return PyToStringList(rv, attrs);
+   }
+   
+   attrs.clear();
+   attrs.reserve(PyDict_Size(rv));
+   
+   PyObject *key = NULL;
+   PyObject *value = NULL;
+   Py_ssize_t pos = 0;
+   std::string param;
+   
+   while (PyDict_Next(rv, &pos, &key, &value))
+   {
+      if (!PyToString(key, param))
+      {
+         continue;
+      }
+      
+      if (!node || !PyApplyParameter(node, param.c_str(), value))
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] Could not set parameter \"%s\" on node \"%s\".", param.c_str(), (node ? AiNodeGetName(node) : ""));
+         continue;
+      }
+      
+      attrs.push_back(param);
+   }
+   
+   return true;
+}
+
+static PyObject* PyBuildNamePair(const char *mayaName, const char *arnoldName)
+{
+   if (!mayaName)
+   {
+      Py_INCREF(Py_None);
+      return Py_None;
+   }
+   
+   return Py_BuildValue("(ss)", mayaName, arnoldName);
+}
+
+// Returns a new (nodeNamePair, masterNodeNamePair) tuple
+static PyObject* PyBuildNamePairs(const CPyNodeNames &names)
+{
+   PyObject *pairs = PyTuple_New(2);
+   PyTuple_SET_ITEM(pairs, 0, PyBuildNamePair(names.mayaName, names.arnoldName));
+   PyTuple_SET_ITEM(pairs, 1, PyBuildNamePair(names.masterMayaName, names.masterArnoldName));
+   return pairs;
+}
+
+static PyObject* PyBuildNamePairsList(const std::vector<CPyNodeNames> &names)
+{
+   PyObject *list = PyList_New(names.size());
+   for (size_t i=0; i<names.size(); ++i)
+   {
+      PyList_SET_ITEM(list, i, PyBuildNamePairs(names[i]));
+   }
+   return list;
+}
+
+// Steals args reference, returns new reference or NULL on error (error already reported)
+static PyObject* PyCall(PyObject *func, PyObject *args)
+{
+   PyObject *rv = NULL;
+   
+   if (func && args)
+   {
+      rv = PyObject_CallObject(func, args);
+   }
+   
+   Py_XDECREF(args);
+   
+   if (!rv && PyErr_Occurred())
+   {
+      PyErr_Print();
+   }
+   
+   return rv;
+}
+
+CPyLock::CPyLock()
+   : m_state((int) PyGILState_Ensure())
+{
+}
+
+CPyLock::~CPyLock()
+{
+   PyGILState_Release((PyGILState_STATE) m_state);
+}
+
+bool PyFindModuleFile(const char *moduleName, std::string &path)
+{
+   CPyLock lock;
+   
+   bool found = false;
+
+#if PY_MAJOR_VERSION >= 3
+   PyObject *util = PyImport_ImportModule("importlib.util");
+   PyObject *spec = (util ? PyObject_CallMethod(util, (char*) "find_spec", (char*) "s", moduleName) : NULL);
+   
+   if (spec && spec != Py_None)
+   {
+      PyObject *origin = PyObject_GetAttrString(spec, "origin");
+      found = (origin && PyToString(origin, path));
+      Py_XDECREF(origin);
+   }
+   
+   Py_XDECREF(spec);
+   Py_XDECREF(util);
+#else
+   PyObject *imp = PyImport_ImportModule("imp");
+   PyObject *desc = (imp ? PyObject_CallMethod(imp, (char*) "find_module", (char*) "s", moduleName) : NULL);
+   
+   // (file, pathname, description)
+   if (desc && PyTuple_Check(desc) && PyTuple_GET_SIZE(desc) == 3)
+   {
+      PyObject *file = PyTuple_GET_ITEM(desc, 0);
+      if (file != Py_None)
+      {
+         PyObject *rv = PyObject_CallMethod(file, (char*) "close", NULL);
+         Py_XDECREF(rv);
+      }
+      found = PyToString(PyTuple_GET_ITEM(desc, 1), path);
+   }
+   
+   Py_XDECREF(desc);
+   Py_XDECREF(imp);
+#endif
+   
+   PyErr_Clear();
+   
+   return found;
+}
+
+static const char* gModuleFuncNames[PYFUNC_COUNT] =
+{
+   "Export",
+   "Cleanup",
+   "ExportBatch",
+   "ExportInstance",
+   "ExportMotion",
+   "CleanupBatch",
+   "SetupAttrs",
+   "SetupAE"
+};
+
+static const char* gModuleCapNames[PYCAP_COUNT] =
+{
+   "IsShape",
+   "SupportVolumes",
+   "SupportInstances",
+   "SupportMotionBounds",
+   "PrefetchMotionMatrices",
+   "SupportReplay",
+   "FastInstances"
+};
+
+const char* PyGetModuleFuncName(PyModuleFunc func)
+{
+   return gModuleFuncNames[func];
+}
+
+const char* PyGetModuleCapName(PyModuleCap cap)
+{
+   return gModuleCapNames[cap];
+}
+
+CPyModuleProbe::CPyModuleProbe()
+{
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      funcs[i] = NULL;
+   }
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      caps[i] = (i == PYCAP_IS_SHAPE);
+   }
+}
+
+bool PyProbeModule(const char *moduleName, CPyModuleProbe &probe)
+{
+   CPyLock lock;
+   
+   PyObject *module = PyImport_ImportModule(moduleName);
+   
+   if (!module)
+   {
+      PyErr_Print();
+      return false;
+   }
+   
+   for (int i=0; i<PYFUNC_COUNT; ++i)
+   {
+      PyObject *func = PyObject_GetAttrString(module, gModuleFuncNames[i]);
+      
+      if (func && !PyCallable_Check(func))
+      {
+         Py_DECREF(func);
+         func = NULL;
+      }
+      
+      probe.funcs[i] = func;
+   }
+   
+   PyErr_Clear();
+   
+   // Capabilities() returns a {capabilityName: value} dictionary, capability functions are called for missing keys
+   PyObject *manifest = NULL;
+   PyObject *capsFunc = PyObject_GetAttrString(module, "Capabilities");
+   
+   if (capsFunc && PyCallable_Check(capsFunc))
+   {
+      manifest = PyCall(capsFunc, PyTuple_New(0));
+      
+      if (manifest && !PyDict_Check(manifest))
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] %s.Capabilities must return a dictionary.", moduleName);
+         Py_DECREF(manifest);
+         manifest = NULL;
+      }
+   }
+   
+   Py_XDECREF(capsFunc);
+   PyErr_Clear();
+   
+   for (int i=0; i<PYCAP_COUNT; ++i)
+   {
+      PyObject *value = (manifest ? PyDict_GetItemString(manifest, gModuleCapNames[i]) : NULL);
+      
+      if (value)
+      {
+         int truth = PyObject_IsTrue(value);
+         if (truth >= 0)
+         {
+            probe.caps[i] = (truth != 0);
+            continue;
+         }
+         PyErr_Clear();
+      }
+      
+      PyObject *func = PyObject_GetAttrString(module, gModuleCapNames[i]);
+      
+      if (func && PyCallable_Check(func))
+      {
+         bool result = probe.caps[i];
+         if (PyCallBool(func, result))
+         {
+            probe.caps[i] = result;
+         }
+      }
+      
+      Py_XDECREF(func);
+      PyErr_Clear();
+   }
+   
+   Py_XDECREF(manifest);
+   Py_DECREF(module);
+   
+   return true;
+}
+
+void PyRelease(PyObject *obj)
+{
+   if (obj)
+   {
+      CPyLock lock;
+      Py_DECREF(obj);
+   }
+}
+
+bool PyCallBool(PyObject *func, bool &result)
+{
+   CPyLock lock;
+   
+   PyObject *rv = PyCall(func, PyTuple_New(0));
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   int truth = PyObject_IsTrue(rv);
+   
+   Py_DECREF(rv);
+   
+   if (truth < 0)
+   {
+      PyErr_Clear();
+      return false;
+   }
+   
+   result = (truth != 0);
+   
+   return true;
+}
+
+static const char* gAttrRecordFields[] =
+{
+   "type",
+   "arnoldNode",
+   "arnoldAttr",
+   "name",
+   "shortName",
+   "isArray",
+   "defaultValue",
+   "min",
+   "max",
+   "softMin",
+   "softMax",
+   "keyable",
+   "enums"
+};
+
+enum PyAttrRecordField
+{
+   PYATTR_FIELD_TYPE = 0,
+   PYATTR_FIELD_ARNOLD_NODE,
+   PYATTR_FIELD_ARNOLD_ATTR,
+   PYATTR_FIELD_NAME,
+   PYATTR_FIELD_SHORT_NAME,
+   PYATTR_FIELD_IS_ARRAY,
+   PYATTR_FIELD_DEFAULT,
+   PYATTR_FIELD_KEYABLE = PYATTR_FIELD_DEFAULT + PYATTR_VALUE_COUNT,
+   PYATTR_FIELD_ENUMS,
+   PYATTR_FIELD_COUNT
+};
+
+CPyAttrRecord::CPyAttrRecord()
+   : type(AI_TYPE_UNDEFINED), isArray(false), keyable(false)
+{
+   for (int i=0; i<PYATTR_VALUE_COUNT; ++i)
+   {
+      values[i] = NULL;
+   }
+}
+
+static void PyReleaseAttrRecordValues(CPyAttrRecord &record)
+{
+   for (int i=0; i<PYATTR_VALUE_COUNT; ++i)
+   {
+      if (record.values[i])
+      {
+         AiArrayDestroy(record.values[i]);
+         record.values[i] = NULL;
+      }
+   }
+}
+
+// New reference to a record field, NULL when not set or None
+static PyObject* PyGetAttrRecordField(PyObject *obj, int field)
+{
+   PyObject *item = NULL;
+   
+   if (PyDict_Check(obj))
+   {
+      item = PyDict_GetItemString(obj, gAttrRecordFields[field]);
+      Py_XINCREF(item);
+   }
+   else if (PyTuple_Check(obj))
+   {
+      if (field < PyTuple_GET_SIZE(obj))
+      {
+         item = PyTuple_GET_ITEM(obj, field);
+         Py_INCREF(item);
+      }
+   }
+   else if (PyObject_HasAttrString(obj, gAttrRecordFields[field]))
+   {
+      item = PyObject_GetAttrString(obj, gAttrRecordFields[field]);
+      if (!item)
+      {
+         PyErr_Clear();
+      }
+   }
+   
+   if (item == Py_None)
+   {
+      Py_DECREF(item);
+      item = NULL;
+   }
+   
+   return item;
+}
+
+static bool PySetAttrRecordElement(AtArray *array, AtUInt32 i, const CPyAttrRecord &record, PyObject *obj)
+{
+   std::string sval;
+   
+   switch (record.type)
+   {
+   case AI_TYPE_ENUM:
+      // Enum name or index
+      if (PyToString(obj, sval))
+      {
+         std::vector<std::string>::const_iterator it = std::find(record.enums.begin(), record.enums.end(), sval);
+         return (it != record.enums.end() && AiArraySetInt(array, i, (int) (it - record.enums.begin())));
+      }
+      return PySetArrayElement(array, i, AI_TYPE_INT, obj);
+   case AI_TYPE_NODE:
+      // Node attributes have no default
+      return AiArraySetPtr(array, i, NULL);
+   default:
+      return PySetArrayElement(array, i, record.type, obj);
+   }
+}
+
+static AtArray* PyToAttrRecordValue(PyObject *obj, const CPyAttrRecord &record)
+{
+   PyObject *seq = NULL;
+   PyObject **items = &obj;
+   Py_ssize_t n = 1;
+   
+   if (record.isArray)
+   {
+      seq = PySequence_Fast(obj, "expected a sequence");
+      if (!seq)
+      {
+         PyErr_Clear();
+         return NULL;
+      }
+      n = PySequence_Fast_GET_SIZE(seq);
+      items = PySequence_Fast_ITEMS(seq);
+   }
+   
+   AtArray *array = AiArrayAllocate((AtUInt32) n, 1, (AtByte) record.type);
+   bool success = true;
+   
+   for (Py_ssize_t i=0; i<n && success; ++i)
+   {
+      success = PySetAttrRecordElement(array, (AtUInt32) i, record, items[i]);
+   }
+   
+   Py_XDECREF(seq);
+   
+   if (!success)
+   {
+      AiArrayDestroy(array);
+      array = NULL;
+   }
+   
+   return array;
+}
+
+static bool PyToAttrRecord(PyObject *obj, CPyAttrRecord &record)
+{
+   if (PyToString(obj, record.decl))
+   {
+      return true;
+   }
+   
+   if (!PyDict_Check(obj) && !PyTuple_Check(obj) && !PyObject_HasAttrString(obj, gAttrRecordFields[PYATTR_FIELD_TYPE]))
+   {
+      return false;
+   }
+   
+   PyObject *fields[PYATTR_FIELD_COUNT];
+   std::string *strs[] = {NULL, &record.arnoldNode, &record.arnoldAttr, &record.name, &record.shortName};
+   bool success = true;
+   long ival = 0;
+   
+   for (int i=0; i<PYATTR_FIELD_COUNT; ++i)
+   {
+      fields[i] = PyGetAttrRecordField(obj, i);
+   }
+   
+   if (fields[PYATTR_FIELD_TYPE])
+   {
+      success = PyToInt(fields[PYATTR_FIELD_TYPE], ival);
+      record.type = (int) ival;
+   }
+   
+   for (int i=PYATTR_FIELD_ARNOLD_NODE; i<=PYATTR_FIELD_SHORT_NAME && success; ++i)
+   {
+      success = (!fields[i] || PyToString(fields[i], *(strs[i])));
+   }
+   
+   record.isArray = (fields[PYATTR_FIELD_IS_ARRAY] && PyObject_IsTrue(fields[PYATTR_FIELD_IS_ARRAY]) == 1);
+   record.keyable = (fields[PYATTR_FIELD_KEYABLE] && PyObject_IsTrue(fields[PYATTR_FIELD_KEYABLE]) == 1);
+   
+   if (success && fields[PYATTR_FIELD_ENUMS])
+   {
+      std::string enums;
+      
+      // List of names or comma separated names
+      if (PyToString(fields[PYATTR_FIELD_ENUMS], enums))
+      {
+         size_t p0 = 0, p1 = enums.find(',', p0);
+         while (p1 != std::string::npos)
+         {
+            record.enums.push_back(enums.substr(p0, p1-p0));
+            p0 = p1 + 1;
+            p1 = enums.find(',', p0);
+         }
+         record.enums.push_back(enums.substr(p0));
+      }
+      else
+      {
+         success = PyToStringList(fields[PYATTR_FIELD_ENUMS], record.enums);
+         PyErr_Clear();
+      }
+   }
+   
+   // Values are only read for new attributes, arnold defaults are used otherwise
+   if (success && record.arnoldAttr.length() == 0 && record.type != AI_TYPE_UNDEFINED)
+   {
+      for (int i=0; i<PYATTR_VALUE_COUNT && success; ++i)
+      {
+         if (fields[PYATTR_FIELD_DEFAULT + i])
+         {
+            record.values[i] = PyToAttrRecordValue(fields[PYATTR_FIELD_DEFAULT + i], record);
+            success = (record.values[i] != NULL);
+         }
+      }
+   }
+   
+   for (int i=0; i<PYATTR_FIELD_COUNT; ++i)
+   {
+      Py_XDECREF(fields[i]);
+   }
+   
+   if (!success)
+   {
+      PyReleaseAttrRecordValues(record);
+   }
+   
+   return success;
+}
+
+bool PyCallAttrRecords(PyObject *func, std::vector<CPyAttrRecord> &records)
+{
+   CPyLock lock;
+   
+   records.clear();
+   
+   PyObject *rv = PyCall(func, PyTuple_New(0));
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   if (rv == Py_None)
+   {
+      Py_DECREF(rv);
+      return true;
+   }
+   
+   PyObject *seq = PySequence_Fast(rv, "expected a sequence");
+   
+   Py_DECREF(rv);
+   
+   if (!seq)
+   {
+      PyErr_Print();
+      return false;
+   }
+   
+   Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+   PyObject **items = PySequence_Fast_ITEMS(seq);
+   
+   records.reserve(n);
+   
+   for (Py_ssize_t i=0; i<n; ++i)
+   {
+      CPyAttrRecord record;
+      
+      if (PyToAttrRecord(items[i], record))
+      {
+         records.push_back(record);
+      }
+      else
+      {
+         AiMsgWarning("[mtoa.scriptedTranslators] Invalid SetupAttrs record %d.", (int) i);
+      }
+   }
+   
+   Py_DECREF(seq);
+   
+   return true;
+}
+
+void PyReleaseAttrRecords(std::vector<CPyAttrRecord> &records)
+{
+   for (size_t i=0; i<records.size(); ++i)
+   {
+      PyReleaseAttrRecordValues(records[i]);
+   }
+   records.clear();
+}
+
+bool PyCallExport(PyObject *func, double renderFrame, unsigned int step, double sampleFrame,
+                  const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs)
+{
+   CPyLock lock;
+   
+   PyObject *args = PyTuple_New(5);
+   PyTuple_SET_ITEM(args, 0, PyFloat_FromDouble(renderFrame));
+   PyTuple_SET_ITEM(args, 1, PyInt_FromLong(step));
+   PyTuple_SET_ITEM(args, 2, PyFloat_FromDouble(sampleFrame));
+   PyTuple_SET_ITEM(args, 3, PyBuildNamePair(names.mayaName, names.arnoldName));
+   PyTuple_SET_ITEM(args, 4, PyBuildNamePair(names.masterMayaName, names.masterArnoldName));
+   
+   PyObject *rv = PyCall(func, args);
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   bool success = PyProcessExportResult(rv, node, attrs);
+   
+   Py_DECREF(rv);
+   
+   if (!success)
+   {
+      PyErr_Print();
+   }
+   
+   return success;
+}
+
+bool PyCallExportMotion(PyObject *func, double renderFrame, const std::vector<double> &sampleFrames,
+                        const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs)
+{
+   CPyLock lock;
+   
+   PyObject *frames = PyList_New((Py_ssize_t) sampleFrames.size());
+   for (size_t i=0; i<sampleFrames.size(); ++i)
+   {
+      PyList_SET_ITEM(frames, (Py_ssize_t) i, PyFloat_FromDouble(sampleFrames[i]));
+   }
+   
+   PyObject *args = PyTuple_New(4);
+   PyTuple_SET_ITEM(args, 0, PyFloat_FromDouble(renderFrame));
+   PyTuple_SET_ITEM(args, 1, frames);
+   PyTuple_SET_ITEM(args, 2, PyBuildNamePair(names.mayaName, names.arnoldName));
+   PyTuple_SET_ITEM(args, 3, PyBuildNamePair(names.masterMayaName, names.masterArnoldName));
+   
+   PyObject *rv = PyCall(func, args);
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   bool success = PyProcessExportMotionResult(rv, sampleFrames.size(), node, attrs);
+   
+   Py_DECREF(rv);
+   
+   if (!success)
+   {
+      PyErr_Print();
+   }
+   
+   return success;
+}
+
+bool PyCallExportBatch(PyObject *func, double renderFrame, unsigned int step, double sampleFrame,
+                       const std::vector<CPyNodeNames> &names, const std::vector<AtNode*> &nodes,
+                       std::vector< std::vector<std::string> > &attrs, std::vector<bool> &processed)
+{
+   CPyLock lock;
+   
+   attrs.clear();
+   attrs.resize(names.size());
+   processed.assign(names.size(), false);
+   
+   PyObject *args = PyTuple_New(4);
+   PyTuple_SET_ITEM(args, 0, PyFloat_FromDouble(renderFrame));
+   PyTuple_SET_ITEM(args, 1, PyInt_FromLong(step));
+   PyTuple_SET_ITEM(args, 2, PyFloat_FromDouble(sampleFrame));
+   PyTuple_SET_ITEM(args, 3, PyBuildNamePairsList(names));
+   
+   PyObject *rv = PyCall(func, args);
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   PyObject *seq = PySequence_Fast(rv, "ExportBatch must return a sequence");
+   
+   Py_DECREF(rv);
+   
+   if (!seq)
+   {
+      PyErr_Print();
+      return false;
+   }
+   
+   Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+   PyObject **items = PySequence_Fast_ITEMS(seq);
+   
+   if (n != (Py_ssize_t) names.size())
+   {
+      AiMsgWarning("[mtoa.scriptedTranslators] ExportBatch returned %d result(s) for %d node(s).", (int) n, (int) names.size());
+   }
+   
+   for (Py_ssize_t i=0; i<n && i<(Py_ssize_t)names.size(); ++i)
+   {
+      if (PyProcessExportResult(items[i], (i < (Py_ssize_t)nodes.size() ? nodes[i] : NULL), attrs[i]))
+      {
+         processed[i] = true;
+      }
+      else
+      {
+         PyErr_Print();
+      }
+   }
+   
+   Py_DECREF(seq);
+   
+   return true;
+}
+
+bool PyCallCleanup(PyObject *func, const CPyNodeNames &names)
+{
+   CPyLock lock;
+   
+   PyObject *rv = PyCall(func, PyBuildNamePairs(names));
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   Py_DECREF(rv);
+   
+   return true;
+}
+
+bool PyCallCleanupBatch(PyObject *func, const std::vector<CPyNodeNames> &names)
+{
+   CPyLock lock;
+   
+   PyObject *args = PyTuple_New(1);
+   PyTuple_SET_ITEM(args, 0, PyBuildNamePairsList(names));
+   
+   PyObject *rv = PyCall(func, args);
+   
+   if (!rv)
+   {
+      return false;
+   }
+   
+   Py_DECREF(rv);
+   
+   return true;
+}
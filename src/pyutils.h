@@ -0,0 +1,144 @@
+#ifndef __pyutils_h__
+#define __pyutils_h__
+
+#include <string>
+#include <vector>
+
+// Avoid pulling Python.h in every translation unit
+typedef struct _object PyObject;
+struct AtNode;
+struct AtArray;
+
+// Acquire the python global interpreter lock for the current scope
+class CPyLock
+{
+public:
+   
+   CPyLock();
+   ~CPyLock();
+
+private:
+   
+   int m_state;
+};
+
+// Names passed to python as (mayaNodeName, arnoldNodeName) tuples
+// masterMayaName may be NULL, in which case masterNodeNamePair is None
+struct CPyNodeNames
+{
+   const char *mayaName;
+   const char *arnoldName;
+   const char *masterMayaName;
+   const char *masterArnoldName;
+};
+
+// Path of the file moduleName would be loaded from, without importing it
+bool PyFindModuleFile(const char *moduleName, std::string &path);
+void PyRelease(PyObject *obj);
+
+// Functions looked up in scripted translator modules
+enum PyModuleFunc
+{
+   PYFUNC_EXPORT = 0,
+   PYFUNC_CLEANUP,
+   PYFUNC_EXPORT_BATCH,
+   PYFUNC_EXPORT_INSTANCE,
+   PYFUNC_EXPORT_MOTION,
+   PYFUNC_CLEANUP_BATCH,
+   PYFUNC_SETUP_ATTRS,
+   PYFUNC_SETUP_AE,
+   PYFUNC_COUNT
+};
+
+// Capabilities of scripted translator modules
+enum PyModuleCap
+{
+   PYCAP_IS_SHAPE = 0,
+   PYCAP_SUPPORT_VOLUMES,
+   PYCAP_SUPPORT_INSTANCES,
+   PYCAP_SUPPORT_MOTION_BOUNDS,
+   PYCAP_PREFETCH_MOTION_MATRICES,
+   PYCAP_SUPPORT_REPLAY,
+   PYCAP_FAST_INSTANCES,
+   PYCAP_COUNT
+};
+
+const char* PyGetModuleFuncName(PyModuleFunc func);
+const char* PyGetModuleCapName(PyModuleCap cap);
+
+// funcs hold new references (or NULL), caps default to True for IsShape and False otherwise
+struct CPyModuleProbe
+{
+   PyObject *funcs[PYFUNC_COUNT];
+   bool caps[PYCAP_COUNT];
+   
+   CPyModuleProbe();
+};
+
+// Import moduleName and look up all its functions at once
+// Capabilities are read from the dictionary returned by the module Capabilities function, if any,
+//   the function of the same name is called for those it doesn't define
+bool PyProbeModule(const char *moduleName, CPyModuleProbe &probe);
+
+// SetupAttrs result values
+enum PyAttrValue
+{
+   PYATTR_DEFAULT = 0,
+   PYATTR_MIN,
+   PYATTR_MAX,
+   PYATTR_SOFT_MIN,
+   PYATTR_SOFT_MAX,
+   PYATTR_VALUE_COUNT
+};
+
+// One attribute returned by SetupAttrs, either a declaration string (see scriptedTranslatorUtils.AttrData.__str__)
+//   or a structured record: a dictionary, an object with the same attributes as scriptedTranslatorUtils.AttrData
+//   or a (type, arnoldNode, arnoldAttr, name, shortName, isArray, defaultValue, min, max, softMin, softMax, keyable, enums) tuple
+struct CPyAttrRecord
+{
+   // Only set for declaration strings, other members are then unused
+   std::string decl;
+   int type;
+   std::string arnoldNode;
+   std::string arnoldAttr;
+   std::string name;
+   std::string shortName;
+   bool isArray;
+   bool keyable;
+   std::vector<std::string> enums;
+   // Arrays of a single element unless isArray is set, NULL when not set
+   AtArray *values[PYATTR_VALUE_COUNT];
+   
+   CPyAttrRecord();
+};
+
+bool PyCallBool(PyObject *func, bool &result);
+
+// Invalid records are skipped, remaining values must be released with PyReleaseAttrRecords
+bool PyCallAttrRecords(PyObject *func, std::vector<CPyAttrRecord> &records);
+void PyReleaseAttrRecords(std::vector<CPyAttrRecord> &records);
+
+// func(renderFrame, mbStep, mbSampleFrame, nodeNamePair, masterNodeNamePair)
+// func may either return the names of the parameters it has set or a {param: value} dictionary
+//   that is applied to node, in which case attrs is filled with the dictionary keys
+bool PyCallExport(PyObject *func, double renderFrame, unsigned int step, double sampleFrame,
+                  const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs);
+
+// func(renderFrame, [mbSampleFrame, ...], nodeNamePair, masterNodeNamePair)
+// func returns one PyCallExport like result per sample frame, dictionary values are set as motion keys
+bool PyCallExportMotion(PyObject *func, double renderFrame, const std::vector<double> &sampleFrames,
+                        const CPyNodeNames &names, AtNode *node, std::vector<std::string> &attrs);
+
+// func(renderFrame, mbStep, mbSampleFrame, [(nodeNamePair, masterNodeNamePair), ...])
+// func returns one PyCallExport like result per node, processed is false for the nodes without a valid one
+bool PyCallExportBatch(PyObject *func, double renderFrame, unsigned int step, double sampleFrame,
+                       const std::vector<CPyNodeNames> &names, const std::vector<AtNode*> &nodes,
+                       std::vector< std::vector<std::string> > &attrs, std::vector<bool> &processed);
+
+// func(nodeNamePair, masterNodeNamePair)
+bool PyCallCleanup(PyObject *func, const CPyNodeNames &names);
+
+// func([(nodeNamePair, masterNodeNamePair), ...])
+bool PyCallCleanupBatch(PyObject *func, const std::vector<CPyNodeNames> &names);
+
+#endif
@@ -0,0 +1,954 @@
+#include "replay.h"
+#include "plugin.h"
+#include "cache.h"
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFnAttribute.h>
+#include <maya/MFnRenderLayer.h>
+#include <maya/MItDependencyGraph.h>
+#include <maya/MFileIO.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MStringArray.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MAnimControl.h>
+#include <maya/MEventMessage.h>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+struct CReplayParam
+{
+   std::string name;
+   int type;
+   // User parameter declaration, empty for node entry parameters
+   std::string decl;
+   // Arrays are owned by the cache
+   AtParamValue value;
+   AtMatrix matrix;
+   // String value or linked node name
+   std::string str;
+};
+
+struct CReplayEntry
+{
+   unsigned long long fingerprint;
+   std::vector<CReplayParam> params;
+   size_t size;
+   std::list<std::string>::iterator lru;
+};
+
+typedef std::map<std::string, CReplayEntry> CReplayCache;
+
+// Hash of a single node name, type, values and incoming connections
+struct CNodeHash
+{
+   MObjectHandle node;
+   unsigned long long hash;
+   bool timeDependent;
+};
+
+// By MObjectHandle hash code
+typedef std::map<unsigned int, std::vector<CNodeHash> > CNodeHashCache;
+
+static CReplayCache gReplayCache;
+// Most recently used first
+static std::list<std::string> gReplayLRU;
+static size_t gReplaySize = 0;
+// Budget in bytes, 0 when disabled, -1 until the environment is read
+static long long gReplayBudget = -1;
+static int gReplayDisk = -1;
+
+static const char* gPayloadHeader = "mtoaScriptedTranslators export 1\n";
+
+// Node hashes are shared by all the nodes exported for the same frame and render layer
+//   any edit has to go through the maya event loop, so the cache is also dropped on the next idle event
+static CNodeHashCache gNodeHashes;
+static MTime gNodeHashesTime;
+static std::string gNodeHashesLayer;
+static MCallbackId gIdleCallbackId = 0;
+
+
+static size_t GetBudget()
+{
+   if (gReplayBudget < 0)
+   {
+      MString var = MString("$MTOA_SCRIPTED_TRANSLATORS_REPLAY").expandEnvironmentVariablesAndTilde();
+      double mb = (var == "$MTOA_SCRIPTED_TRANSLATORS_REPLAY" ? 0.0 : atof(var.asChar()));
+      gReplayBudget = (mb > 0.0 ? (long long) (mb * 1024.0 * 1024.0) : 0);
+   }
+   return (size_t) gReplayBudget;
+}
+
+// Payloads are also saved to the cache directory, named after the fingerprint
+static bool IsReplayDiskEnabled()
+{
+   if (gReplayDisk < 0)
+   {
+      MString var = MString("$MTOA_SCRIPTED_TRANSLATORS_REPLAY_DISK").expandEnvironmentVariablesAndTilde();
+      bool set = (var.length() > 0 && var != "0" && var != "$MTOA_SCRIPTED_TRANSLATORS_REPLAY_DISK");
+      gReplayDisk = ((set && GetCacheDirectory().length() > 0) ? 1 : 0);
+   }
+   return (gReplayDisk != 0);
+}
+
+bool IsReplayEnabled()
+{
+   return (GetBudget() > 0 || IsReplayDiskEnabled());
+}
+
+static void ReleaseParams(std::vector<CReplayParam> &params)
+{
+   for (size_t i=0; i<params.size(); ++i)
+   {
+      if (params[i].type == AI_TYPE_ARRAY && params[i].value.ARRAY)
+      {
+         AiArrayDestroy(params[i].value.ARRAY);
+      }
+   }
+   params.clear();
+}
+
+static void RemoveEntry(CReplayCache::iterator it)
+{
+   gReplaySize -= it->second.size;
+   gReplayLRU.erase(it->second.lru);
+   ReleaseParams(it->second.params);
+   gReplayCache.erase(it);
+}
+
+static void RemoveIdleCallback()
+{
+   if (gIdleCallbackId != 0)
+   {
+      MMessage::removeCallback(gIdleCallbackId);
+      gIdleCallbackId = 0;
+   }
+}
+
+static void IdleCallback(void *)
+{
+   gNodeHashes.clear();
+   RemoveIdleCallback();
+}
+
+void ClearReplayCache()
+{
+   for (CReplayCache::iterator it=gReplayCache.begin(); it!=gReplayCache.end(); ++it)
+   {
+      ReleaseParams(it->second.params);
+   }
+   gReplayCache.clear();
+   gReplayLRU.clear();
+   gReplaySize = 0;
+   
+   RemoveIdleCallback();
+   gNodeHashes.clear();
+}
+
+static void PrepareNodeHashes(const std::string &layerName)
+{
+   MTime time = MAnimControl::currentTime();
+   
+   if (time != gNodeHashesTime || layerName != gNodeHashesLayer)
+   {
+      gNodeHashes.clear();
+      gNodeHashesTime = time;
+      gNodeHashesLayer = layerName;
+   }
+   
+   if (gIdleCallbackId == 0)
+   {
+      MStatus status;
+      
+      gIdleCallbackId = MEventMessage::addEventCallback("idle", IdleCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         // Nothing would tell when scene edits happen, don't keep hashes
+         gIdleCallbackId = 0;
+         gNodeHashes.clear();
+      }
+   }
+}
+
+// Non default values of the node top level attributes, as setAttr commands, and the size and modification time
+//   of the files they reference
+static unsigned long long HashNodeValues(const MObject &node, unsigned long long hash)
+{
+   MFnDependencyNode fnNode(node);
+   MStringArray cmds;
+   
+   for (unsigned int i=0; i<fnNode.attributeCount(); ++i)
+   {
+      MObject attr = fnNode.attribute(i);
+      MFnAttribute fnAttr(attr);
+      
+      if (!fnAttr.parent().isNull())
+      {
+         continue;
+      }
+      
+      MPlug plug(node, attr);
+      
+      cmds.clear();
+      plug.getSetAttrCmds(cmds, MPlug::kChanged);
+      
+      for (unsigned int j=0; j<cmds.length(); ++j)
+      {
+         hash = HashBytes(cmds[j].asChar(), cmds[j].length(), hash);
+      }
+      
+      struct stat st;
+      
+      if (fnAttr.isUsedAsFilename() && !fnAttr.isArray() && stat(plug.asString().expandEnvironmentVariablesAndTilde().asChar(), &st) == 0)
+      {
+         unsigned long long info[2] = {(unsigned long long) st.st_size, (unsigned long long) st.st_mtime};
+         hash = HashBytes((const char*) info, sizeof(info), hash);
+      }
+   }
+   
+   return hash;
+}
+
+// Name, type, values and incoming connections of a single node, looked up in the current frame cache first
+static unsigned long long HashNode(const MObject &node, bool &timeDependent)
+{
+   MObjectHandle handle(node);
+   std::vector<CNodeHash> &hashes = gNodeHashes[handle.hashCode()];
+   
+   for (size_t i=0; i<hashes.size(); ++i)
+   {
+      if (hashes[i].node == handle)
+      {
+         timeDependent = hashes[i].timeDependent;
+         return hashes[i].hash;
+      }
+   }
+   
+   CNodeHash entry;
+   
+   entry.node = handle;
+   entry.hash = 0;
+   entry.timeDependent = (node.hasFn(MFn::kTime) || node.hasFn(MFn::kAnimCurve));
+   
+   if (!entry.timeDependent)
+   {
+      MFnDependencyNode fnNode(node);
+      MString desc = fnNode.name() + " " + fnNode.typeName();
+      MPlugArray plugs, sources;
+      
+      entry.hash = HashBytes(desc.asChar(), desc.length());
+      entry.hash = HashNodeValues(node, entry.hash);
+      
+      fnNode.getConnections(plugs);
+      
+      for (unsigned int i=0; i<plugs.length(); ++i)
+      {
+         sources.clear();
+         plugs[i].connectedTo(sources, true, false);
+         
+         for (unsigned int j=0; j<sources.length(); ++j)
+         {
+            MString conn = sources[j].name() + ">" + plugs[i].name();
+            entry.hash = HashBytes(conn.asChar(), conn.length(), entry.hash);
+         }
+      }
+   }
+   
+   hashes.push_back(entry);
+   
+   timeDependent = entry.timeDependent;
+   return entry.hash;
+}
+
+// Hashes the node and its upstream nodes
+//   time dependent nodes upstream make the export script inputs change with the frame, false is returned then
+static bool HashUpstream(const MObject &node, unsigned long long &hash)
+{
+   MStatus status;
+   MObject root(node);
+   MItDependencyGraph it(root, MFn::kInvalid, MItDependencyGraph::kUpstream, MItDependencyGraph::kDepthFirst, MItDependencyGraph::kNodeLevel, &status);
+   
+   if (status != MS::kSuccess)
+   {
+      return false;
+   }
+   
+   for (; !it.isDone(); it.next())
+   {
+      bool timeDependent = false;
+      unsigned long long nodeHash = HashNode(it.currentItem(), timeDependent);
+      
+      if (timeDependent)
+      {
+         return false;
+      }
+      
+      hash = HashBytes((const char*) &nodeHash, sizeof(nodeHash), hash);
+   }
+   
+   return true;
+}
+
+bool GetReplayKey(const CScriptedTranslator &translator, const MObject &node, const MDagPath &dagPath, const MString &nodeName, CReplayKey &key)
+{
+   if (!IsReplayEnabled() || !translator.supportReplay || translator.moduleKey.length() == 0)
+   {
+      return false;
+   }
+   
+   MObject layer = MFnRenderLayer::currentLayer();
+   std::string layerName = (layer.isNull() ? "" : MFnDependencyNode(layer).name().asChar());
+   // Payloads saved to disk are shared by other scenes
+   MString scene = MFileIO::currentFile();
+   
+   key.name = layerName + "|" + nodeName.asChar();
+   
+   unsigned long long hash = HashBytes(translator.moduleKey.c_str(), translator.moduleKey.length());
+   hash = HashBytes(scene.asChar(), scene.length(), hash);
+   hash = HashBytes(key.name.c_str(), key.name.length(), hash);
+   
+   PrepareNodeHashes(layerName);
+   
+   if (!HashUpstream(node, hash))
+   {
+      return false;
+   }
+   
+   // Exports may use world space values, parent transforms (and their own inputs) are part of the node inputs
+   if (dagPath.isValid())
+   {
+      MDagPath parent(dagPath);
+      
+      if (parent.node() == node)
+      {
+         parent.pop();
+      }
+      
+      while (parent.length() > 0)
+      {
+         if (!HashUpstream(parent.node(), hash))
+         {
+            return false;
+         }
+         parent.pop();
+      }
+   }
+   
+   key.fingerprint = hash;
+   
+   return true;
+}
+
+static const char* GetCategoryName(int category)
+{
+   switch (category)
+   {
+   case AI_USERDEF_CONSTANT:
+      return "constant";
+   case AI_USERDEF_UNIFORM:
+      return "uniform";
+   case AI_USERDEF_VARYING:
+      return "varying";
+   case AI_USERDEF_INDEXED:
+      return "indexed";
+   default:
+      return NULL;
+   }
+}
+
+static bool ReadParam(AtNode *node, CReplayParam &param, size_t &size)
+{
+   const char *name = param.name.c_str();
+   const AtParamEntry *pentry = AiNodeEntryLookUpParameter(AiNodeGetNodeEntry(node), name);
+   int arrayType = AI_TYPE_UNDEFINED;
+   
+   if (pentry)
+   {
+      param.type = AiParamGetType(pentry);
+   }
+   else
+   {
+      const AtUserParamEntry *upentry = AiNodeLookUpUserParameter(node, name);
+      const char *category = (upentry ? GetCategoryName(AiUserParamGetCategory(upentry)) : NULL);
+      
+      if (!category)
+      {
+         return false;
+      }
+      
+      param.type = AiUserParamGetType(upentry);
+      arrayType = AiUserParamGetArrayType(upentry);
+      
+      param.decl = category;
+      param.decl += " ";
+      if (param.type == AI_TYPE_ARRAY)
+      {
+         param.decl += "ARRAY ";
+         param.decl += AiParamGetTypeName((AtByte) arrayType);
+      }
+      else
+      {
+         param.decl += AiParamGetTypeName((AtByte) param.type);
+      }
+   }
+   
+   if (AiNodeIsLinked(node, name))
+   {
+      return false;
+   }
+   
+   size += sizeof(CReplayParam) + param.name.length() + param.decl.length();
+   
+   switch (param.type)
+   {
+   case AI_TYPE_BOOLEAN:
+      param.value.BOOL = AiNodeGetBool(node, name);
+      break;
+   case AI_TYPE_BYTE:
+      param.value.BYTE = AiNodeGetByte(node, name);
+      break;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      param.value.INT = AiNodeGetInt(node, name);
+      break;
+   case AI_TYPE_UINT:
+      param.value.UINT = AiNodeGetUInt(node, name);
+      break;
+   case AI_TYPE_FLOAT:
+      param.value.FLT = AiNodeGetFlt(node, name);
+      break;
+   case AI_TYPE_POINT2:
+      param.value.PNT2 = AiNodeGetPnt2(node, name);
+      break;
+   case AI_TYPE_POINT:
+      param.value.PNT = AiNodeGetPnt(node, name);
+      break;
+   case AI_TYPE_VECTOR:
+      param.value.VEC = AiNodeGetVec(node, name);
+      break;
+   case AI_TYPE_RGB:
+      param.value.RGB = AiNodeGetRGB(node, name);
+      break;
+   case AI_TYPE_RGBA:
+      param.value.RGBA = AiNodeGetRGBA(node, name);
+      break;
+   case AI_TYPE_MATRIX:
+      AiNodeGetMatrix(node, name, param.matrix);
+      break;
+   case AI_TYPE_STRING:
+      {
+         const char *str = AiNodeGetStr(node, name);
+         param.str = (str ? str : "");
+         size += param.str.length();
+      }
+      break;
+   case AI_TYPE_NODE:
+      {
+         // Nodes are looked up by name on replay
+         AtNode *link = (AtNode*) AiNodeGetPtr(node, name);
+         param.str = (link ? AiNodeGetName(link) : "");
+         size += param.str.length();
+      }
+      break;
+   case AI_TYPE_ARRAY:
+      {
+         AtArray *array = AiNodeGetArray(node, name);
+         
+         if (!array || array->type == AI_TYPE_NODE || array->type == AI_TYPE_POINTER || array->type == AI_TYPE_ARRAY)
+         {
+            return false;
+         }
+         
+         param.value.ARRAY = AiArrayCopy(array);
+         size += (size_t) array->nelements * array->nkeys * AiParamGetTypeSize(array->type);
+      }
+      break;
+   default:
+      return false;
+   }
+   
+   return true;
+}
+
+static void WriteParam(AtNode *node, const CReplayParam &param)
+{
+   const char *name = param.name.c_str();
+   
+   switch (param.type)
+   {
+   case AI_TYPE_BOOLEAN:
+      AiNodeSetBool(node, name, param.value.BOOL);
+      break;
+   case AI_TYPE_BYTE:
+      AiNodeSetByte(node, name, param.value.BYTE);
+      break;
+   case AI_TYPE_INT:
+   case AI_TYPE_ENUM:
+      AiNodeSetInt(node, name, param.value.INT);
+      break;
+   case AI_TYPE_UINT:
+      AiNodeSetUInt(node, name, param.value.UINT);
+      break;
+   case AI_TYPE_FLOAT:
+      AiNodeSetFlt(node, name, param.value.FLT);
+      break;
+   case AI_TYPE_POINT2:
+      AiNodeSetPnt2(node, name, param.value.PNT2.x, param.value.PNT2.y);
+      break;
+   case AI_TYPE_POINT:
+      AiNodeSetPnt(node, name, param.value.PNT.x, param.value.PNT.y, param.value.PNT.z);
+      break;
+   case AI_TYPE_VECTOR:
+      AiNodeSetVec(node, name, param.value.VEC.x, param.value.VEC.y, param.value.VEC.z);
+      break;
+   case AI_TYPE_RGB:
+      AiNodeSetRGB(node, name, param.value.RGB.r, param.value.RGB.g, param.value.RGB.b);
+      break;
+   case AI_TYPE_RGBA:
+      AiNodeSetRGBA(node, name, param.value.RGBA.r, param.value.RGBA.g, param.value.RGBA.b, param.value.RGBA.a);
+      break;
+   case AI_TYPE_MATRIX:
+      {
+         AtMatrix matrix;
+         AiM4Copy(matrix, param.matrix);
+         AiNodeSetMatrix(node, name, matrix);
+      }
+      break;
+   case AI_TYPE_STRING:
+      AiNodeSetStr(node, name, param.str.c_str());
+      break;
+   case AI_TYPE_NODE:
+      AiNodeSetPtr(node, name, (param.str.length() > 0 ? AiNodeLookUpByName(param.str.c_str()) : NULL));
+      break;
+   case AI_TYPE_ARRAY:
+      // Node takes ownership of the array
+      AiNodeSetArray(node, name, AiArrayCopy(param.value.ARRAY));
+      break;
+   default:
+      break;
+   }
+}
+
+static bool ApplyParams(AtNode *node, const std::vector<CReplayParam> &params, std::vector<std::string> &attrs)
+{
+   // Linked nodes must exist before anything is set
+   for (size_t i=0; i<params.size(); ++i)
+   {
+      if (params[i].type == AI_TYPE_NODE && params[i].str.length() > 0 && !AiNodeLookUpByName(params[i].str.c_str()))
+      {
+         return false;
+      }
+   }
+   
+   attrs.clear();
+   attrs.reserve(params.size());
+   
+   for (size_t i=0; i<params.size(); ++i)
+   {
+      if (params[i].decl.length() > 0 && !AiNodeLookUpUserParameter(node, params[i].name.c_str()))
+      {
+         AiNodeDeclare(node, params[i].name.c_str(), params[i].decl.c_str());
+      }
+      
+      WriteParam(node, params[i]);
+      
+      attrs.push_back(params[i].name);
+   }
+   
+   return true;
+}
+
+// Takes ownership of the entry parameters
+static void StoreEntry(const std::string &name, CReplayEntry &entry)
+{
+   size_t budget = GetBudget();
+   
+   if (entry.size > budget)
+   {
+      ReleaseParams(entry.params);
+      return;
+   }
+   
+   // Evict least recently used nodes
+   while (gReplaySize + entry.size > budget && !gReplayLRU.empty())
+   {
+      RemoveEntry(gReplayCache.find(gReplayLRU.back()));
+   }
+   
+   gReplayLRU.push_front(name);
+   entry.lru = gReplayLRU.begin();
+   gReplaySize += entry.size;
+   
+   CReplayEntry &stored = gReplayCache[name];
+   
+   stored.fingerprint = entry.fingerprint;
+   stored.params.swap(entry.params);
+   stored.size = entry.size;
+   stored.lru = entry.lru;
+}
+
+// Payload files hold the header, key name and fingerprint, then the parameters
+//   sizes are stored as 32 bits integers, strings and arrays are prefixed with their length
+//   values are stored as in memory, payloads are only valid for the architecture that wrote them
+
+static void WriteBytes(std::string &out, const void *data, size_t len)
+{
+   out.append((const char*) data, len);
+}
+
+static void WriteUInt(std::string &out, size_t value)
+{
+   AtUInt32 v = (AtUInt32) value;
+   WriteBytes(out, &v, sizeof(v));
+}
+
+static void WriteString(std::string &out, const std::string &str)
+{
+   WriteUInt(out, str.length());
+   WriteBytes(out, str.c_str(), str.length());
+}
+
+struct CPayloadReader
+{
+   const char *cur;
+   const char *end;
+   
+   bool read(void *data, size_t len)
+   {
+      if ((size_t) (end - cur) < len)
+      {
+         return false;
+      }
+      memcpy(data, cur, len);
+      cur += len;
+      return true;
+   }
+   
+   bool readUInt(size_t &value)
+   {
+      AtUInt32 v = 0;
+      if (!read(&v, sizeof(v)))
+      {
+         return false;
+      }
+      value = (size_t) v;
+      return true;
+   }
+   
+   bool readString(std::string &str)
+   {
+      size_t len = 0;
+      if (!readUInt(len) || (size_t) (end - cur) < len)
+      {
+         return false;
+      }
+      str.assign(cur, len);
+      cur += len;
+      return true;
+   }
+};
+
+static std::string GetPayloadName(const CReplayKey &key)
+{
+   return HashToString(key.fingerprint) + ".export.cache";
+}
+
+static void WritePayload(const CReplayKey &key, const std::vector<CReplayParam> &params)
+{
+   std::string out;
+   
+   out = gPayloadHeader;
+   WriteString(out, key.name);
+   WriteBytes(out, &key.fingerprint, sizeof(key.fingerprint));
+   WriteUInt(out, params.size());
+   
+   for (size_t i=0; i<params.size(); ++i)
+   {
+      const CReplayParam &param = params[i];
+      
+      WriteString(out, param.name);
+      WriteString(out, param.decl);
+      WriteUInt(out, param.type);
+      
+      switch (param.type)
+      {
+      case AI_TYPE_MATRIX:
+         WriteBytes(out, param.matrix, sizeof(AtMatrix));
+         break;
+      case AI_TYPE_STRING:
+      case AI_TYPE_NODE:
+         WriteString(out, param.str);
+         break;
+      case AI_TYPE_ARRAY:
+         {
+            const AtArray *array = param.value.ARRAY;
+            size_t count = (size_t) array->nelements * array->nkeys;
+            
+            WriteUInt(out, array->type);
+            WriteUInt(out, array->nelements);
+            WriteUInt(out, array->nkeys);
+            
+            if (array->type == AI_TYPE_STRING)
+            {
+               for (size_t j=0; j<count; ++j)
+               {
+                  const char *str = AiArrayGetStr(array, (AtUInt32) j);
+                  WriteString(out, (str ? str : ""));
+               }
+            }
+            else
+            {
+               WriteBytes(out, array->data, count * AiParamGetTypeSize(array->type));
+            }
+         }
+         break;
+      default:
+         WriteBytes(out, &param.value, sizeof(AtParamValue));
+         break;
+      }
+   }
+   
+   if (!WriteCacheData(GetPayloadName(key), out))
+   {
+      AiMsgWarning("[mtoa.scriptedTranslators] Could not write export cache for node \"%s\".", key.name.c_str());
+   }
+}
+
+static bool ReadPayloadParam(CPayloadReader &reader, CReplayParam &param, size_t &size)
+{
+   size_t type = 0;
+   
+   if (!reader.readString(param.name) || !reader.readString(param.decl) || !reader.readUInt(type))
+   {
+      return false;
+   }
+   
+   param.type = (int) type;
+   
+   size += sizeof(CReplayParam) + param.name.length() + param.decl.length();
+   
+   switch (param.type)
+   {
+   case AI_TYPE_MATRIX:
+      return reader.read(param.matrix, sizeof(AtMatrix));
+   case AI_TYPE_STRING:
+   case AI_TYPE_NODE:
+      if (!reader.readString(param.str))
+      {
+         return false;
+      }
+      size += param.str.length();
+      return true;
+   case AI_TYPE_ARRAY:
+      {
+         size_t arrayType = 0, nelements = 0, nkeys = 0;
+         
+         if (!reader.readUInt(arrayType) || !reader.readUInt(nelements) || !reader.readUInt(nkeys) ||
+             arrayType == AI_TYPE_NODE || arrayType == AI_TYPE_POINTER || arrayType == AI_TYPE_ARRAY)
+         {
+            return false;
+         }
+         
+         size_t elementSize = (size_t) AiParamGetTypeSize((AtByte) arrayType);
+         // Strings take at least their length word
+         size_t minElementSize = (arrayType == AI_TYPE_STRING ? sizeof(AtUInt32) : elementSize);
+         size_t remaining = (size_t) (reader.end - reader.cur);
+         
+         // Check the payload length before allocating anything, without overflowing nelements * nkeys * size
+         if (elementSize == 0 || nkeys == 0 || nkeys > 255 || nelements > remaining / minElementSize / nkeys)
+         {
+            return false;
+         }
+         
+         size_t count = nelements * nkeys;
+         
+         AtArray *array = AiArrayAllocate((AtUInt32) nelements, (AtByte) nkeys, (int) arrayType);
+         
+         if (arrayType == AI_TYPE_STRING)
+         {
+            std::string str;
+            
+            for (size_t i=0; i<count; ++i)
+            {
+               if (!reader.readString(str))
+               {
+                  AiArrayDestroy(array);
+                  return false;
+               }
+               AiArraySetStr(array, (AtUInt32) i, str.c_str());
+            }
+         }
+         else
+         {
+            reader.read(array->data, count * elementSize);
+         }
+         
+         param.value.ARRAY = array;
+         size += count * elementSize;
+      }
+      return true;
+   default:
+      return reader.read(&param.value, sizeof(AtParamValue));
+   }
+}
+
+// One mapped read of the payload, parameters are copied out of it
+static bool ReadPayload(const CReplayKey &key, CReplayEntry &entry)
+{
+   CMappedFile file;
+   
+   if (!file.open(GetPayloadName(key)))
+   {
+      return false;
+   }
+   
+   size_t headerLen = strlen(gPayloadHeader);
+   
+   if (file.size() < headerLen || memcmp(file.data(), gPayloadHeader, headerLen) != 0)
+   {
+      return false;
+   }
+   
+   CPayloadReader reader;
+   std::string name;
+   unsigned long long fingerprint = 0;
+   size_t count = 0;
+   
+   reader.cur = file.data() + headerLen;
+   reader.end = file.data() + file.size();
+   
+   // Guard against hash collisions
+   if (!reader.readString(name) || name != key.name || !reader.read(&fingerprint, sizeof(fingerprint)) ||
+       fingerprint != key.fingerprint || !reader.readUInt(count))
+   {
+      return false;
+   }
+   
+   entry.fingerprint = key.fingerprint;
+   entry.size = sizeof(CReplayEntry) + 2 * key.name.length();
+   entry.params.clear();
+   entry.params.reserve(count);
+   
+   for (size_t i=0; i<count; ++i)
+   {
+      CReplayParam param;
+      
+      memset(&param.value, 0, sizeof(AtParamValue));
+      
+      if (!ReadPayloadParam(reader, param, entry.size))
+      {
+         ReleaseParams(entry.params);
+         return false;
+      }
+      
+      entry.params.push_back(param);
+   }
+   
+   return true;
+}
+
+bool ReplayExport(const CReplayKey &key, AtNode *node, std::vector<std::string> &attrs)
+{
+   if (!node)
+   {
+      return false;
+   }
+   
+   CReplayCache::iterator it = gReplayCache.find(key.name);
+   
+   if (it != gReplayCache.end() && it->second.fingerprint == key.fingerprint)
+   {
+      if (!ApplyParams(node, it->second.params, attrs))
+      {
+         return false;
+      }
+      
+      gReplayLRU.splice(gReplayLRU.begin(), gReplayLRU, it->second.lru);
+      
+      return true;
+   }
+   
+   CReplayEntry entry;
+   
+   if (!IsReplayDiskEnabled() || !ReadPayload(key, entry))
+   {
+      return false;
+   }
+   
+   bool applied = ApplyParams(node, entry.params, attrs);
+   
+   if (applied && GetBudget() > 0)
+   {
+      if (it != gReplayCache.end())
+      {
+         RemoveEntry(it);
+      }
+      StoreEntry(key.name, entry);
+   }
+   else
+   {
+      ReleaseParams(entry.params);
+   }
+   
+   return applied;
+}
+
+void RecordExport(const CReplayKey &key, AtNode *node, const std::vector<std::string> &attrs)
+{
+   CReplayCache::iterator it = gReplayCache.find(key.name);
+   
+   if (it != gReplayCache.end())
+   {
+      RemoveEntry(it);
+   }
+   
+   if (!node)
+   {
+      return;
+   }
+   
+   CReplayEntry entry;
+   
+   entry.fingerprint = key.fingerprint;
+   entry.size = sizeof(CReplayEntry) + 2 * key.name.length();
+   entry.params.reserve(attrs.size());
+   
+   for (size_t i=0; i<attrs.size(); ++i)
+   {
+      CReplayParam param;
+      
+      param.name = attrs[i];
+      param.type = AI_TYPE_UNDEFINED;
+      memset(&param.value, 0, sizeof(AtParamValue));
+      
+      if (!ReadParam(node, param, entry.size))
+      {
+         // Parameters not declared on the node are ignored, anything else can't be replayed
+         if (param.type == AI_TYPE_UNDEFINED)
+         {
+            continue;
+         }
+         ReleaseParams(entry.params);
+         return;
+      }
+      
+      entry.params.push_back(param);
+   }
+   
+   if (IsReplayDiskEnabled())
+   {
+      WritePayload(key, entry.params);
+   }
+   
+   if (GetBudget() > 0)
+   {
+      StoreEntry(key.name, entry);
+   }
+   else
+   {
+      ReleaseParams(entry.params);
+   }
+}
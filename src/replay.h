@@ -0,0 +1,51 @@
+#ifndef __replay_h__
+#define __replay_h__
+
+#include "common.h"
+#include <ai.h>
+#include <maya/MObject.h>
+#include <maya/MDagPath.h>
+#include <maya/MString.h>
+#include <string>
+#include <vector>
+
+struct CScriptedTranslator;
+
+// Reuse of export script results across frames for nodes whose inputs don't change (sequence renders)
+//   enabled by setting MTOA_SCRIPTED_TRANSLATORS_REPLAY to the cache memory budget in megabytes
+//   the parameters set by the export script are recorded and set again instead of calling it
+//   when the node fingerprint matches the one of its last export, least recently used nodes are evicted first
+//   with MTOA_SCRIPTED_TRANSLATORS_REPLAY_DISK set, the parameters are also saved in the MTOA_SCRIPTED_TRANSLATORS_CACHE directory
+//   under the fingerprint so that other processes (render farm frames) can map them instead of calling the export script
+//   only the export script parameters are recorded, the common shape attributes (render flags, shading, links, bounds)
+//   are still evaluated every export as they depend on assignments the fingerprint doesn't cover
+//
+// Only modules declaring the SupportReplay capability are replayed, their export script result must not depend
+//   on anything but the node inputs (no frame, other nodes or files)
+// The fingerprint combines the translator module key, the scene file, the current render layer, the node name
+//   and the types, attribute values (and referenced files size and time) and incoming connections of the node,
+//   its upstream nodes and, for DAG nodes, its parent transforms and their upstream nodes
+//   nodes with time dependent upstream connections (or parents) are never replayed
+// Each node hash is computed once per frame and render layer
+
+struct CReplayKey
+{
+   // Render layer and node name
+   std::string name;
+   unsigned long long fingerprint;
+};
+
+bool IsReplayEnabled();
+
+// Returns false if the node export can't be replayed, dagPath is invalid for non DAG nodes
+bool GetReplayKey(const CScriptedTranslator &translator, const MObject &node, const MDagPath &dagPath, const MString &nodeName, CReplayKey &key);
+
+// Sets the parameters recorded for key on node, attrs receives their names
+bool ReplayExport(const CReplayKey &key, AtNode *node, std::vector<std::string> &attrs);
+
+// Records the parameters in attrs, nothing is recorded if any can't be replayed (links, pointers)
+void RecordExport(const CReplayKey &key, AtNode *node, const std::vector<std::string> &attrs);
+
+void ClearReplayCache();
+
+#endif
@@ -0,0 +1,280 @@
+#include "shadingengine.h"
+#include <maya/MFnDependencyNode.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MGlobal.h>
+#include <maya/MDGMessage.h>
+#include <maya/MSceneMessage.h>
+#include <maya/MStringArray.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct CShadingEngineEntry
+{
+   MObjectHandle shape;
+   MObjectHandle shadingEngine;
+};
+
+typedef std::pair<unsigned int, unsigned int> CShadingEngineKey;
+typedef std::map<CShadingEngineKey, CShadingEngineEntry> CShadingEngineCache;
+
+static CShadingEngineCache gShadingEngines;
+static MCallbackId gConnectionCallbackId = 0;
+static MCallbackId gBeforeNewCallbackId = 0;
+static MCallbackId gBeforeOpenCallbackId = 0;
+
+// Whether or not node types are classified as arnold surface shaders
+static std::map<std::string, bool> gSurfaceShaderTypes;
+static MCallbackId gPluginLoadCallbackId = 0;
+static MCallbackId gPluginUnloadCallbackId = 0;
+
+
+static void ConnectionChangedCallback(MPlug &, MPlug &, bool, void *)
+{
+   gShadingEngines.clear();
+}
+
+static void SceneChangedCallback(void *)
+{
+   gShadingEngines.clear();
+}
+
+static void PluginChangedCallback(const MStringArray &, void *)
+{
+   // Plugins may register or remove node types
+   gSurfaceShaderTypes.clear();
+}
+
+static bool IsSurfaceShaderType(const MString &typeName)
+{
+   std::map<std::string, bool>::iterator it = gSurfaceShaderTypes.find(typeName.asChar());
+   
+   if (it != gSurfaceShaderTypes.end())
+   {
+      return it->second;
+   }
+   
+   bool rv = (MFnDependencyNode::classification(typeName).indexW("arnold/shader/surface") != -1);
+   
+   gSurfaceShaderTypes[typeName.asChar()] = rv;
+   
+   return rv;
+}
+
+static void AddShadingEngineCacheCallbacks()
+{
+   MStatus status;
+   
+   if (gConnectionCallbackId == 0)
+   {
+      gConnectionCallbackId = MDGMessage::addConnectionCallback(ConnectionChangedCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         gConnectionCallbackId = 0;
+      }
+   }
+   if (gBeforeNewCallbackId == 0)
+   {
+      gBeforeNewCallbackId = MSceneMessage::addCallback(MSceneMessage::kBeforeNew, SceneChangedCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         gBeforeNewCallbackId = 0;
+      }
+   }
+   if (gBeforeOpenCallbackId == 0)
+   {
+      gBeforeOpenCallbackId = MSceneMessage::addCallback(MSceneMessage::kBeforeOpen, SceneChangedCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         gBeforeOpenCallbackId = 0;
+      }
+   }
+   if (gPluginLoadCallbackId == 0)
+   {
+      gPluginLoadCallbackId = MSceneMessage::addStringArrayCallback(MSceneMessage::kAfterPluginLoad, PluginChangedCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         gPluginLoadCallbackId = 0;
+      }
+   }
+   if (gPluginUnloadCallbackId == 0)
+   {
+      gPluginUnloadCallbackId = MSceneMessage::addStringArrayCallback(MSceneMessage::kAfterPluginUnload, PluginChangedCallback, NULL, &status);
+      if (status != MS::kSuccess)
+      {
+         gPluginUnloadCallbackId = 0;
+      }
+   }
+}
+
+void RemoveShadingEngineCacheCallbacks()
+{
+   if (gConnectionCallbackId != 0)
+   {
+      MMessage::removeCallback(gConnectionCallbackId);
+      gConnectionCallbackId = 0;
+   }
+   if (gBeforeNewCallbackId != 0)
+   {
+      MMessage::removeCallback(gBeforeNewCallbackId);
+      gBeforeNewCallbackId = 0;
+   }
+   if (gBeforeOpenCallbackId != 0)
+   {
+      MMessage::removeCallback(gBeforeOpenCallbackId);
+      gBeforeOpenCallbackId = 0;
+   }
+   if (gPluginLoadCallbackId != 0)
+   {
+      MMessage::removeCallback(gPluginLoadCallbackId);
+      gPluginLoadCallbackId = 0;
+   }
+   if (gPluginUnloadCallbackId != 0)
+   {
+      MMessage::removeCallback(gPluginUnloadCallbackId);
+      gPluginUnloadCallbackId = 0;
+   }
+   
+   gShadingEngines.clear();
+   gSurfaceShaderTypes.clear();
+}
+
+bool GetCachedShadingEngine(const MObject &shape, unsigned int instance, MObject &shadingEngine)
+{
+   MObjectHandle handle(shape);
+   
+   CShadingEngineCache::iterator it = gShadingEngines.find(CShadingEngineKey(handle.hashCode(), instance));
+   
+   // Hash codes are not unique, check entry is for that very shape
+   if (it == gShadingEngines.end() || !it->second.shape.isAlive() || !(it->second.shape == shape))
+   {
+      return false;
+   }
+   
+   if (it->second.shadingEngine.isValid())
+   {
+      shadingEngine = it->second.shadingEngine.object();
+   }
+   else
+   {
+      shadingEngine = MObject::kNullObj;
+   }
+   
+   return true;
+}
+
+void CacheShadingEngine(const MObject &shape, unsigned int instance, const MObject &shadingEngine)
+{
+   AddShadingEngineCacheCallbacks();
+   
+   MObjectHandle handle(shape);
+   
+   CShadingEngineEntry &entry = gShadingEngines[CShadingEngineKey(handle.hashCode(), instance)];
+   
+   entry.shape = handle;
+   entry.shadingEngine = (shadingEngine.isNull() ? MObjectHandle() : MObjectHandle(shadingEngine));
+}
+
+MObject FindShadingEngine(const MDagPath &dagPath)
+{
+   MFnDependencyNode shapeNode(dagPath.node());
+   MPlugArray plugs;
+   MPlugArray srcs;
+   
+   // (shape plug, shading engine) pairs
+   std::vector<std::pair<MPlug, MObject> > connections;
+   
+   // Node types classification is remembered
+   AddShadingEngineCacheCallbacks();
+   
+   shapeNode.getConnections(plugs);
+   
+   // Check connection from any shadingEngine on shape
+   for (unsigned int i=0; i<plugs.length(); ++i)
+   {
+      plugs[i].connectedTo(srcs, true, false);
+      
+      for (unsigned int j=0; j<srcs.length(); ++j)
+      {
+         MObject srcNode = srcs[j].node();
+         
+         if (srcNode.apiType() == MFn::kShadingEngine)
+         {
+            connections.push_back(std::make_pair(plugs[i], srcNode));
+         }
+      }
+   }
+   
+   if (connections.size() == 0)
+   {
+      // Check for direct surface shader connection
+      for (unsigned int i=0; i<plugs.length(); ++i)
+      {
+         plugs[i].connectedTo(srcs, true, false);
+         
+         for (unsigned int j=0; j<srcs.length(); ++j)
+         {
+            MFnDependencyNode srcNode(srcs[j].node());
+            
+            // Get node classification, if can find arnold/shader/surface -> got it
+            if (!IsSurfaceShaderType(srcNode.typeName()))
+            {
+               continue;
+            }
+            
+            MObject shadingEngine;
+            MPlugArray srcPlugs;
+            MPlugArray dsts;
+            unsigned int count = 0;
+            
+            srcNode.getConnections(srcPlugs);
+            
+            for (unsigned int k=0; k<srcPlugs.length(); ++k)
+            {
+               srcPlugs[k].connectedTo(dsts, false, true);
+               
+               for (unsigned int l=0; l<dsts.length(); ++l)
+               {
+                  MObject dstNode = dsts[l].node();
+                  
+                  if (dstNode.apiType() == MFn::kShadingEngine)
+                  {
+                     shadingEngine = dstNode;
+                     ++count;
+                  }
+               }
+            }
+            
+            return (count == 1 ? shadingEngine : MObject::kNullObj);
+         }
+      }
+      
+      return MObject::kNullObj;
+   }
+   else if (connections.size() == 1)
+   {
+      // Single connection, use same shader for all instances
+      return connections[0].second;
+   }
+   else
+   {
+      // Many connections, expects the destination plug in shape to be an array
+      // Use instance number as logical index, if this fails, use first shadingEngine in list
+      unsigned int instance = dagPath.instanceNumber();
+      
+      for (size_t i=0; i<connections.size(); ++i)
+      {
+         if (connections[i].first.isElement() && connections[i].first.logicalIndex() == instance)
+         {
+            return connections[i].second;
+         }
+      }
+      
+      MGlobal::displayWarning("[mtoaScriptedTranslators] Instance shader plug not found, use first found shadingEngine \"" +
+                              MFnDependencyNode(connections[0].second).name() + "\"");
+      
+      return connections[0].second;
+   }
+}
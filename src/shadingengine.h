@@ -0,0 +1,19 @@
+#ifndef __shadingengine_h__
+#define __shadingengine_h__
+
+#include <maya/MObject.h>
+#include <maya/MDagPath.h>
+
+// Look up shading engine from shape connections
+//   1/ shadingEngine connected to shape (if many, use the one connected to the plug matching instance number)
+//   2/ shadingEngine of an arnold surface shader directly connected to shape
+MObject FindShadingEngine(const MDagPath &dagPath);
+
+// Shading engines resolved for shape instances
+// Cache is cleared whenever a connection changes or a new scene is created/opened
+// Node types classification is also remembered until a plugin is loaded or unloaded
+bool GetCachedShadingEngine(const MObject &shape, unsigned int instance, MObject &shadingEngine);
+void CacheShadingEngine(const MObject &shape, unsigned int instance, const MObject &shadingEngine);
+void RemoveShadingEngineCacheCallbacks();
+
+#endif
@@ -1,9 +1,21 @@
 #include "shapetranslator.h"
 #include "plugin.h"
+#include "shadingengine.h"
+#include "stats.h"
+#include "replay.h"
 
 #include <maya/MBoundingBox.h>
-#include <maya/MSelectionList.h>
 #include <maya/MMatrix.h>
+#include <maya/MDGContext.h>
+#if MAYA_API_VERSION >= 20180000
+#  include <maya/MDGContextGuard.h>
+#endif
+#include <maya/MTime.h>
+#include <maya/MFnMatrixData.h>
+#include <maya/MFnAttribute.h>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
 
 
 void* CScriptedShapeTranslator::creator()
@@ -12,12 +24,16 @@ void* CScriptedShapeTranslator::creator()
 }
 
 CScriptedShapeTranslator::CScriptedShapeTranslator()
-   : CShapeTranslator(), m_motionBlur(false), m_masterNode(0)
+   : CShapeTranslator(), m_translator(0), m_motionBlur(false), m_masterNode(0), m_instance(false)
+   , m_transformDirty(false), m_shapeDirty(false), m_transformUpdate(false), m_replayed(false), m_commonNode(0)
 {
+   AddStatsTranslator();
 }
 
 CScriptedShapeTranslator::~CScriptedShapeTranslator()
 {
+   RemoveBatchEntry(&m_batchEntry);
+   RemoveStatsTranslator();
 }
 
 #ifdef OLD_API
@@ -26,6 +42,8 @@ AtNode* CScriptedShapeTranslator::Init(CArnoldSession *session, MDagPath& dagPat
 {
    AtNode *rv = CShapeTranslator::Init(session, dagPath, outputAttr);
    m_motionBlur = (IsMotionBlurEnabled(MTOA_MBLUR_DEFORM|MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled());
+   m_batchEntry.numSteps = (m_motionBlur ? GetNumMotionSteps() : 1);
+   ResolveTranslator();
    return rv;
 }
 
@@ -33,6 +51,8 @@ AtNode* CScriptedShapeTranslator::Init(CArnoldSession* session, MObject& object,
 {
    AtNode *rv = CDagTranslator::Init(session, object, outputAttr);
    m_motionBlur = (IsMotionBlurEnabled(MTOA_MBLUR_DEFORM|MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled());
+   m_batchEntry.numSteps = (m_motionBlur ? GetNumMotionSteps() : 1);
+   ResolveTranslator();
    return rv;
 }
 
@@ -66,6 +86,8 @@ void CScriptedShapeTranslator::Init()
 {
    CShapeTranslator::Init();
    m_motionBlur = (IsMotionBlurEnabled(MTOA_MBLUR_DEFORM|MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled());
+   m_batchEntry.numSteps = (m_motionBlur ? GetNumMotionSteps() : 1);
+   ResolveTranslator();
 }
 
 void CScriptedShapeTranslator::Export(AtNode *atNode)
@@ -78,30 +100,111 @@ void CScriptedShapeTranslator::ExportMotion(AtNode *atNode)
    RunScripts(atNode, GetMotionStep(), IsExported());
 }
 
+// Parameters are updated in place, the arnold node is only recreated when its type or master node changes
+//   (volume step size crossing 0, instancing changes)
 void CScriptedShapeTranslator::RequestUpdate()
 {
-   SetUpdateMode(AI_RECREATE_NODE);
+   AtNode *atNode = GetArnoldNode();
+   bool recreate = true;
+   
+   if (atNode && ResolveTranslator())
+   {
+      PreparePlugs();
+      
+      AtNode *masterNode = FindMasterNode();
+      
+      recreate = (masterNode != m_masterNode || !AiNodeIs(atNode, GetArnoldNodeType(masterNode)));
+   }
+   
+   SetUpdateMode(recreate ? AI_RECREATE_NODE : AI_UPDATE_ONLY);
    CShapeTranslator::RequestUpdate();
 }
 
-#endif
+// Attributes of the parent transforms only affecting the shape world matrix
+static const char* gTransformAttrs[] =
+{
+   "translate",
+   "rotate",
+   "scale",
+   "shear",
+   "matrix",
+   "worldMatrix",
+   "xformMatrix",
+   "offsetParentMatrix",
+   "inheritsTransform",
+   NULL
+};
 
-AtNode* CScriptedShapeTranslator::CreateArnoldNodes()
+void CScriptedShapeTranslator::NodeChanged(MObject &node, MPlug &plug)
 {
-   std::map<std::string, CScriptedTranslator>::iterator translatorIt;
-   MFnDependencyNode fnNode(GetMayaObject());
+   bool transformOnly = false;
    
-   translatorIt = gTranslators.find(fnNode.typeName().asChar());
-   if (translatorIt == gTranslators.end())
+   if (node != m_dagPath.node() && node.hasFn(MFn::kTransform) && !plug.isNull())
    {
-      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
-      return NULL;
+      MString name = MFnAttribute(plug.attribute()).name();
+      
+      for (int i=0; gTransformAttrs[i] && !transformOnly; ++i)
+      {
+         // Prefix match (translateX, rotatePivot, scalePivotTranslate, ...)
+         transformOnly = (strncmp(name.asChar(), gTransformAttrs[i], strlen(gTransformAttrs[i])) == 0);
+      }
    }
    
-   float step = FindMayaPlug("aiStepSize").asFloat();
-   bool asVolume =  (step > AI_EPSILON);
+   if (transformOnly)
+   {
+      m_transformDirty = true;
+   }
+   else
+   {
+      m_shapeDirty = true;
+   }
+   
+   CShapeTranslator::NodeChanged(node, plug);
+}
+
+#endif
+
+bool CScriptedShapeTranslator::ResolveTranslator()
+{
+   if (!m_translator)
+   {
+      MFnDependencyNode fnNode(GetMayaObject());
+      
+      m_translator = FindTranslator(fnNode.typeName().asChar());
+      if (!m_translator)
+      {
+         AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
+         return false;
+      }
+      if (!LoadTranslator(*m_translator))
+      {
+         m_translator = NULL;
+         return false;
+      }
+   }
+   return true;
+}
+
+void CScriptedShapeTranslator::PreparePlugs()
+{
+   CPlugPlan &plugs = m_translator->plugs;
    
-   m_masterNode = 0;
+   if (!plugs.isBuilt())
+   {
+      plugs.build(MFnDependencyNode(m_dagPath.node()).typeName());
+   }
+   
+   m_plugs.prepare(plugs, m_dagPath.node());
+}
+
+MPlug CScriptedShapeTranslator::FindPlug(PlugId id)
+{
+   return m_plugs.plug(id);
+}
+
+AtNode* CScriptedShapeTranslator::FindMasterNode()
+{
+   AtNode *masterNode = 0;
    
    if (!IsMasterInstance())
    {
@@ -112,8 +215,8 @@ AtNode* CScriptedShapeTranslator::CreateArnoldNodes()
       unsigned int n = m_session->GetActiveTranslators(handle, translators);
       for (unsigned int i=0; i<n; ++i)
       {
-         m_masterNode = translators[i]->GetArnoldRootNode();
-         if (m_masterNode)
+         masterNode = translators[i]->GetArnoldRootNode();
+         if (masterNode)
          {
             break;
          }
@@ -122,33 +225,74 @@ AtNode* CScriptedShapeTranslator::CreateArnoldNodes()
       CNodeTranslator *trsl = CNodeTranslator::GetTranslator(masterPath);
       if (trsl)
       {
-         m_masterNode = trsl->GetArnoldNode();
+         masterNode = trsl->GetArnoldNode();
       }
 #endif
    }
    
-   if (!m_masterNode)
+   return masterNode;
+}
+
+const char* CScriptedShapeTranslator::GetArnoldNodeType(AtNode *masterNode)
+{
+   float step = FindPlug(PLUG_VOLUME_STEP_SIZE).asFloat();
+   bool asVolume =  (step > AI_EPSILON);
+   
+   const char *arnoldNodeType = "procedural";
+   
+   if (!masterNode)
    {
-      if (asVolume && !translatorIt->second.supportVolumes)
-      {
-         return AddArnoldNode("box");
-      }
-      else
+      if (asVolume && !m_translator->supportVolumes)
       {
-         return AddArnoldNode("procedural");
+         arnoldNodeType = "box";
       }
    }
    else
    {
-      if (asVolume && !translatorIt->second.supportVolumes)
+      if (asVolume && !m_translator->supportVolumes)
       {
-         return AddArnoldNode("ginstance");
+         arnoldNodeType = "ginstance";
       }
-      else
+      else if (m_translator->supportInstances)
       {
-         return AddArnoldNode(translatorIt->second.supportInstances ? "ginstance" : "procedural");
+         arnoldNodeType = "ginstance";
       }
    }
+   
+   return arnoldNodeType;
+}
+
+AtNode* CScriptedShapeTranslator::CreateArnoldNodes()
+{
+   // With the old API, nodes are created from within the base class Init
+   if (!ResolveTranslator())
+   {
+      return NULL;
+   }
+   
+   PreparePlugs();
+   
+   m_masterNode = FindMasterNode();
+   
+   const char *arnoldNodeType = GetArnoldNodeType(m_masterNode);
+   
+   m_batchEntry.dagPath = m_dagPath;
+   m_batchEntry.masterDagPath = (m_masterNode ? GetMasterInstance() : MDagPath());
+   m_batchEntry.masterNode = m_masterNode;
+   m_batchEntry.node = AddArnoldNode(arnoldNodeType);
+   
+   // Instances exported as ginstance by modules opting in don't go through Export nor take part in batched exports
+   m_instance = (m_translator->fastInstances && m_masterNode != 0 && !strcmp(arnoldNodeType, "ginstance"));
+   if (m_instance)
+   {
+      RemoveBatchEntry(&m_batchEntry);
+   }
+   else
+   {
+      AddBatchEntry(*m_translator, &m_batchEntry);
+   }
+   
+   return m_batchEntry.node;
 }
 
 // Get shading engine
@@ -158,193 +302,693 @@ void CScriptedShapeTranslator::GetShapeInstanceShader(MDagPath& dagPath, MFnDepe
    // Get instance shadingEngine
    shadingEngineNode.setObject(MObject::kNullObj);
    
+   MObject shape = dagPath.node();
+   unsigned int instance = (dagPath.isInstanced() ? dagPath.instanceNumber() : 0);
+   MObject shadingEngineObj;
+   
+   // Master and secondary instances all resolve the same shapes
+   if (GetCachedShadingEngine(shape, instance, shadingEngineObj))
+   {
+      if (!shadingEngineObj.isNull())
+      {
+         shadingEngineNode.setObject(shadingEngineObj);
+      }
+      return;
+   }
+   
    // First try the usual way
-   MPlug shadingGroupPlug = GetNodeShadingGroup(dagPath.node(), (dagPath.isInstanced() ? dagPath.instanceNumber() : 0));
+   MPlug shadingGroupPlug = GetNodeShadingGroup(shape, instance);
    if (!shadingGroupPlug.isNull())
    {
-      shadingEngineNode.setObject(shadingGroupPlug.node());
+      shadingEngineObj = shadingGroupPlug.node();
+   }
+   else
+   {
+      shadingEngineObj = FindShadingEngine(dagPath);
+   }
+   
+   CacheShadingEngine(shape, instance, shadingEngineObj);
+   
+   if (!shadingEngineObj.isNull())
+   {
+      shadingEngineNode.setObject(shadingEngineObj);
+   }
+}
+
+bool CScriptedShapeTranslator::RequiresMotionData()
+{
+   return m_motionBlur;
+}
+
+// Evaluate shape world matrix at the given frame
+bool CScriptedShapeTranslator::GetWorldMatrix(double frame, AtMatrix &matrix)
+{
+   MPlug plug = FindPlug(PLUG_WORLD_MATRIX);
+   
+   if (plug.isNull())
+   {
+      return false;
+   }
+   
+   plug = plug.elementByLogicalIndex(m_dagPath.instanceNumber());
+   
+   MDGContext ctx(MTime(frame, MTime::uiUnit()));
+   MObject data;
+   MStatus status;
+
+#if MAYA_API_VERSION >= 20180000
+   // Context aware plug getters are deprecated, evaluate within a scoped context instead
+   {
+      MDGContextGuard guard(ctx);
+      data = plug.asMObject(&status);
+   }
+#else
+   status = plug.getValue(data, ctx);
+#endif
+   
+   if (status != MS::kSuccess || data.isNull())
+   {
+      return false;
+   }
+   
+   MFnMatrixData matrixData(data);
+   MMatrix mmatrix = matrixData.matrix(&status);
+   
+   if (status != MS::kSuccess)
+   {
+      return false;
+   }
+   
+   ConvertMatrix(matrix, mmatrix);
+   
+   return true;
+}
+
+void CScriptedShapeTranslator::ExportMatrix(AtNode *atNode, unsigned int step)
+{
+   bool transformBlur = IsMotionBlurEnabled(MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled();
+   
+   AtMatrix matrix;
+   MMatrix mmatrix = m_dagPath.inclusiveMatrix();
+   ConvertMatrix(matrix, mmatrix);
+   
+   // Set transformation matrix
+   if (!m_overrides.has(PARAM_MATRIX))
+   {
+      if (m_params.builtin(PARAM_MATRIX))
+      {
+         if (transformBlur && m_translator->prefetchMotionMatrices)
+         {
+            // All steps are evaluated at once on first step
+            if (IsFirstStep(step))
+            {
+               unsigned int nsteps = GetNumMotionSteps();
+               AtArray* matrices = AiArrayAllocate(1, nsteps, AI_TYPE_MATRIX);
+               
+               for (unsigned int i=0; i<nsteps; ++i)
+               {
+                  AtMatrix smatrix;
+                  
+                  if (!GetWorldMatrix(GetStepFrame(i), smatrix))
+                  {
+                     AiM4Copy(smatrix, matrix);
+                  }
+                  AiArraySetMtx(matrices, i, smatrix);
+               }
+               
+               AiNodeSetArray(atNode, "matrix", matrices);
+            }
+         }
+         else if (transformBlur)
+         {
+            if (step == 0)
+            {
+               AtArray* matrices = AiArrayAllocate(1, GetNumMotionSteps(), AI_TYPE_MATRIX);
+               AiArraySetMtx(matrices, step, matrix);
+               AiNodeSetArray(atNode, "matrix", matrices);
+            }
+            else
+            {
+               AtArray* matrices = AiNodeGetArray(atNode, "matrix");
+               AiArraySetMtx(matrices, step, matrix);
+            }
+         }
+         else
+         {
+            AiNodeSetMatrix(atNode, "matrix", matrix);
+         }
+      }
+   }
+}
+
+void CScriptedShapeTranslator::ExportRenderFlags(AtNode *atNode)
+{
+   MPlug plug;
+   
+   if (!m_overrides.has(PARAM_SIDEDNESS))
+   {
+      // Use maya shape built-in attribute
+      plug = FindPlug(PLUG_DOUBLE_SIDED);
+      if (!plug.isNull() && m_params.has(PARAM_SIDEDNESS))
+      {
+         AiNodeSetByte(atNode, "sidedness", plug.asBool() ? AI_RAY_ALL : 0);
+         
+         // Only set invert_normals if doubleSided attribute could be found
+         if (!plug.asBool() && !m_overrides.has(PARAM_INVERT_NORMALS))
+         {
+            // Use maya shape built-in attribute
+            plug = FindPlug(PLUG_OPPOSITE);
+            if (!plug.isNull() && m_params.has(PARAM_INVERT_NORMALS))
+            {
+               AiNodeSetBool(atNode, "invert_normals", plug.asBool());
+               m_commonAttrs.push_back("invert_normals");
+            }
+         }
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_RECEIVE_SHADOWS))
+   {
+      // Use maya shape built-in attribute
+      plug = FindPlug(PLUG_RECEIVE_SHADOWS);
+      if (!plug.isNull() && m_params.has(PARAM_RECEIVE_SHADOWS))
+      {
+         AiNodeSetBool(atNode, "receive_shadows", plug.asBool());
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_SELF_SHADOWS))
+   {
+      plug = FindPlug(PLUG_SELF_SHADOWS);
+      if (!plug.isNull() && m_params.has(PARAM_SELF_SHADOWS))
+      {
+         AiNodeSetBool(atNode, "self_shadows", plug.asBool());
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_OPAQUE))
+   {
+      plug = FindPlug(PLUG_OPAQUE);
+      if (!plug.isNull() && m_params.has(PARAM_OPAQUE))
+      {
+         AiNodeSetBool(atNode, "opaque", plug.asBool());
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_MATTE))
+   {
+      plug = FindPlug(PLUG_MATTE);
+      if (!plug.isNull() && m_params.has(PARAM_MATTE))
+      {
+         AiNodeSetBool(atNode, "matte", plug.asBool());
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_VISIBILITY))
+   {
+      if (m_params.has(PARAM_VISIBILITY))
+      {
+         int visibility = AI_RAY_ALL;
+         
+         // Use maya shape built-in attribute
+         plug = FindPlug(PLUG_CASTS_SHADOWS);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_SHADOW;
+         }
+         
+         // Use maya shape built-in attribute
+         plug = FindPlug(PLUG_PRIMARY_VISIBILITY);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_CAMERA;
+         }
+         
+         // Use maya shape built-in attribute
+         plug = FindPlug(PLUG_VISIBLE_IN_REFLECTIONS);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_REFLECTED;
+         }
+         
+         // Use maya shape built-in attribute
+         plug = FindPlug(PLUG_VISIBLE_IN_REFRACTIONS);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_REFRACTED;
+         }
+         
+         plug = FindPlug(PLUG_DIFFUSE_VISIBILITY);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_DIFFUSE;
+         }
+         
+         plug = FindPlug(PLUG_GLOSSY_VISIBILITY);
+         if (!plug.isNull() && !plug.asBool())
+         {
+            visibility &= ~AI_RAY_GLOSSY;
+         }
+         
+         AiNodeSetByte(atNode, "visibility", visibility & 0xFF);
+      }
+   }
+   
+   if (!m_overrides.has(PARAM_SSS_SETNAME))
+   {
+      plug = FindPlug(PLUG_SSS_SETNAME);
+      if (!plug.isNull() && plug.asString().length() > 0)
+      {
+         if (m_params.has(PARAM_SSS_SETNAME))
+         {
+            AiNodeSetStr(atNode, "sss_setname", plug.asString().asChar());
+            m_commonAttrs.push_back("sss_setname");
+         }
+      }
+   }
+}
+
+void CScriptedShapeTranslator::ExportShader(AtNode *atNode, MFnDependencyNode &shadingEngine)
+{
+   if (!m_params.has(PARAM_SHADER))
+   {
+      return;
+   }
+   
+   if (!m_overrides.has(PARAM_SHADER))
+   {
+      if (shadingEngine.object() != MObject::kNullObj)
+      {
+#ifdef OLD_API
+         AtNode *shader = ExportNode(shadingEngine.findPlug("message"));
+#else
+         AtNode *shader = ExportConnectedNode(shadingEngine.findPlug("message"));
+#endif
+         if (shader != NULL)
+         {
+            const AtNodeEntry *entry = AiNodeGetNodeEntry(shader);
+            
+            if (AiNodeEntryGetType(entry) != AI_NODE_SHADER)
+            {
+               MGlobal::displayWarning("[mtoaScriptedTranslators] Node generated from \"" + shadingEngine.name() +
+                                       "\" of type " + shadingEngine.typeName() + " for shader is not a shader but a " +
+                                       MString(AiNodeEntryGetTypeName(entry)));
+            }
+            else
+            {
+               AiNodeSetPtr(atNode, "shader", shader);
+               
+               if (AiNodeLookUpUserParameter(atNode, "mtoa_shading_groups") == 0)
+               {
+                  AiNodeDeclare(atNode, "mtoa_shading_groups", "constant ARRAY NODE");
+               }
+               AiNodeSetArray(atNode, "mtoa_shading_groups", AiArrayConvert(1, 1, AI_TYPE_NODE, &shader));
+               
+               m_commonAttrs.push_back("shader");
+               m_commonAttrs.push_back("mtoa_shading_groups");
+            }
+         }
+      }
+   }
+}
+
+void CScriptedShapeTranslator::ExportLinks(AtNode *atNode)
+{
+   ExportLightLinking(atNode);
+   
+   MPlug plug = FindPlug(PLUG_TRACE_SETS);
+   if (!plug.isNull())
+   {
+      ExportTraceSets(atNode, plug);
+   }
+}
+
+// Common parameters set by the previous export of the same arnold node but not by this one (or set by the export script)
+//   are reset to their default value, as ResetRemovedParameters does for the export script ones
+void CScriptedShapeTranslator::ResetRemovedCommonParameters(AtNode *atNode)
+{
+   std::sort(m_commonAttrs.begin(), m_commonAttrs.end());
+   m_commonAttrs.erase(std::unique(m_commonAttrs.begin(), m_commonAttrs.end()), m_commonAttrs.end());
+   
+   if (atNode && atNode == m_commonNode)
+   {
+      std::vector<std::string> removed;
+      const AtNodeEntry *nodeEntry = AiNodeGetNodeEntry(atNode);
+      
+      std::set_difference(m_exportedCommonAttrs.begin(), m_exportedCommonAttrs.end(),
+                          m_commonAttrs.begin(), m_commonAttrs.end(),
+                          std::back_inserter(removed));
+      
+      for (size_t i=0; i<removed.size(); ++i)
+      {
+         const char *param = removed[i].c_str();
+         
+         if (!m_overrides.has(param) && (AiNodeEntryLookUpParameter(nodeEntry, param) || AiNodeLookUpUserParameter(atNode, param)))
+         {
+            AiNodeResetParameter(atNode, param);
+         }
+      }
+   }
+   
+   m_exportedCommonAttrs.swap(m_commonAttrs);
+   m_commonNode = atNode;
+}
+
+CScriptedShapeTranslator::CMotionBounds::CMotionBounds()
+   : valid(false)
+{
+   AiV3Create(min, 0.0f, 0.0f, 0.0f);
+   AiV3Create(max, 0.0f, 0.0f, 0.0f);
+}
+
+// Union of all steps bounds (padded), optionally passing per step bounds to procedural
+void CScriptedShapeTranslator::ExportBounds(AtNode *atNode, float padding)
+{
+   AtPoint cmin, cmax;
+   bool valid = false;
+   
+   for (size_t i=0; i<m_motionBounds.size(); ++i)
+   {
+      const CMotionBounds &bounds = m_motionBounds[i];
+      
+      if (!bounds.valid)
+      {
+         continue;
+      }
+      
+      if (!valid)
+      {
+         cmin = bounds.min;
+         cmax = bounds.max;
+         valid = true;
+      }
+      else
+      {
+         cmin.x = MIN(cmin.x, bounds.min.x);
+         cmin.y = MIN(cmin.y, bounds.min.y);
+         cmin.z = MIN(cmin.z, bounds.min.z);
+         cmax.x = MAX(cmax.x, bounds.max.x);
+         cmax.y = MAX(cmax.y, bounds.max.y);
+         cmax.z = MAX(cmax.z, bounds.max.z);
+      }
+   }
+   
+   if (!valid)
+   {
       return;
    }
    
-   char buffer[64];
+   AiNodeSetPnt(atNode, "min", cmin.x - padding, cmin.y - padding, cmin.z - padding);
+   AiNodeSetPnt(atNode, "max", cmax.x + padding, cmax.y + padding, cmax.z + padding);
+   
+   if (m_translator->supportMotionBounds && m_motionBounds.size() > 1)
+   {
+      unsigned int nsteps = (unsigned int) m_motionBounds.size();
+      
+      AtArray *mins = AiArrayAllocate(nsteps, 1, AI_TYPE_POINT);
+      AtArray *maxs = AiArrayAllocate(nsteps, 1, AI_TYPE_POINT);
+      
+      for (unsigned int i=0; i<nsteps; ++i)
+      {
+         const CMotionBounds &bounds = m_motionBounds[i];
+         
+         // Steps without bounds of their own use the union
+         AtPoint smin = (bounds.valid ? bounds.min : cmin);
+         AtPoint smax = (bounds.valid ? bounds.max : cmax);
+         
+         AiV3Create(smin, smin.x - padding, smin.y - padding, smin.z - padding);
+         AiV3Create(smax, smax.x + padding, smax.y + padding, smax.z + padding);
+         
+         AiArraySetPnt(mins, i, smin);
+         AiArraySetPnt(maxs, i, smax);
+      }
+      
+      if (AiNodeLookUpUserParameter(atNode, "mtoa_motion_min") == 0)
+      {
+         AiNodeDeclare(atNode, "mtoa_motion_min", "constant ARRAY POINT");
+      }
+      if (AiNodeLookUpUserParameter(atNode, "mtoa_motion_max") == 0)
+      {
+         AiNodeDeclare(atNode, "mtoa_motion_max", "constant ARRAY POINT");
+      }
+      
+      AiNodeSetArray(atNode, "mtoa_motion_min", mins);
+      AiNodeSetArray(atNode, "mtoa_motion_max", maxs);
+   }
+}
+
+double CScriptedShapeTranslator::GetStepFrame(unsigned int step)
+{
+#ifdef OLD_API
+   return GetSampleFrame(m_session, step);
+#else
+   unsigned int nsteps = 0;
+   const double *mframes = GetMotionFrames(nsteps);
+   return (step < nsteps ? mframes[step] : GetExportFrame());
+#endif
+}
+
+bool CScriptedShapeTranslator::IsFirstStep(unsigned int step)
+{
+#ifdef OLD_API
+   return (step == 0);
+#else
+   return !IsExportingMotion();
+#endif
+}
+
+// When the module defines ExportMotion, all motion steps are exported at once on the first one
+//   later steps keep the set of attributes processed then
+bool CScriptedShapeTranslator::RunExportScript(unsigned int step, bool firstStep, bool update, std::vector<std::string> &attrs)
+{
+   CReplayKey replayKey;
+   bool replay = false;
    
-   // Check connection from any shadingEngine on shape
-   MStringArray connections;
-   MGlobal::executeCommand("listConnections -s 1 -d 0 -c 1 -type shadingEngine "+dagPath.fullPathName(), connections);
+   if (firstStep)
+   {
+      m_replayed = false;
+      
+      // Only single step and ExportMotion exports are recorded, in one go
+      replay = (!update && (m_batchEntry.numSteps == 1 || m_batchEntry.owner->exportMotionFunc) &&
+                GetReplayKey(*m_batchEntry.owner, m_dagPath.node(), m_dagPath, m_dagPath.fullPathName(), replayKey));
+      
+      if (replay && RunReplay(m_batchEntry, step, replayKey, attrs))
+      {
+         ResetRemovedParameters(m_batchEntry, attrs);
+         m_overrides.assign(attrs);
+         m_replayed = true;
+         return true;
+      }
+   }
+   
+   if (m_batchEntry.owner->exportMotionFunc && m_batchEntry.numSteps > 1)
+   {
+      if (!firstStep)
+      {
+         return true;
+      }
+      
+      std::vector<double> sampleFrames(m_batchEntry.numSteps);
+      for (unsigned int i=0; i<m_batchEntry.numSteps; ++i)
+      {
+         sampleFrames[i] = GetStepFrame(i);
+      }
+      
+      if (!RunExportMotion(m_batchEntry, GetExportFrame(), sampleFrames, attrs))
+      {
+         return false;
+      }
+   }
+   else if (!RunExport(m_batchEntry, GetExportFrame(), step, GetStepFrame(step), firstStep, update, attrs))
+   {
+      return false;
+   }
+   
+   if (firstStep)
+   {
+      ResetRemovedParameters(m_batchEntry, attrs);
+   }
+   
+   if (replay)
+   {
+      RecordExport(replayKey, m_batchEntry.node, attrs);
+   }
+   
+   // Build set of attributes already processed
+   m_overrides.assign(attrs);
+   
+   return true;
+}
+
+// Secondary instances exported as ginstance only need a few parameters set (FastInstances modules only)
+//   python is only called if the module defines an ExportInstance function
+void CScriptedShapeTranslator::ExportInstance(AtNode *atNode, unsigned int step)
+{
+   PreparePlugs();
+   
+   if (m_translator->exportInstanceFunc)
+   {
+      std::vector<std::string> attrs;
+      
+      bool exported = false;
+      
+      m_batchEntry.node = atNode;
+      
+      {
+         CStatTimer timer(m_stats, STAT_EXPORT_SCRIPT);
+         exported = RunExportInstance(*m_translator, m_batchEntry, GetExportFrame(), step, GetStepFrame(step), attrs);
+      }
+      
+      if (!exported)
+      {
+         AiMsgError("[mtoa.scriptedTranslators] Failed to export instance \"%s\".", m_dagPath.partialPathName().asChar());
+         return;
+      }
+      
+      if (IsFirstStep(step))
+      {
+         ResetRemovedParameters(m_batchEntry, attrs);
+      }
+      
+      m_overrides.assign(attrs);
+   }
+   else
+   {
+      m_overrides.clear();
+   }
    
-   MSelectionList sl;
+   bool firstStep = IsFirstStep(step);
    
-   if (connections.length() == 0)
+   if (firstStep || atNode != m_params.node())
    {
-      // Check for direct surface shader connection
-      MGlobal::executeCommand("listConnections -s 1 -d 0 -c 1 "+dagPath.fullPathName(), connections);
-      
-      for (unsigned int cidx=0; cidx<connections.length(); cidx+=2)
-      {
-         MString srcNode = connections[cidx+1];
-         // Get node classification, if can find arnold/shader/surface -> got it
-         MStringArray rv;
-         MGlobal::executeCommand("getClassification `nodeType "+srcNode+"`", rv);
-         if (rv.length() > 0 && rv[0].indexW("arnold/shader/surface") != -1)
-         {
-            connections.clear();
-            
-            MGlobal::executeCommand("listConnections -s 0 -d 1 -c 1 -type shadingEngine "+srcNode, connections);
-            
-            if (connections.length() == 2)
-            {
-               sl.add(connections[1]);
-            }
-            
-            break;
-         }
-      }
+      m_params.reset(atNode);
    }
-   else if (connections.length() == 2)
+   
    {
-      // Single connection, use same shader for all instances
-      sl.add(connections[1]);
+      CStatTimer timer(m_stats, STAT_MATRIX);
+      ExportMatrix(atNode, step);
    }
-   else if (connections.length() > 2)
+   
+   if (firstStep)
    {
-      // Many connections, expects the destination plug in shape to be an array
-      // Use instance number as logical index, if this fails, use first shadingEngine in list
-      
-      bool found = false;
+      m_commonAttrs.clear();
       
-      sprintf(buffer, "[%d]", dagPath.instanceNumber());
-      MString iidx = buffer;
-      
-      for (unsigned int cidx = 0; cidx < connections.length(); cidx += 2)
       {
-         MString conn = connections[cidx];
+         CStatTimer timer(m_stats, STAT_ATTRIBUTES);
          
-         if (conn.length() < iidx.length())
+         if (!m_overrides.has(PARAM_NODE))
          {
-            continue;
+            AiNodeSetPtr(atNode, "node", m_masterNode);
          }
          
-         if (conn.substring(conn.length() - iidx.length(), conn.length() - 1) != iidx)
+         if (!m_overrides.has(PARAM_INHERIT_XFORM))
          {
-            continue;
+            AiNodeSetBool(atNode, "inherit_xform", false);
          }
          
-         sl.add(connections[cidx+1]);
-         
-         found = true;
-         
-         break;
+         ExportRenderFlags(atNode);
       }
-      
-      if (!found)
+
+#ifdef OLD_API
+      bool exportShaders = true;
+#else
+      bool exportShaders = RequiresShaderExport();
+#endif
+      if (exportShaders)
       {
-         MGlobal::displayWarning("[mtoaScriptedTranslators] Instance shader plug not found, use first found shadingEngine \"" + connections[1] + "\"");
-         sl.add(connections[1]);
+         MFnDependencyNode shadingEngine;
+         {
+            CStatTimer timer(m_stats, STAT_SHADING_ENGINE);
+            GetShapeInstanceShader(m_dagPath, shadingEngine);
+         }
+         ExportShader(atNode, shadingEngine);
       }
+      
+      ResetRemovedCommonParameters(atNode);
    }
    
-   if (sl.length() == 1)
    {
-      MObject shadingEngineObj;
-      
-      if (sl.getDependNode(0, shadingEngineObj) == MS::kSuccess && shadingEngineObj.apiType() == MFn::kShadingEngine)
-      {
-         shadingEngineNode.setObject(shadingEngineObj);
-      }
-      else
-      {
-         if (shadingEngineObj != MObject::kNullObj)
-         {
-            MFnDependencyNode dn(shadingEngineObj);
-            MGlobal::displayWarning("[mtoaScriptedTranslators] Not a shading engine \"" + dn.name() + "\"");
-         }
-      }
+      CStatTimer timer(m_stats, STAT_LINKS);
+      ExportLinks(atNode);
    }
 }
 
-bool CScriptedShapeTranslator::RequiresMotionData()
+// Updates caused by parent transform changes only need the matrix to be exported again,
+//   provided the export script doesn't set it and the arnold node has already been exported
+bool CScriptedShapeTranslator::IsTransformOnlyUpdate(AtNode *atNode, unsigned int step, bool update)
 {
-   return m_motionBlur;
+#ifdef OLD_API
+   return false;
+#else
+   if (IsFirstStep(step))
+   {
+      m_transformUpdate = (update && m_transformDirty && !m_shapeDirty &&
+                           atNode == m_params.node() && !m_overrides.has(PARAM_MATRIX));
+      m_transformDirty = false;
+      m_shapeDirty = false;
+   }
+   
+   return m_transformUpdate;
+#endif
 }
 
 void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, bool update)
 {
-   std::map<std::string, CScriptedTranslator>::iterator translatorIt;
-   MFnDependencyNode fnNode(GetMayaObject());
+   MFnDagNode node(m_dagPath.node());
+   
+   CStatScope stats(m_stats, m_translator, m_dagPath.node());
+   
+   if (IsTransformOnlyUpdate(atNode, step, update))
+   {
+      PreparePlugs();
+      
+      CStatTimer timer(m_stats, STAT_MATRIX);
+      ExportMatrix(atNode, step);
+      
+      return;
+   }
    
-   translatorIt = gTranslators.find(fnNode.typeName().asChar());
-   if (translatorIt == gTranslators.end())
+   if (m_instance)
    {
-      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", fnNode.name().asChar(), fnNode.typeName().asChar());
+      ExportInstance(atNode, step);
       return;
    }
    
-   MString exportCmd = translatorIt->second.exportCmd;
-   MString cleanupCmd = translatorIt->second.cleanupCmd;
+   if (!m_batchEntry.owner)
+   {
+      AiMsgError("[mtoa.scriptedTranslators] No command to export node \"%s\" of type %s.", node.name().asChar(), node.typeName().asChar());
+      return;
+   }
    
-   MFnDagNode node(m_dagPath.node());
+   PreparePlugs();
    
-   bool isMasterDag = false;
    bool transformBlur = IsMotionBlurEnabled(MTOA_MBLUR_OBJECT) && IsLocalMotionBlurEnabled();
    bool deformBlur = IsMotionBlurEnabled(MTOA_MBLUR_DEFORM) && IsLocalMotionBlurEnabled();
    
-   char buffer[64];
-   
-   MString command = exportCmd;
-   command += "(";
-   
-   sprintf(buffer, "%f", GetExportFrame());
-   command += buffer;
-   command += ", ";
-   
-   sprintf(buffer, "%d", step);
-   command += buffer;
-   command += ", ";
-   
-   // current sample frame
-#ifdef OLD_API
-   sprintf(buffer, "%f", GetSampleFrame(m_session, step));
-#else
-   unsigned int nsteps = 0;
-   const double *mframes = GetMotionFrames(nsteps);
-   sprintf(buffer, "%f", (step < nsteps ? mframes[step] : GetExportFrame()));
-#endif
-   command += buffer;
-   command += ", ";
+   m_batchEntry.node = atNode;
    
    // List of arnold attributes the custom shape export command has overriden
-   MStringArray attrs;
+   std::vector<std::string> attrs;
+   
+   bool firstStep = IsFirstStep(step);
+   bool exported = false;
    
-   if (!m_masterNode)
-   {
-      command += "(\"" + m_dagPath.partialPathName() + "\", \"";
-      command += AiNodeGetName(atNode);
-      command += "\"), None)";
-      isMasterDag = true;
-   }
-   else
    {
-      command += "(\"" + m_dagPath.partialPathName() + "\", \"";
-      command += AiNodeGetName(atNode);
-      command += "\"), (\"" + GetMasterInstance().partialPathName() + "\", \"";
-      command += AiNodeGetName(m_masterNode);
-      command += "\"))";
+      CStatTimer timer(m_stats, STAT_EXPORT_SCRIPT);
+      exported = RunExportScript(step, firstStep, update, attrs);
    }
    
-   MStatus status = MGlobal::executePythonCommand(command, attrs);
-   if (!status)
+   if (!exported)
    {
       AiMsgError("[mtoa.scriptedTranslators] Failed to export node \"%s\".", node.name().asChar());
       return;
    }
    
-   // Build set of attributes already processed
-   std::set<std::string> attrsSet;
-   for (unsigned int i=0; i<attrs.length(); ++i)
+   // User parameters only need to be looked up or declared once per arnold node
+   if (firstStep || atNode != m_params.node())
    {
-      attrsSet.insert(attrs[i].asChar());
+      m_params.reset(atNode);
    }
-   std::set<std::string>::iterator attrsEnd = attrsSet.end();
    
    // Should be getting displacement shader from master instance only
    //   as arnold do not support displacement shader overrides for ginstance
@@ -363,11 +1007,11 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
 #else
    bool exportShaders = RequiresShaderExport();
 #endif
-
-   const AtNodeEntry *anodeEntry = AiNodeGetNodeEntry(atNode);
    
    if (exportShaders)
    {
+      CStatTimer timer(m_stats, STAT_SHADING_ENGINE);
+      
       GetShapeInstanceShader(m_dagPath, shadingEngine);
       if (!IsMasterInstance())
       {
@@ -379,160 +1023,90 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
       }
    }
    
-   AtMatrix matrix;
-   MMatrix mmatrix = m_dagPath.inclusiveMatrix();
-   ConvertMatrix(matrix, mmatrix);
+   {
+      CStatTimer timer(m_stats, STAT_MATRIX);
+      ExportMatrix(atNode, step);
+   }
    
-   // Set transformation matrix
-   if (attrsSet.find("matrix") == attrsEnd)
+   // Keep bounding box for each step, arnold node bounds are set once all steps are known
+   bool exportBounds = (!m_overrides.has(PARAM_MIN) && !m_overrides.has(PARAM_MAX) &&
+                        m_params.builtin(PARAM_MIN) && m_params.builtin(PARAM_MAX));
+   
+   if (firstStep)
    {
-      if (HasParameter(anodeEntry, "matrix"))
-      {
-         if (transformBlur)
-         {
-            if (step == 0)
-            {
-               AtArray* matrices = AiArrayAllocate(1, GetNumMotionSteps(), AI_TYPE_MATRIX);
-               AiArraySetMtx(matrices, step, matrix);
-               AiNodeSetArray(atNode, "matrix", matrices);
-            }
-            else
-            {
-               AtArray* matrices = AiNodeGetArray(atNode, "matrix");
-               AiArraySetMtx(matrices, step, matrix);
-            }
-         }
-         else
-         {
-            AiNodeSetMatrix(atNode, "matrix", matrix);
-         }
-      }
+      m_motionBounds.assign(m_motionBlur ? GetNumMotionSteps() : 1, CMotionBounds());
    }
    
-   // Set bounding box
-   if (attrsSet.find("min") == attrsEnd && attrsSet.find("max") == attrsEnd)
+   if (exportBounds && step < m_motionBounds.size() && (firstStep || transformBlur || deformBlur))
    {
-      // Now check if min and max parameters are valid parameter names on arnold node
-      if (HasParameter(anodeEntry, "min") != 0 && HasParameter(anodeEntry, "max") != 0)
-      {
-         if (step == 0)
-         {
-            MBoundingBox bbox = node.boundingBox();
-            
-            MPoint bmin = bbox.min();
-            MPoint bmax = bbox.max();
-            
-            AiNodeSetPnt(atNode, "min", static_cast<float>(bmin.x), static_cast<float>(bmin.y), static_cast<float>(bmin.z));
-            AiNodeSetPnt(atNode, "max", static_cast<float>(bmax.x), static_cast<float>(bmax.y), static_cast<float>(bmax.z));
-         }
-         else
-         {
-            if (transformBlur || deformBlur)
-            {
-               AtPoint cmin = AiNodeGetPnt(atNode, "min");
-               AtPoint cmax = AiNodeGetPnt(atNode, "max");
-               
-               MBoundingBox bbox = node.boundingBox();
-               
-               MPoint bmin = bbox.min();
-               MPoint bmax = bbox.max();
-               
-               if (bmin.x < cmin.x)
-                  cmin.x = static_cast<float>(bmin.x);
-               if (bmin.y < cmin.y)
-                  cmin.y = static_cast<float>(bmin.y);
-               if (bmin.z < cmin.z)
-                  cmin.z = static_cast<float>(bmin.z);
-               if (bmax.x > cmax.x)
-                  cmax.x = static_cast<float>(bmax.x);
-               if (bmax.y > cmax.y)
-                  cmax.y = static_cast<float>(bmax.y);
-               if (bmax.z > cmax.z)
-                  cmax.z = static_cast<float>(bmax.z);
-               
-               AiNodeSetPnt(atNode, "min", cmin.x, cmin.y, cmin.z);
-               AiNodeSetPnt(atNode, "max", cmax.x, cmax.y, cmax.z);
-            }
-         }
-      }
+      MBoundingBox bbox = node.boundingBox();
+      
+      MPoint bmin = bbox.min();
+      MPoint bmax = bbox.max();
+      
+      CMotionBounds &bounds = m_motionBounds[step];
+      
+      AiV3Create(bounds.min, static_cast<float>(bmin.x), static_cast<float>(bmin.y), static_cast<float>(bmin.z));
+      AiV3Create(bounds.max, static_cast<float>(bmax.x), static_cast<float>(bmax.y), static_cast<float>(bmax.z));
+      bounds.valid = true;
    }
-
-#ifdef OLD_API
-   if (step == 0)
-#else
-   if (!IsExportingMotion())
-#endif
+   
+   
+   if (firstStep)
    {
+      CStatTimer timer(m_stats, STAT_ATTRIBUTES);
+      
       // Set common attributes
       MPlug plug;
-
+      
       m_exportedSteps.clear();
-
+      m_commonAttrs.clear();
+      
       if (AiNodeIs(atNode, "procedural"))
       {
          // Note: it is up to the procedural to properly forward (or not) those parameters to the node
          //       it creates
          
-         if (attrsSet.find("subdiv_type") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_TYPE))
          {
-            plug = FindMayaPlug("subdiv_type");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivType");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_type", atNode, "constant INT"))
+            plug = FindPlug(PLUG_SUBDIV_TYPE);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_TYPE))
             {
                AiNodeSetInt(atNode, "subdiv_type", plug.asInt());
             }
          }
          
-         if (attrsSet.find("subdiv_iterations") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_ITERATIONS))
          {
-            plug = FindMayaPlug("subdiv_iterations");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivIterations");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_iterations", atNode, "constant BYTE"))
+            plug = FindPlug(PLUG_SUBDIV_ITERATIONS);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_ITERATIONS))
             {
                AiNodeSetByte(atNode, "subdiv_iterations", plug.asInt());
             }
          }
          
-         if (attrsSet.find("subdiv_adaptive_metric") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_ADAPTIVE_METRIC))
          {
-            plug = FindMayaPlug("subdiv_adaptive_metric");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivAdaptiveMetric");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_adaptive_metric", atNode, "constant INT"))
+            plug = FindPlug(PLUG_SUBDIV_ADAPTIVE_METRIC);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_ADAPTIVE_METRIC))
             {
                AiNodeSetInt(atNode, "subdiv_adaptive_metric", plug.asInt());
             }
          }
          
-         if (attrsSet.find("subdiv_pixel_error") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_PIXEL_ERROR))
          {
-            plug = FindMayaPlug("subdiv_pixel_error");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivPixelError");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_pixel_error", atNode, "constant FLOAT"))
+            plug = FindPlug(PLUG_SUBDIV_PIXEL_ERROR);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_PIXEL_ERROR))
             {
                AiNodeSetFlt(atNode, "subdiv_pixel_error", plug.asFloat());
             }
          }
          
-         if (attrsSet.find("subdiv_dicing_camera") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_DICING_CAMERA))
          {
-            plug = FindMayaPlug("subdiv_dicing_camera");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivDicingCamera");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_dicing_camera", atNode, "constant NODE"))
+            plug = FindPlug(PLUG_SUBDIV_DICING_CAMERA);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_DICING_CAMERA))
             {
                AtNode *cameraNode = NULL;
                
@@ -562,41 +1136,37 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
             }
          }
          
-         if (attrsSet.find("subdiv_uv_smoothing") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_UV_SMOOTHING))
          {
-            plug = FindMayaPlug("subdiv_uv_smoothing");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSubdivUvSmoothing");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_uv_smoothing", atNode, "constant INT"))
+            plug = FindPlug(PLUG_SUBDIV_UV_SMOOTHING);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_UV_SMOOTHING))
             {
                AiNodeSetInt(atNode, "subdiv_uv_smoothing", plug.asInt());
             }
          }
          
-         if (attrsSet.find("subdiv_smooth_derivs") == attrsEnd)
+         if (!m_overrides.has(PARAM_SUBDIV_SMOOTH_DERIVS))
          {
-            plug = FindMayaPlug("aiSubdivSmoothDerivs");
-            if (!plug.isNull() && HasParameter(anodeEntry, "subdiv_smooth_derivs", atNode, "constant BOOL"))
+            plug = FindPlug(PLUG_SUBDIV_SMOOTH_DERIVS);
+            if (!plug.isNull() && m_params.has(PARAM_SUBDIV_SMOOTH_DERIVS))
             {
                AiNodeSetBool(atNode, "subdiv_smooth_derivs", plug.asBool());
             }
          }
          
-         if (attrsSet.find("smoothing") == attrsEnd)
+         if (!m_overrides.has(PARAM_SMOOTHING))
          {
             // Use maya shape built-in attribute
-            plug = FindMayaPlug("smoothShading");
-            if (!plug.isNull() && HasParameter(anodeEntry, "smoothing", atNode, "constant BOOL"))
+            plug = FindPlug(PLUG_SMOOTH_SHADING);
+            if (!plug.isNull() && m_params.has(PARAM_SMOOTHING))
             {
                AiNodeSetBool(atNode, "smoothing", plug.asBool());
             }
          }
          
-         if (attrsSet.find("disp_height") == attrsEnd)
+         if (!m_overrides.has(PARAM_DISP_HEIGHT))
          {
-            plug = FindMayaPlug("aiDispHeight");
+            plug = FindPlug(PLUG_DISP_HEIGHT);
             if (!plug.isNull())
             {
                outputDispHeight = true;
@@ -604,9 +1174,9 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
             }
          }
          
-         if (attrsSet.find("disp_zero_value") == attrsEnd)
+         if (!m_overrides.has(PARAM_DISP_ZERO_VALUE))
          {
-            plug = FindMayaPlug("aiDispZeroValue");
+            plug = FindPlug(PLUG_DISP_ZERO_VALUE);
             if (!plug.isNull())
             {
                outputDispZeroValue = true;
@@ -614,9 +1184,9 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
             }
          }
          
-         if (attrsSet.find("disp_autobump") == attrsEnd)
+         if (!m_overrides.has(PARAM_DISP_AUTOBUMP))
          {
-            plug = FindMayaPlug("aiDispAutobump");
+            plug = FindPlug(PLUG_DISP_AUTOBUMP);
             if (!plug.isNull())
             {
                outputDispAutobump = true;
@@ -624,9 +1194,9 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
             }
          }
          
-         if (attrsSet.find("disp_padding") == attrsEnd)
+         if (!m_overrides.has(PARAM_DISP_PADDING))
          {
-            plug = FindMayaPlug("aiDispPadding");
+            plug = FindPlug(PLUG_DISP_PADDING);
             if (!plug.isNull())
             {
                outputDispPadding = true;
@@ -635,7 +1205,7 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
          }
          
          // Set diplacement shader
-         if (exportShaders && attrsSet.find("disp_map") == attrsEnd)
+         if (exportShaders && !m_overrides.has(PARAM_DISP_MAP))
          {
             if (masterShadingEngine.object() != MObject::kNullObj)
             {
@@ -663,7 +1233,7 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
                      dispAutobump = dispAutobump || plug.asBool();
                   }
                   
-                  if (HasParameter(anodeEntry, "disp_map", atNode, "constant ARRAY NODE"))
+                  if (m_params.has(PARAM_DISP_MAP))
                   {
 #ifdef OLD_API
                      AtNode *dispImage = ExportNode(shaderConns[0]);
@@ -671,78 +1241,75 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
                      AtNode *dispImage = ExportConnectedNode(shaderConns[0]);
 #endif
                      AiNodeSetArray(atNode, "disp_map", AiArrayConvert(1, 1, AI_TYPE_NODE, &dispImage));
+                     m_commonAttrs.push_back("disp_map");
                   }
                }
             }
          }
          
-         if (outputDispHeight && HasParameter(anodeEntry, "disp_height", atNode, "constant FLOAT"))
+         if (outputDispHeight && m_params.has(PARAM_DISP_HEIGHT))
          {
             AiNodeSetFlt(atNode, "disp_height", dispHeight);
+            m_commonAttrs.push_back("disp_height");
          }
-         if (outputDispZeroValue && HasParameter(anodeEntry, "disp_zero_value", atNode, "constant FLOAT"))
+         if (outputDispZeroValue && m_params.has(PARAM_DISP_ZERO_VALUE))
          {
             AiNodeSetFlt(atNode, "disp_zero_value", dispZeroValue);
+            m_commonAttrs.push_back("disp_zero_value");
          }
-         if (outputDispPadding && HasParameter(anodeEntry, "disp_padding", atNode, "constant FLOAT"))
+         if (outputDispPadding && m_params.has(PARAM_DISP_PADDING))
          {
             AiNodeSetFlt(atNode, "disp_padding", dispPadding);
+            m_commonAttrs.push_back("disp_padding");
          }
-         if (outputDispAutobump && HasParameter(anodeEntry, "disp_autobump", atNode, "constant BOOL"))
+         if (outputDispAutobump && m_params.has(PARAM_DISP_AUTOBUMP))
          {
             AiNodeSetBool(atNode, "disp_autobump", dispAutobump);
+            m_commonAttrs.push_back("disp_autobump");
          }
          
          // Old point based SSS parameter
-         if (attrsSet.find("sss_sample_distribution") == attrsEnd)
+         if (!m_overrides.has(PARAM_SSS_SAMPLE_DISTRIBUTION))
          {
-            plug = FindMayaPlug("sss_sample_distribution");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSssSampleDistribution");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "sss_sample_distribution", atNode, "constant INT"))
+            plug = FindPlug(PLUG_SSS_SAMPLE_DISTRIBUTION);
+            if (!plug.isNull() && m_params.has(PARAM_SSS_SAMPLE_DISTRIBUTION))
             {
                AiNodeSetInt(atNode, "sss_sample_distribution", plug.asInt());
             }
          }
          
          // Old point based SSS parameter
-         if (attrsSet.find("sss_sample_spacing") == attrsEnd)
+         if (!m_overrides.has(PARAM_SSS_SAMPLE_SPACING))
          {
-            plug = FindMayaPlug("sss_sample_spacing");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiSssSampleSpacing");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "sss_sample_spacing", atNode, "constant FLOAT"))
+            plug = FindPlug(PLUG_SSS_SAMPLE_SPACING);
+            if (!plug.isNull() && m_params.has(PARAM_SSS_SAMPLE_SPACING))
             {
                AiNodeSetFlt(atNode, "sss_sample_spacing", plug.asFloat());
             }
          }
          
-         if (attrsSet.find("min_pixel_width") == attrsEnd)
+         if (!m_overrides.has(PARAM_MIN_PIXEL_WIDTH))
          {
-            plug = FindMayaPlug("aiMinPixelWidth");
-            if (!plug.isNull() && HasParameter(anodeEntry, "min_pixel_width", atNode, "constant FLOAT"))
+            plug = FindPlug(PLUG_MIN_PIXEL_WIDTH);
+            if (!plug.isNull() && m_params.has(PARAM_MIN_PIXEL_WIDTH))
             {
                AiNodeSetFlt(atNode, "min_pixel_width", plug.asFloat());
             }
          }
          
-         if (attrsSet.find("mode") == attrsEnd)
+         if (!m_overrides.has(PARAM_MODE))
          {
-            plug = FindMayaPlug("aiMode");
-            if (!plug.isNull() && HasParameter(anodeEntry, "mode", atNode, "constant INT"))
+            plug = FindPlug(PLUG_MODE);
+            if (!plug.isNull() && m_params.has(PARAM_MODE))
             {
                AiNodeSetInt(atNode, "mode", plug.asShort());
             }
          }
          
-         if (attrsSet.find("basis") == attrsEnd)
+         if (!m_overrides.has(PARAM_BASIS))
          {
-            plug = FindMayaPlug("aiBasis");
-            if (!plug.isNull() && HasParameter(anodeEntry, "basis", atNode, "constant INT"))
+            plug = FindPlug(PLUG_BASIS);
+            if (!plug.isNull() && m_params.has(PARAM_BASIS))
             {
                AiNodeSetInt(atNode, "basis", plug.asShort());
             }
@@ -751,12 +1318,12 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
       
       if (AiNodeIs(atNode, "ginstance"))
       {
-         if (attrsSet.find("node") == attrsEnd)
+         if (!m_overrides.has(PARAM_NODE))
          {
             AiNodeSetPtr(atNode, "node", m_masterNode);
          }
          
-         if (attrsSet.find("inherit_xform") == attrsEnd)
+         if (!m_overrides.has(PARAM_INHERIT_XFORM))
          {
             AiNodeSetBool(atNode, "inherit_xform", false);
          }
@@ -764,204 +1331,30 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
       else
       {
          // box or procedural
-         if (attrsSet.find("step_size") == attrsEnd)
+         if (!m_overrides.has(PARAM_STEP_SIZE))
          {
-            plug = FindMayaPlug("step_size");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiStepSize");
-            }
-            if (!plug.isNull() && HasParameter(anodeEntry, "step_size", atNode, "constant FLOAT"))
+            plug = FindPlug(PLUG_STEP_SIZE);
+            if (!plug.isNull() && m_params.has(PARAM_STEP_SIZE))
             {
                AiNodeSetFlt(atNode, "step_size", plug.asFloat());
             }
          }
       }
       
-      if (attrsSet.find("sidedness") == attrsEnd)
-      {
-         // Use maya shape built-in attribute
-         plug = FindMayaPlug("doubleSided");
-         if (!plug.isNull() && HasParameter(anodeEntry, "sidedness", atNode, "constant BYTE"))
-         {
-            AiNodeSetByte(atNode, "sidedness", plug.asBool() ? AI_RAY_ALL : 0);
-            
-            // Only set invert_normals if doubleSided attribute could be found
-            if (!plug.asBool() && attrsSet.find("invert_normals") == attrsEnd)
-            {
-               // Use maya shape built-in attribute
-               plug = FindMayaPlug("opposite");
-               if (!plug.isNull() && HasParameter(anodeEntry, "invert_normals", atNode, "constant BOOL"))
-               {
-                  AiNodeSetBool(atNode, "invert_normals", plug.asBool());
-               }
-            }
-         }
-      }
-      
-      if (attrsSet.find("receive_shadows") == attrsEnd)
-      {
-         // Use maya shape built-in attribute
-         plug = FindMayaPlug("receiveShadows");
-         if (!plug.isNull() && HasParameter(anodeEntry, "receive_shadows", atNode, "constant BOOL"))
-         {
-            AiNodeSetBool(atNode, "receive_shadows", plug.asBool());
-         }
-      }
-      
-      if (attrsSet.find("self_shadows") == attrsEnd)
-      {
-         plug = FindMayaPlug("self_shadows");
-         if (plug.isNull())
-         {
-            plug = FindMayaPlug("aiSelfShadows");
-         }
-         if (!plug.isNull() && HasParameter(anodeEntry, "self_shadows", atNode, "constant BOOL"))
-         {
-            AiNodeSetBool(atNode, "self_shadows", plug.asBool());
-         }
-      }
-      
-      if (attrsSet.find("opaque") == attrsEnd)
-      {
-         plug = FindMayaPlug("opaque");
-         if (plug.isNull())
-         {
-            plug = FindMayaPlug("aiOpaque");
-         }
-         if (!plug.isNull() && HasParameter(anodeEntry, "opaque", atNode, "constant BOOL"))
-         {
-            AiNodeSetBool(atNode, "opaque", plug.asBool());
-         }
-      }
-      
-      if (attrsSet.find("matte") == attrsEnd)
-      {
-         plug = FindMayaPlug("matte");
-         if (plug.isNull())
-         {
-            plug = FindMayaPlug("aiMatte");
-         }
-         if (!plug.isNull() && HasParameter(anodeEntry, "matte", atNode, "constant BOOL"))
-         {
-            AiNodeSetBool(atNode, "matte", plug.asBool());
-         }
-      }
-      
-      if (attrsSet.find("visibility") == attrsEnd)
-      {
-         if (HasParameter(anodeEntry, "visibility", atNode, "constant BYTE"))
-         {
-            int visibility = AI_RAY_ALL;
-            
-            // Use maya shape built-in attribute
-            plug = FindMayaPlug("castsShadows");
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_SHADOW;
-            }
-            
-            // Use maya shape built-in attribute
-            plug = FindMayaPlug("primaryVisibility");
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_CAMERA;
-            }
-            
-            // Use maya shape built-in attribute
-            plug = FindMayaPlug("visibleInReflections");
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_REFLECTED;
-            }
-            
-            // Use maya shape built-in attribute
-            plug = FindMayaPlug("visibleInRefractions");
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_REFRACTED;
-            }
-            
-            plug = FindMayaPlug("diffuse_visibility");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiVisibleInDiffuse");
-            }
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_DIFFUSE;
-            }
-            
-            plug = FindMayaPlug("glossy_visibility");
-            if (plug.isNull())
-            {
-               plug = FindMayaPlug("aiVisibleInGlossy");
-            }
-            if (!plug.isNull() && !plug.asBool())
-            {
-               visibility &= ~AI_RAY_GLOSSY;
-            }
-            
-            AiNodeSetByte(atNode, "visibility", visibility & 0xFF);
-         }
-      }
-      
-      if (attrsSet.find("sss_setname") == attrsEnd)
-      {
-         plug = FindMayaPlug("aiSssSetname");
-         if (!plug.isNull() && plug.asString().length() > 0)
-         {
-            if (HasParameter(anodeEntry, "sss_setname", atNode, "constant STRING"))
-            {
-               AiNodeSetStr(atNode, "sss_setname", plug.asString().asChar());
-            }
-         }
-      }
+      ExportRenderFlags(atNode);
       
       // Set surface shader
-      if (exportShaders && HasParameter(anodeEntry, "shader", atNode, "constant NODE"))
+      if (exportShaders)
       {
-         if (attrsSet.find("shader") == attrsEnd)
-         {
-            if (shadingEngine.object() != MObject::kNullObj)
-            {
-#ifdef OLD_API
-               AtNode *shader = ExportNode(shadingEngine.findPlug("message"));
-#else
-               AtNode *shader = ExportConnectedNode(shadingEngine.findPlug("message"));
-#endif
-               if (shader != NULL)
-               {
-                  const AtNodeEntry *entry = AiNodeGetNodeEntry(shader);
-                  
-                  if (AiNodeEntryGetType(entry) != AI_NODE_SHADER)
-                  {
-                     MGlobal::displayWarning("[mtoaScriptedTranslators] Node generated from \"" + shadingEngine.name() +
-                                             "\" of type " + shadingEngine.typeName() + " for shader is not a shader but a " +
-                                             MString(AiNodeEntryGetTypeName(entry)));
-                  }
-                  else
-                  {
-                     AiNodeSetPtr(atNode, "shader", shader);
-                     
-                     if (AiNodeLookUpUserParameter(atNode, "mtoa_shading_groups") == 0)
-                     {
-                        AiNodeDeclare(atNode, "mtoa_shading_groups", "constant ARRAY NODE");
-                        AiNodeSetArray(atNode, "mtoa_shading_groups", AiArrayConvert(1, 1, AI_TYPE_NODE, &shader));
-                     }
-                  }
-               }
-            }
-         }
+         ExportShader(atNode, shadingEngine);
       }
+      
+      ResetRemovedCommonParameters(atNode);
    }
    
-   ExportLightLinking(atNode);
-   
-   MPlug plug = FindMayaPlug("aiTraceSets");
-   if (!plug.isNull())
    {
-      ExportTraceSets(atNode, plug);
+      CStatTimer timer(m_stats, STAT_LINKS);
+      ExportLinks(atNode);
    }
    
    if (m_exportedSteps.find(step) != m_exportedSteps.end())
@@ -975,10 +1368,16 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
    // Call cleanup command on last export step
    if (!m_motionBlur || m_exportedSteps.size() == GetNumMotionSteps())
    {
-      if (HasParameter(anodeEntry, "disp_padding", atNode))
+      float padding = (m_params.has(PARAM_DISP_PADDING, false) ? AiNodeGetFlt(atNode, "disp_padding") : 0.0f);
+      
+      if (exportBounds)
       {
-         float padding = AiNodeGetFlt(atNode, "disp_padding");
-         
+         CStatTimer timer(m_stats, STAT_BOUNDS);
+         ExportBounds(atNode, padding);
+      }
+      else if (padding != 0.0f && m_params.builtin(PARAM_MIN) && m_params.builtin(PARAM_MAX))
+      {
+         // Bounds set by export function
          AtPoint cmin = AiNodeGetPnt(atNode, "min");
          AtPoint cmax = AiNodeGetPnt(atNode, "max");
          
@@ -993,29 +1392,11 @@ void CScriptedShapeTranslator::RunScripts(AtNode *atNode, unsigned int step, boo
          AiNodeSetPnt(atNode, "max", cmax.x, cmax.y, cmax.z);
       }
       
-      if (cleanupCmd != "")
+      // Cleanup is paired with Export, which a replayed export didn't call
+      if (!m_replayed)
       {
-         command = cleanupCmd += "((\"" + m_dagPath.partialPathName() + "\", \"";
-         command += AiNodeGetName(atNode);
-         command += "\"), ";
-         
-         if (!m_masterNode)
-         {
-            command += "None)";
-         }
-         else
-         {
-            command += "(\"" + GetMasterInstance().partialPathName() + "\", \"";
-            command += AiNodeGetName(m_masterNode);
-            command += "\"))";
-         }
-         
-         status = MGlobal::executePythonCommand(command);
-         
-         if (!status)
-         {
-            AiMsgError("[mtoa.scriptedTranslators] Failed to cleanup node \"%s\".", node.name().asChar());
-         }
+         CStatTimer timer(m_stats, STAT_CLEANUP_SCRIPT);
+         RunCleanup(m_batchEntry);
       }
    }
 }
@@ -4,6 +4,10 @@
 #include "common.h"
 #include "translators/shape/ShapeTranslator.h"
 #include "extension/Extension.h"
+#include "plugin.h"
+#include "params.h"
+#include "plugs.h"
+#include "stats.h"
 #include <set>
 
 class CScriptedShapeTranslator : public CShapeTranslator
@@ -30,6 +34,7 @@ public:
    virtual void Init();
    virtual void ExportMotion(AtNode *atNode);
    virtual void RequestUpdate();
+   virtual void NodeChanged(MObject &node, MPlug &plug);
 #endif
    
    
@@ -41,14 +46,61 @@ public:
    
 private:
    
+   struct CMotionBounds
+   {
+      bool valid;
+      AtPoint min;
+      AtPoint max;
+      
+      CMotionBounds();
+   };
+   
+private:
+   
+   bool ResolveTranslator();
+   void PreparePlugs();
+   AtNode* FindMasterNode();
+   const char* GetArnoldNodeType(AtNode *masterNode);
+   MPlug FindPlug(PlugId id);
+   double GetStepFrame(unsigned int step);
+   bool IsFirstStep(unsigned int step);
+   bool GetWorldMatrix(double frame, AtMatrix &matrix);
+   void ExportMatrix(AtNode *atNode, unsigned int step);
+   void ExportRenderFlags(AtNode *atNode);
+   void ExportShader(AtNode *atNode, MFnDependencyNode &shadingEngine);
+   void ExportLinks(AtNode *atNode);
+   void ResetRemovedCommonParameters(AtNode *atNode);
+   void ExportBounds(AtNode *atNode, float padding);
+   void ExportInstance(AtNode *atNode, unsigned int step);
+   bool IsTransformOnlyUpdate(AtNode *atNode, unsigned int step, bool update);
+   bool RunExportScript(unsigned int step, bool firstStep, bool update, std::vector<std::string> &attrs);
    void RunScripts(AtNode *atNode, unsigned int step, bool update=false);
    void GetShapeInstanceShader(MDagPath &dagPath, MFnDependencyNode &shadingEngineNode);
    
 private:
    
+   CScriptedTranslator *m_translator;
    bool m_motionBlur;
    AtNode *m_masterNode;
+   bool m_instance;
+   CNodePlugs m_plugs;
+   // Changes received since the last export, and whether the current one only needs the matrix
+   bool m_transformDirty;
+   bool m_shapeDirty;
+   bool m_transformUpdate;
+   // Parameters set from the replay cache, Export wasn't called
+   bool m_replayed;
+   // Common parameters set depending on attribute values or connections by the current export
+   //   and (sorted) by the previous export of m_commonNode
+   std::vector<std::string> m_commonAttrs;
+   std::vector<std::string> m_exportedCommonAttrs;
+   AtNode *m_commonNode;
    std::set<unsigned int> m_exportedSteps;
+   std::vector<CMotionBounds> m_motionBounds;
+   CScriptedBatchEntry m_batchEntry;
+   COverrides m_overrides;
+   CExportStats m_stats;
+   CNodeParams m_params;
 };
 
 #endif
@@ -0,0 +1,311 @@
+#include "stats.h"
+#include "plugin.h"
+
+#define MNoVersionString
+#define MNoPluginEntry
+#include <maya/MFnPlugin.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MPxCommand.h>
+#include <maya/MSyntax.h>
+#include <maya/MArgDatabase.h>
+#include <maya/MArgList.h>
+#include <maya/MStringArray.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+#include <cstdio>
+#include <map>
+
+typedef std::map<std::string, CExportStats> CStatsMap;
+
+static CStatsMap gTypeStats;
+static CStatsMap gNodeStats;
+// Per type statistics since the last summary
+static CStatsMap gSessionStats;
+
+static int gNumTranslators = 0;
+static int gStatsEnabled = -1;
+
+static const char* gStatsCommand = "scriptedTranslatorsStats";
+
+static const char* gPhaseNames[STAT_COUNT] =
+{
+   "total",
+   "export",
+   "cleanup",
+   "shadingEngine",
+   "matrix",
+   "attributes",
+   "links",
+   "bounds"
+};
+
+
+CStatCounter::CStatCounter()
+   : calls(0), total(0.0), max(0.0)
+{
+}
+
+void CStatCounter::add(double seconds)
+{
+   ++calls;
+   total += seconds;
+   if (seconds > max)
+   {
+      max = seconds;
+   }
+}
+
+void CStatCounter::merge(const CStatCounter &other)
+{
+   calls += other.calls;
+   total += other.total;
+   if (other.max > max)
+   {
+      max = other.max;
+   }
+}
+
+void CExportStats::reset()
+{
+   for (int i=0; i<STAT_COUNT; ++i)
+   {
+      counters[i] = CStatCounter();
+   }
+}
+
+static void MergeStats(CExportStats &dst, const CExportStats &src)
+{
+   for (int i=0; i<STAT_COUNT; ++i)
+   {
+      dst.counters[i].merge(src.counters[i]);
+   }
+}
+
+double GetStatTime()
+{
+#ifdef _WIN32
+   static double frequency = 0.0;
+   LARGE_INTEGER counter;
+   if (frequency == 0.0)
+   {
+      LARGE_INTEGER f;
+      QueryPerformanceFrequency(&f);
+      frequency = (double) f.QuadPart;
+   }
+   QueryPerformanceCounter(&counter);
+   return (double) counter.QuadPart / frequency;
+#else
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return (double) tv.tv_sec + 0.000001 * (double) tv.tv_usec;
+#endif
+}
+
+bool IsStatsEnabled()
+{
+   if (gStatsEnabled < 0)
+   {
+      MString var = MString("$MTOA_SCRIPTED_TRANSLATORS_STATS").expandEnvironmentVariablesAndTilde();
+      gStatsEnabled = (var == "0" ? 0 : 1);
+   }
+   return (gStatsEnabled != 0);
+}
+
+CStatTimer::CStatTimer(CExportStats &stats, StatPhase phase)
+   : m_stats(stats), m_phase(phase), m_start(IsStatsEnabled() ? GetStatTime() : -1.0)
+{
+}
+
+CStatTimer::~CStatTimer()
+{
+   if (m_start >= 0.0)
+   {
+      m_stats.counters[m_phase].add(GetStatTime() - m_start);
+   }
+}
+
+CStatScope::CStatScope(CExportStats &stats, const CScriptedTranslator *translator, const MObject &node)
+   : m_stats(stats), m_translator(translator), m_node(node), m_start(IsStatsEnabled() ? GetStatTime() : -1.0)
+{
+}
+
+CStatScope::~CStatScope()
+{
+   if (m_start < 0.0)
+   {
+      return;
+   }
+   
+   m_stats.counters[STAT_TOTAL].add(GetStatTime() - m_start);
+   
+   if (m_translator)
+   {
+      MergeStats(gTypeStats[m_translator->nodeType], m_stats);
+      MergeStats(gSessionStats[m_translator->nodeType], m_stats);
+      MergeStats(gNodeStats[MFnDependencyNode(m_node).name().asChar()], m_stats);
+   }
+   
+   m_stats.reset();
+}
+
+static MString FormatCounter(const char *prefix, int phase, const CStatCounter &counter)
+{
+   char buffer[256];
+   sprintf(buffer, "%s%s %lu %f %f", prefix, gPhaseNames[phase], counter.calls, counter.total, counter.max);
+   return buffer;
+}
+
+static void LogStats(const CStatsMap &stats)
+{
+   for (CStatsMap::const_iterator it=stats.begin(); it!=stats.end(); ++it)
+   {
+      AiMsgInfo("[mtoa.scriptedTranslators] %s: %lu export(s) in %f second(s)", it->first.c_str(),
+                it->second.counters[STAT_TOTAL].calls, it->second.counters[STAT_TOTAL].total);
+      
+      for (int i=1; i<STAT_COUNT; ++i)
+      {
+         const CStatCounter &counter = it->second.counters[i];
+         
+         if (counter.calls > 0)
+         {
+            AiMsgInfo("[mtoa.scriptedTranslators]   %-14s %8lu call(s) %12f s (max %f s)", gPhaseNames[i], counter.calls, counter.total, counter.max);
+         }
+      }
+   }
+}
+
+void AddStatsTranslator()
+{
+   ++gNumTranslators;
+}
+
+void RemoveStatsTranslator()
+{
+   if (gNumTranslators > 0 && --gNumTranslators == 0 && gSessionStats.size() > 0)
+   {
+      LogStats(gSessionStats);
+      gSessionStats.clear();
+   }
+}
+
+class CScriptedTranslatorsStatsCmd : public MPxCommand
+{
+public:
+   
+   static void* creator()
+   {
+      return new CScriptedTranslatorsStatsCmd();
+   }
+   
+   static MSyntax newSyntax()
+   {
+      MSyntax syntax;
+      syntax.addFlag("-t", "-type", MSyntax::kString);
+      syntax.addFlag("-n", "-node", MSyntax::kString);
+      syntax.addFlag("-r", "-reset");
+      syntax.addFlag("-l", "-log");
+      return syntax;
+   }
+   
+   virtual bool isUndoable() const
+   {
+      return false;
+   }
+   
+   // Returns "phase calls totalSeconds maxSeconds" strings for the given type or node,
+   //   or "nodeType phase calls totalSeconds maxSeconds" for all types
+   virtual MStatus doIt(const MArgList &args)
+   {
+      MStatus status;
+      MArgDatabase db(syntax(), args, &status);
+      MStringArray result;
+      MString name;
+      
+      if (status != MS::kSuccess)
+      {
+         return status;
+      }
+      
+      if (db.isFlagSet("-log"))
+      {
+         LogStats(gTypeStats);
+      }
+      
+      if (db.isFlagSet("-type") || db.isFlagSet("-node"))
+      {
+         bool byType = db.isFlagSet("-type");
+         CStatsMap &stats = (byType ? gTypeStats : gNodeStats);
+         
+         db.getFlagArgument(byType ? "-type" : "-node", 0, name);
+         
+         CStatsMap::iterator it = stats.find(name.asChar());
+         
+         if (it != stats.end())
+         {
+            for (int i=0; i<STAT_COUNT; ++i)
+            {
+               result.append(FormatCounter("", i, it->second.counters[i]));
+            }
+         }
+      }
+      else
+      {
+         for (CStatsMap::iterator it=gTypeStats.begin(); it!=gTypeStats.end(); ++it)
+         {
+            std::string prefix = it->first + " ";
+            
+            for (int i=0; i<STAT_COUNT; ++i)
+            {
+               result.append(FormatCounter(prefix.c_str(), i, it->second.counters[i]));
+            }
+         }
+      }
+      
+      if (db.isFlagSet("-reset"))
+      {
+         gTypeStats.clear();
+         gNodeStats.clear();
+         gSessionStats.clear();
+      }
+      
+      setResult(result);
+      
+      return MS::kSuccess;
+   }
+};
+
+void RegisterStatsCommand()
+{
+   MObject mtoa = MFnPlugin::findPlugin("mtoa");
+   
+   if (mtoa.isNull())
+   {
+      return;
+   }
+   
+   MFnPlugin plugin(mtoa);
+   
+   if (plugin.registerCommand(gStatsCommand, CScriptedTranslatorsStatsCmd::creator, CScriptedTranslatorsStatsCmd::newSyntax) != MS::kSuccess)
+   {
+      MGlobal::displayWarning(MString("[mtoa.scriptedTranslators] Could not register ") + gStatsCommand + " command");
+   }
+}
+
+void DeregisterStatsCommand()
+{
+   MObject mtoa = MFnPlugin::findPlugin("mtoa");
+   
+   if (!mtoa.isNull())
+   {
+      MFnPlugin plugin(mtoa);
+      plugin.deregisterCommand(gStatsCommand);
+   }
+   
+   gTypeStats.clear();
+   gNodeStats.clear();
+   gSessionStats.clear();
+}
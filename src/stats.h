@@ -0,0 +1,87 @@
+#ifndef __stats_h__
+#define __stats_h__
+
+#include <maya/MObject.h>
+#include <string>
+
+struct CScriptedTranslator;
+
+// Export phases timed by the translators
+enum StatPhase
+{
+   STAT_TOTAL = 0,
+   STAT_EXPORT_SCRIPT,
+   STAT_CLEANUP_SCRIPT,
+   STAT_SHADING_ENGINE,
+   STAT_MATRIX,
+   STAT_ATTRIBUTES,
+   STAT_LINKS,
+   STAT_BOUNDS,
+   STAT_COUNT
+};
+
+struct CStatCounter
+{
+   unsigned long calls;
+   double total;
+   double max;
+   
+   CStatCounter();
+   
+   void add(double seconds);
+   void merge(const CStatCounter &other);
+};
+
+// Timings of a single export call, kept by the translator and merged into the per type and per node statistics
+struct CExportStats
+{
+   CStatCounter counters[STAT_COUNT];
+   
+   void reset();
+};
+
+// Seconds, from an arbitrary origin
+double GetStatTime();
+
+// Statistics can be disabled by setting MTOA_SCRIPTED_TRANSLATORS_STATS to 0
+bool IsStatsEnabled();
+
+class CStatTimer
+{
+public:
+   
+   CStatTimer(CExportStats &stats, StatPhase phase);
+   ~CStatTimer();
+
+private:
+   
+   CExportStats &m_stats;
+   StatPhase m_phase;
+   double m_start;
+};
+
+// Times the whole export call and merges the translator timings on exit
+class CStatScope
+{
+public:
+   
+   CStatScope(CExportStats &stats, const CScriptedTranslator *translator, const MObject &node);
+   ~CStatScope();
+
+private:
+   
+   CExportStats &m_stats;
+   const CScriptedTranslator *m_translator;
+   MObject m_node;
+   double m_start;
+};
+
+// A summary is written to the arnold log once all translators are gone
+void AddStatsTranslator();
+void RemoveStatsTranslator();
+
+// scriptedTranslatorsStats [-type nodeType] [-node nodeName] [-reset] [-log]
+void RegisterStatsCommand();
+void DeregisterStatsCommand();
+
+#endif